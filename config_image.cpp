@@ -0,0 +1,385 @@
+#include <cstdio>
+#include <cstring>
+
+#include "config_image.hpp"
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace WarGrey::DTPM;
+
+static const char config_image_magic[8] = { 'D', 'T', 'P', 'M', 'C', 'F', 'G', '\0' };
+
+/*************************************************************************************************/
+namespace {
+	static inline bool file_sync(FILE* file) {
+		bool okay = (fflush(file) == 0);
+
+#ifdef _WIN32
+		return okay && (_commit(_fileno(file)) == 0);
+#else
+		return okay && (fsync(fileno(file)) == 0);
+#endif
+	}
+}
+
+/*************************************************************************************************/
+uint64_t WarGrey::DTPM::config_image_checksum(const void* record, size_t size) {
+	const uint8_t* src = reinterpret_cast<const uint8_t*>(record);
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	size_t idx = 0;
+
+	// FNV-1a over 64-bit words (then the tail bytes), records are small, but the checksum should not cost more than mapping them
+	for (; idx + sizeof(uint64_t) <= size; idx += sizeof(uint64_t)) {
+		uint64_t word;
+
+		memcpy(&word, src + idx, sizeof(uint64_t));
+		hash ^= word;
+		hash *= 0x100000001B3ULL;
+	}
+
+	for (; idx < size; idx++) {
+		hash ^= src[idx];
+		hash *= 0x100000001B3ULL;
+	}
+
+	return hash;
+}
+
+bool WarGrey::DTPM::config_image_save(const std::string& path, ConfigKind kind, const void* record, size_t size) {
+	std::string temp = path + ".tmp";
+	FILE* dest = fopen(temp.c_str(), "wb");
+	bool okay = false;
+
+	if (dest != nullptr) {
+		ConfigImageHeader header;
+
+		memcpy(header.magic, config_image_magic, sizeof(header.magic));
+		header.version = config_image_version;
+		header.kind = static_cast<uint32_t>(kind);
+		header.size = size;
+		header.checksum = config_image_checksum(record, size);
+
+		okay = (fwrite(&header, sizeof(header), 1, dest) == 1) && (fwrite(record, size, 1, dest) == 1) && file_sync(dest);
+		okay = ((fclose(dest) == 0) && okay);
+
+		// the image is replaced as a whole, readers never see a half-written one, and a crash leaves either the old or the new one
+		if (okay) {
+			okay = mapped_file_replace(temp, path);
+		}
+
+		if (!okay) {
+			remove(temp.c_str());
+		}
+	}
+
+	return okay;
+}
+
+/*************************************************************************************************/
+ConfigImage::ConfigImage() : payload(nullptr), kind(ConfigKind::Vessel), size(0), view(nullptr), extent(0) {}
+
+ConfigImage::~ConfigImage() noexcept {
+	this->close();
+}
+
+bool ConfigImage::open(const std::string& path) {
+	this->close();
+	this->view = mapped_file_open(path, &this->extent);
+
+	if (this->view != nullptr) {
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(this->view);
+		ConfigImageHeader header;
+		bool okay = false;
+
+		if (this->extent >= sizeof(header)) {
+			memcpy(&header, base, sizeof(header));
+
+			okay = (memcmp(header.magic, config_image_magic, sizeof(header.magic)) == 0)
+				&& (header.version == config_image_version)
+				&& (header.size == this->extent - sizeof(header))
+				&& (header.checksum == config_image_checksum(base + sizeof(header), size_t(header.size)));
+		}
+
+		if (okay) {
+			this->payload = base + sizeof(header);
+			this->kind = static_cast<ConfigKind>(header.kind);
+			this->size = size_t(header.size);
+		} else {
+			this->close();
+		}
+	}
+
+	return (this->payload != nullptr);
+}
+
+void ConfigImage::close() {
+	if (this->view != nullptr) {
+		mapped_file_close(this->view, this->extent);
+	}
+
+	this->payload = nullptr;
+	this->view = nullptr;
+	this->extent = 0;
+	this->size = 0;
+}
+
+/*************************************************************************************************/
+#ifdef CONFIG_IMAGE_MAIN
+#include <chrono>
+#include <string>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+namespace {
+	// stand-ins of the entities, fields are named as the graphlets name them
+	struct Point { double x; double y; };
+	struct Color { uint8_t A; uint8_t R; uint8_t G; uint8_t B; };
+	struct Parameter { double a, f, cm, cs_tx, cs_ty, cs_tz, cs_s, cs_rx, cs_ry, cs_rz, gk_dx, gk_dy, gk_dz, utm_s; };
+
+	struct Vessel {
+		Point gps[2], ps_suction, sb_suction, trunnion, barge;
+		Point body_vertices[7], hopper_vertices[4], bridge_vertices[10];
+	};
+
+	struct GPS { Parameter parameter; };
+	struct Section { double width, min_depth, max_depth, depth_distance, dragheads_distance; };
+	struct Plot { double depths[16]; Color colors[16]; bool enableds[16]; double min_depth, max_depth; };
+
+	struct Track {
+		double depth0, subinterval, partition_distance, after_image_period;
+		long long begin_timepoint, end_timepoint;
+		float track_width;
+		bool visibles[8];
+		bool show_history;
+	};
+
+	void evict(const std::string& path) {
+#ifndef _WIN32
+		int fd = ::open(path.c_str(), O_RDONLY);
+
+		if (fd >= 0) {
+			fdatasync(fd);
+			posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			::close(fd);
+		}
+#endif
+	}
+
+	// what loading a text configuration costs, numbers are read one by one
+	double load_text(const std::string& path, double* dest, size_t count) {
+		FILE* src = fopen(path.c_str(), "r");
+		double sum = 0.0;
+
+		if (src != nullptr) {
+			for (size_t idx = 0; (idx < count) && (fscanf(src, "%lf", &dest[idx]) == 1); idx++) {
+				sum += dest[idx];
+			}
+
+			fclose(src);
+		}
+
+		return sum;
+	}
+
+	template<typename R>
+	double load_image(const std::string& path) {
+		ConfigImage image;
+		double okay = 0.0;
+
+		if (image.open(path) && (image.record<R>() != nullptr)) {
+			okay = 1.0;
+		}
+
+		return okay;
+	}
+}
+
+/**
+ * Converts the five entities into images, checks that they round trip,
+ *   then loads them cold (evicted from the page cache) and warm, and compares with reading the same numbers as text.
+ */
+int main(int argc, char* argv[]) {
+	std::string root = ((argc > 1) ? argv[1] : "/tmp");
+	size_t rounds = ((argc > 2) ? strtoul(argv[2], nullptr, 10) : 20000U);
+	std::string paths[5] = { root + "/vessel.cfg", root + "/gpscs.cfg", root + "/profile.cfg", root + "/plot.cfg", root + "/track.cfg" };
+	std::string text = root + "/vessel.txt";
+	Vessel vessel, vessel_copy;
+	GPS gps, gps_copy;
+	Section section, section_copy;
+	Plot plot, plot_copy;
+	Track track, track_copy;
+	VesselImage vi; GPSCSImage gi; ProfileImage pi; ColorPlotImage ci; DredgeTrackImage ti;
+	double values[54];
+	double cold[2] = { 0.0, 0.0 };
+	double warm[2] = { 0.0, 0.0 };
+	double sink = 0.0;
+
+	{ // entities as the graphlets would have loaded
+		double* vs = reinterpret_cast<double*>(&vessel);
+
+		for (size_t idx = 0; idx < sizeof(vessel) / sizeof(double); idx++) {
+			vs[idx] = double(idx) * 1.25 - 20.0;
+		}
+
+		gps.parameter = { 6378137.0, 298.257223563, 120.0, 1.1, 2.2, 3.3, 4.4, 5.5, 6.6, 7.7, 500000.0, 0.0, 0.0, 0.9996 };
+		section = { 120.0, 8.0, 16.0, 2.0, 3.0 };
+		track = { 10.0, 1.0, 10.0, 24.0, 1700000000LL, 1700604800LL, 2.0F, { true, false, true, true, false, true, true, false }, true };
+
+		for (size_t idx = 0; idx < 16; idx++) {
+			plot.depths[idx] = double(idx);
+			plot.colors[idx] = { 0xFF, uint8_t(idx * 16), uint8_t(255 - idx * 16), uint8_t(idx) };
+			plot.enableds[idx] = ((idx & 1) == 0);
+		}
+
+		plot.min_depth = 0.0;
+		plot.max_depth = 15.0;
+	}
+
+	config_vessel_fill(&vi, &vessel);
+	config_gpscs_fill(&gi, &gps);
+	config_profile_fill(&pi, &section);
+	config_plot_fill(&ci, &plot, 16);
+	config_track_fill(&ti, &track, 8);
+
+	if (!(config_image_save(paths[0], vi) && config_image_save(paths[1], gi) && config_image_save(paths[2], pi)
+		&& config_image_save(paths[3], ci) && config_image_save(paths[4], ti))) {
+		fprintf(stderr, "failed to save images under %s\n", root.c_str());
+		return 1;
+	}
+
+	{ // round trip
+		ConfigImage images[5];
+		bool okay = true;
+
+		for (size_t idx = 0; idx < 5; idx++) {
+			okay = (images[idx].open(paths[idx]) && okay);
+		}
+
+		okay = okay && (images[0].record<GPSCSImage>() == nullptr); // kinds are checked
+
+		if (okay) {
+			config_vessel_restore(&vessel_copy, *images[0].record<VesselImage>());
+			config_gpscs_restore(&gps_copy, *images[1].record<GPSCSImage>());
+			config_profile_restore(&section_copy, *images[2].record<ProfileImage>());
+			config_plot_restore(&plot_copy, *images[3].record<ColorPlotImage>(), 16);
+			config_track_restore(&track_copy, *images[4].record<DredgeTrackImage>(), 8);
+
+			okay = (memcmp(&vessel, &vessel_copy, sizeof(vessel)) == 0)
+				&& (memcmp(&gps, &gps_copy, sizeof(gps)) == 0)
+				&& (memcmp(&section, &section_copy, sizeof(section)) == 0)
+				&& (memcmp(plot.depths, plot_copy.depths, sizeof(plot.depths)) == 0)
+				&& (memcmp(plot.colors, plot_copy.colors, sizeof(plot.colors)) == 0)
+				&& (memcmp(plot.enableds, plot_copy.enableds, sizeof(plot.enableds)) == 0)
+				&& (track.end_timepoint == track_copy.end_timepoint) && (track.visibles[3] == track_copy.visibles[3])
+				&& (track.track_width == track_copy.track_width) && track_copy.show_history;
+		}
+
+		if (!okay) {
+			fprintf(stderr, "images do not round trip\n");
+			return 1;
+		}
+	}
+
+	{ // corrupted images are rejected
+		FILE* dest = fopen(paths[2].c_str(), "r+b");
+		ConfigImage image;
+
+		fseek(dest, long(sizeof(ConfigImageHeader)), SEEK_SET);
+		fputc(0x55, dest);
+		fclose(dest);
+
+		if (image.open(paths[2])) {
+			fprintf(stderr, "a corrupted image is accepted\n");
+			return 1;
+		}
+
+		config_image_save(paths[2], pi);
+	}
+
+	{ // saving over an image still open fails on Win32 and leaves the old one, on POSIX, the open one keeps the old record
+		ProfileImage wider = pi;
+		ConfigImage image;
+		bool saved = false;
+		bool okay = image.open(paths[2]);
+
+		wider.width = pi.width * 2.0;
+		saved = okay && config_image_save(paths[2], wider);
+
+#ifdef _WIN32
+		okay = okay && (!saved) && (image.record<ProfileImage>()->width == pi.width);
+#else
+		okay = okay && saved && (image.record<ProfileImage>()->width == pi.width);
+#endif
+
+		image.close();
+		okay = okay && config_image_save(paths[2], wider) && image.open(paths[2]) && (image.record<ProfileImage>()->width == wider.width);
+		image.close();
+
+		if (!okay) {
+			fprintf(stderr, "replacing an open image does not behave as documented\n");
+			return 1;
+		}
+
+		config_image_save(paths[2], pi);
+	}
+
+	{ // the vessel as text, the largest one
+		FILE* dest = fopen(text.c_str(), "w");
+		const double* vs = reinterpret_cast<const double*>(&vessel);
+
+		for (size_t idx = 0; idx < sizeof(vessel) / sizeof(double); idx++) {
+			fprintf(dest, "%.17g\n", vs[idx]);
+		}
+
+		fclose(dest);
+	}
+
+	for (size_t r = 0; r < rounds; r++) {
+		bool cold_round = ((r % 100) == 0);
+
+		if (cold_round) {
+			evict(paths[0]);
+			evict(text);
+		}
+
+		auto t0 = std::chrono::steady_clock::now();
+		sink += load_image<VesselImage>(paths[0]);
+		auto t1 = std::chrono::steady_clock::now();
+		sink += load_text(text, values, sizeof(vessel) / sizeof(double));
+		auto t2 = std::chrono::steady_clock::now();
+
+		if (cold_round) {
+			cold[0] += std::chrono::duration<double>(t1 - t0).count();
+			cold[1] += std::chrono::duration<double>(t2 - t1).count();
+		} else {
+			warm[0] += std::chrono::duration<double>(t1 - t0).count();
+			warm[1] += std::chrono::duration<double>(t2 - t1).count();
+		}
+	}
+
+	{
+		double ncold = double((rounds + 99) / 100);
+		double nwarm = double(rounds) - ncold;
+
+		printf("vessel configuration, %zu loads (%.0f cold), checksum %g\n", rounds, ncold, sink);
+		printf("  image: cold %8.2f us, warm %8.2f us\n", cold[0] * 1e6 / ncold, warm[0] * 1e6 / nwarm);
+		printf("  text:  cold %8.2f us, warm %8.2f us\n", cold[1] * 1e6 / ncold, warm[1] * 1e6 / nwarm);
+	}
+
+	for (size_t idx = 0; idx < 5; idx++) {
+		remove(paths[idx].c_str());
+	}
+
+	remove(text.c_str());
+
+	return 0;
+}
+#endif
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace WarGrey::DTPM {
+	/**
+	 * Configuration images, the fixed-layout binary form of entities that editors clone from graphlets,
+	 *   one image holds one entity, a header followed by the record as it is in memory,
+	 *   so that loading is mapping the file and checking the header, no parsing at all.
+	 *
+	 * Records only hold plain fields of fixed widths and are padded to 8 bytes,
+	 *   any change of a record should bump `config_image_version`, images of other versions are rejected rather than migrated,
+	 *   the converters below then rebuild them from the entities loaded in the usual way.
+	 *
+	 * Saving writes and syncs a temporary file, then renames it over the image, a crash leaves either the old image or the new one.
+	 *
+	 * NOTE: the gain is in warm loads (about 10us versus 15us for the vessel as text, see `CONFIG_IMAGE_MAIN`),
+	 *   cold loads are bound by reading the page, and mapping costs a page fault and more system calls than `fread()`,
+	 *   so a cold image is no faster than cold text, typically a few microseconds slower.
+	 */
+	static const uint32_t config_image_version = 1U;
+
+	enum class ConfigKind : uint32_t { Vessel = 1, GPSCS, Profile, ColorPlot, DredgeTrack };
+
+	struct ConfigImageHeader {
+		char magic[8];          // "DTPMCFG\0"
+		uint32_t version;
+		uint32_t kind;
+		uint64_t size;          // of the record, in bytes
+		uint64_t checksum;      // of the record, see `config_image_checksum()`
+	};
+
+	struct ConfigPoint {
+		double x;
+		double y;
+	};
+
+	struct VesselImage {
+		static const WarGrey::DTPM::ConfigKind kind = WarGrey::DTPM::ConfigKind::Vessel;
+
+		WarGrey::DTPM::ConfigPoint gps[2];
+		WarGrey::DTPM::ConfigPoint ps_suction;
+		WarGrey::DTPM::ConfigPoint sb_suction;
+		WarGrey::DTPM::ConfigPoint trunnion;
+		WarGrey::DTPM::ConfigPoint barge;
+		WarGrey::DTPM::ConfigPoint body_vertices[7];
+		WarGrey::DTPM::ConfigPoint hopper_vertices[4];
+		WarGrey::DTPM::ConfigPoint bridge_vertices[10];
+	};
+
+	struct GPSCSImage {
+		static const WarGrey::DTPM::ConfigKind kind = WarGrey::DTPM::ConfigKind::GPSCS;
+
+		double a, f, cm;
+		double cs_tx, cs_ty, cs_tz, cs_s, cs_rx, cs_ry, cs_rz;
+		double gk_dx, gk_dy, gk_dz, utm_s;
+	};
+
+	struct ProfileImage {
+		static const WarGrey::DTPM::ConfigKind kind = WarGrey::DTPM::ConfigKind::Profile;
+
+		double width;
+		double min_depth;
+		double max_depth;
+		double depth_distance;
+		double dragheads_distance;
+	};
+
+	struct ColorPlotImage {
+		static const WarGrey::DTPM::ConfigKind kind = WarGrey::DTPM::ConfigKind::ColorPlot;
+		static const size_t capacity = 32;
+
+		double depths[capacity];
+		uint32_t colors[capacity];  // 0xAARRGGBB
+		uint32_t enableds;          // bits
+		uint32_t count;
+		double min_depth;
+		double max_depth;
+	};
+
+	struct DredgeTrackImage {
+		static const WarGrey::DTPM::ConfigKind kind = WarGrey::DTPM::ConfigKind::DredgeTrack;
+
+		double depth0;
+		double subinterval;
+		double partition_distance;
+		double after_image_period;
+		int64_t begin_timepoint;
+		int64_t end_timepoint;
+		float track_width;
+		uint32_t visibles;          // bits, indexed by `DredgeTrackType`
+		uint32_t show_history;
+		uint32_t reserved;
+	};
+
+	uint64_t config_image_checksum(const void* record, size_t size);
+
+	/**
+	 * Replaces the image as a whole, see `mapped_file_replace()`,
+	 *   close `ConfigImage`s of the same path first, Win32 refuses to replace a file while it is mapped.
+	 */
+	bool config_image_save(const std::string& path, WarGrey::DTPM::ConfigKind kind, const void* record, size_t size);
+
+	template<typename R>
+	bool config_image_save(const std::string& path, const R& record) {
+		return WarGrey::DTPM::config_image_save(path, R::kind, &record, sizeof(R));
+	}
+
+	/**
+	 * The image mapped read-only, records are valid until the image is closed or destructed,
+	 *   `open()` fails if the file is not an image of this version, or is truncated, or does not match its checksum.
+	 */
+	class ConfigImage {
+	public:
+		virtual ~ConfigImage() noexcept;
+		ConfigImage();
+
+	public:
+		bool open(const std::string& path);
+		void close();
+
+	public:
+		template<typename R>
+		const R* record() const {
+			const R* r = nullptr;
+
+			if ((this->payload != nullptr) && (this->kind == R::kind) && (this->size == sizeof(R))) {
+				r = reinterpret_cast<const R*>(this->payload);
+			}
+
+			return r;
+		}
+
+	private:
+		const uint8_t* payload;
+		WarGrey::DTPM::ConfigKind kind;
+		size_t size;
+
+	private:
+		void* view;
+		size_t extent;
+	};
+
+	/**
+	 * Converters, they work for whatever holds fields of the same names,
+	 *   say, `TrailingSuctionDredger^`, `GPSCS^`, `Profile^`, `ColorPlot^` and `DredgeTrack^`.
+	 */
+	template<typename V>
+	void config_vessel_fill(WarGrey::DTPM::VesselImage* image, V vessel) {
+		auto point = [](WarGrey::DTPM::ConfigPoint* p, const auto& v) { p->x = v.x; p->y = v.y; };
+
+		point(&image->gps[0], vessel->gps[0]);
+		point(&image->gps[1], vessel->gps[1]);
+		point(&image->ps_suction, vessel->ps_suction);
+		point(&image->sb_suction, vessel->sb_suction);
+		point(&image->trunnion, vessel->trunnion);
+		point(&image->barge, vessel->barge);
+
+		for (size_t idx = 0; idx < sizeof(image->body_vertices) / sizeof(WarGrey::DTPM::ConfigPoint); idx++) {
+			point(&image->body_vertices[idx], vessel->body_vertices[idx]);
+		}
+
+		for (size_t idx = 0; idx < sizeof(image->hopper_vertices) / sizeof(WarGrey::DTPM::ConfigPoint); idx++) {
+			point(&image->hopper_vertices[idx], vessel->hopper_vertices[idx]);
+		}
+
+		for (size_t idx = 0; idx < sizeof(image->bridge_vertices) / sizeof(WarGrey::DTPM::ConfigPoint); idx++) {
+			point(&image->bridge_vertices[idx], vessel->bridge_vertices[idx]);
+		}
+	}
+
+	template<typename V>
+	void config_vessel_restore(V vessel, const WarGrey::DTPM::VesselImage& image) {
+		auto point = [](auto& v, const WarGrey::DTPM::ConfigPoint& p) { v.x = p.x; v.y = p.y; };
+
+		point(vessel->gps[0], image.gps[0]);
+		point(vessel->gps[1], image.gps[1]);
+		point(vessel->ps_suction, image.ps_suction);
+		point(vessel->sb_suction, image.sb_suction);
+		point(vessel->trunnion, image.trunnion);
+		point(vessel->barge, image.barge);
+
+		for (size_t idx = 0; idx < sizeof(image.body_vertices) / sizeof(WarGrey::DTPM::ConfigPoint); idx++) {
+			point(vessel->body_vertices[idx], image.body_vertices[idx]);
+		}
+
+		for (size_t idx = 0; idx < sizeof(image.hopper_vertices) / sizeof(WarGrey::DTPM::ConfigPoint); idx++) {
+			point(vessel->hopper_vertices[idx], image.hopper_vertices[idx]);
+		}
+
+		for (size_t idx = 0; idx < sizeof(image.bridge_vertices) / sizeof(WarGrey::DTPM::ConfigPoint); idx++) {
+			point(vessel->bridge_vertices[idx], image.bridge_vertices[idx]);
+		}
+	}
+
+	template<typename G>
+	void config_gpscs_fill(WarGrey::DTPM::GPSCSImage* image, G gps) {
+		image->a = gps->parameter.a;
+		image->f = gps->parameter.f;
+		image->cm = gps->parameter.cm;
+		image->cs_tx = gps->parameter.cs_tx;
+		image->cs_ty = gps->parameter.cs_ty;
+		image->cs_tz = gps->parameter.cs_tz;
+		image->cs_s = gps->parameter.cs_s;
+		image->cs_rx = gps->parameter.cs_rx;
+		image->cs_ry = gps->parameter.cs_ry;
+		image->cs_rz = gps->parameter.cs_rz;
+		image->gk_dx = gps->parameter.gk_dx;
+		image->gk_dy = gps->parameter.gk_dy;
+		image->gk_dz = gps->parameter.gk_dz;
+		image->utm_s = gps->parameter.utm_s;
+	}
+
+	template<typename G>
+	void config_gpscs_restore(G gps, const WarGrey::DTPM::GPSCSImage& image) {
+		gps->parameter.a = image.a;
+		gps->parameter.f = image.f;
+		gps->parameter.cm = image.cm;
+		gps->parameter.cs_tx = image.cs_tx;
+		gps->parameter.cs_ty = image.cs_ty;
+		gps->parameter.cs_tz = image.cs_tz;
+		gps->parameter.cs_s = image.cs_s;
+		gps->parameter.cs_rx = image.cs_rx;
+		gps->parameter.cs_ry = image.cs_ry;
+		gps->parameter.cs_rz = image.cs_rz;
+		gps->parameter.gk_dx = image.gk_dx;
+		gps->parameter.gk_dy = image.gk_dy;
+		gps->parameter.gk_dz = image.gk_dz;
+		gps->parameter.utm_s = image.utm_s;
+	}
+
+	template<typename P>
+	void config_profile_fill(WarGrey::DTPM::ProfileImage* image, P profile) {
+		image->width = profile->width;
+		image->min_depth = profile->min_depth;
+		image->max_depth = profile->max_depth;
+		image->depth_distance = profile->depth_distance;
+		image->dragheads_distance = profile->dragheads_distance;
+	}
+
+	template<typename P>
+	void config_profile_restore(P profile, const WarGrey::DTPM::ProfileImage& image) {
+		profile->width = image.width;
+		profile->min_depth = image.min_depth;
+		profile->max_depth = image.max_depth;
+		profile->depth_distance = image.depth_distance;
+		profile->dragheads_distance = image.dragheads_distance;
+	}
+
+	/**
+	 * `count` is `ColorPlotSize`, colors are those having `A`, `R`, `G` and `B` bytes, say, `Windows::UI::Color`.
+	 */
+	template<typename P>
+	void config_plot_fill(WarGrey::DTPM::ColorPlotImage* image, P plot, size_t count) {
+		image->count = uint32_t((count < WarGrey::DTPM::ColorPlotImage::capacity) ? count : WarGrey::DTPM::ColorPlotImage::capacity);
+		image->enableds = 0U;
+
+		for (uint32_t idx = 0; idx < WarGrey::DTPM::ColorPlotImage::capacity; idx++) {
+			if (idx < image->count) {
+				auto c = plot->colors[idx];
+
+				image->depths[idx] = plot->depths[idx];
+				image->colors[idx] = (uint32_t(c.A) << 24U) | (uint32_t(c.R) << 16U) | (uint32_t(c.G) << 8U) | uint32_t(c.B);
+				image->enableds |= (plot->enableds[idx] ? (1U << idx) : 0U);
+			} else {
+				image->depths[idx] = 0.0;
+				image->colors[idx] = 0U;
+			}
+		}
+
+		image->min_depth = plot->min_depth;
+		image->max_depth = plot->max_depth;
+	}
+
+	template<typename P>
+	void config_plot_restore(P plot, const WarGrey::DTPM::ColorPlotImage& image, size_t count) {
+		for (uint32_t idx = 0; (idx < image.count) && (idx < count); idx++) {
+			auto& c = plot->colors[idx];
+
+			plot->depths[idx] = image.depths[idx];
+			c.A = uint8_t(image.colors[idx] >> 24U);
+			c.R = uint8_t(image.colors[idx] >> 16U);
+			c.G = uint8_t(image.colors[idx] >> 8U);
+			c.B = uint8_t(image.colors[idx]);
+			plot->enableds[idx] = ((image.enableds & (1U << idx)) != 0U);
+		}
+
+		plot->min_depth = image.min_depth;
+		plot->max_depth = image.max_depth;
+	}
+
+	/**
+	 * `type_count` is `_I(DredgeTrackType::_)`.
+	 */
+	template<typename T>
+	void config_track_fill(WarGrey::DTPM::DredgeTrackImage* image, T track, size_t type_count) {
+		image->depth0 = track->depth0;
+		image->subinterval = track->subinterval;
+		image->partition_distance = track->partition_distance;
+		image->after_image_period = track->after_image_period;
+		image->begin_timepoint = track->begin_timepoint;
+		image->end_timepoint = track->end_timepoint;
+		image->track_width = track->track_width;
+		image->show_history = (track->show_history ? 1U : 0U);
+		image->visibles = 0U;
+		image->reserved = 0U;
+
+		for (size_t idx = 0; (idx < type_count) && (idx < 32); idx++) {
+			image->visibles |= (track->visibles[idx] ? (1U << idx) : 0U);
+		}
+	}
+
+	template<typename T>
+	void config_track_restore(T track, const WarGrey::DTPM::DredgeTrackImage& image, size_t type_count) {
+		track->depth0 = image.depth0;
+		track->subinterval = image.subinterval;
+		track->partition_distance = image.partition_distance;
+		track->after_image_period = image.after_image_period;
+		track->begin_timepoint = image.begin_timepoint;
+		track->end_timepoint = image.end_timepoint;
+		track->track_width = image.track_width;
+		track->show_history = (image.show_history != 0U);
+
+		for (size_t idx = 0; (idx < type_count) && (idx < 32); idx++) {
+			track->visibles[idx] = ((image.visibles & (1U << idx)) != 0U);
+		}
+	}
+}
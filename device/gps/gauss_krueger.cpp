@@ -0,0 +1,473 @@
+#include "fp_contract.hpp"
+
+#include <cmath>
+
+#include "device/gps/gauss_krueger.hpp"
+#include "simd_dispatch.hpp"
+
+#if defined(SIMD_AVX2)
+#define GK_SIMD_AVX2
+#elif defined(_M_ARM64)
+#include <arm64_neon.h>
+#define GK_SIMD_NEON
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define GK_SIMD_NEON
+#endif
+
+using namespace WarGrey::SCADA;
+using namespace WarGrey::DTPM;
+
+static const double wgs84_a = 6378137.0;
+static const double wgs84_f = 1.0 / 298.257223563;
+static const double wgs84_e2 = wgs84_f * (2.0 - wgs84_f);
+static const double wgs84_b = wgs84_a * (1.0 - wgs84_f);
+static const double wgs84_ep2 = wgs84_e2 / (1.0 - wgs84_e2);
+
+static const double pi = 3.14159265358979323846;
+static const double radians_per_degree = pi / 180.0;
+static const double nmea_minute_resolution = 1e-4; // the editor displays `ddmm.mmmm`, as GPS reports
+
+/*************************************************************************************************/
+namespace {
+	inline double lsqrt(double x) { return sqrt(x); }
+	inline double lfloor(double x) { return floor(x); }
+	inline double lfabs(double x) { return fabs(x); }
+	inline double lcopysign(double x, double s) { return copysign(x, s); }
+	inline double lsin(double x) { return sin(x); }
+	inline double lcos(double x) { return cos(x); }
+	inline double latan2(double y, double x) { return atan2(y, x); }
+
+#if defined(GK_SIMD_AVX2)
+	struct lane {
+		static const size_t N = 4;
+
+		lane() {}
+		lane(double s) : v(_mm256_set1_pd(s)) {}
+		lane(__m256d v) : v(v) {}
+
+		__m256d v;
+	};
+
+	inline lane operator+(lane a, lane b) { return _mm256_add_pd(a.v, b.v); }
+	inline lane operator-(lane a, lane b) { return _mm256_sub_pd(a.v, b.v); }
+	inline lane operator*(lane a, lane b) { return _mm256_mul_pd(a.v, b.v); }
+	inline lane operator/(lane a, lane b) { return _mm256_div_pd(a.v, b.v); }
+	inline lane lsqrt(lane x) { return _mm256_sqrt_pd(x.v); }
+	inline lane lfloor(lane x) { return _mm256_floor_pd(x.v); }
+	inline lane lfabs(lane x) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x.v); }
+	inline lane lcopysign(lane x, lane s) { return _mm256_or_pd(lfabs(x).v, _mm256_and_pd(_mm256_set1_pd(-0.0), s.v)); }
+	inline lane lload(const double* src) { return _mm256_loadu_pd(src); }
+	inline void lstore(double* dest, lane x) { _mm256_storeu_pd(dest, x.v); }
+#elif defined(GK_SIMD_NEON)
+	struct lane {
+		static const size_t N = 2;
+
+		lane() {}
+		lane(double s) : v(vdupq_n_f64(s)) {}
+		lane(float64x2_t v) : v(v) {}
+
+		float64x2_t v;
+	};
+
+	inline lane operator+(lane a, lane b) { return vaddq_f64(a.v, b.v); }
+	inline lane operator-(lane a, lane b) { return vsubq_f64(a.v, b.v); }
+	inline lane operator*(lane a, lane b) { return vmulq_f64(a.v, b.v); }
+	inline lane operator/(lane a, lane b) { return vdivq_f64(a.v, b.v); }
+	inline lane lsqrt(lane x) { return vsqrtq_f64(x.v); }
+	inline lane lfloor(lane x) { return vrndmq_f64(x.v); }
+	inline lane lfabs(lane x) { return vabsq_f64(x.v); }
+	inline lane lcopysign(lane x, lane s) { return vbslq_f64(vdupq_n_u64(0x8000000000000000ULL), s.v, x.v); }
+	inline lane lload(const double* src) { return vld1q_f64(src); }
+	inline void lstore(double* dest, lane x) { vst1q_f64(dest, x.v); }
+#endif
+
+#if defined(GK_SIMD_AVX2) || defined(GK_SIMD_NEON)
+	/**
+	 * There are no vectorized transcendental functions in either instruction set,
+	 *  the lanes go through the same libm routines as the scalar kernel does.
+	 */
+	inline lane lsin(lane x) {
+		double xs[lane::N];
+
+		lstore(xs, x);
+		for (size_t i = 0; i < lane::N; i++) xs[i] = sin(xs[i]);
+
+		return lload(xs);
+	}
+
+	inline lane lcos(lane x) {
+		double xs[lane::N];
+
+		lstore(xs, x);
+		for (size_t i = 0; i < lane::N; i++) xs[i] = cos(xs[i]);
+
+		return lload(xs);
+	}
+
+	inline lane latan2(lane y, lane x) {
+		double ys[lane::N];
+		double xs[lane::N];
+
+		lstore(ys, y);
+		lstore(xs, x);
+		for (size_t i = 0; i < lane::N; i++) ys[i] = atan2(ys[i], xs[i]);
+
+		return lload(ys);
+	}
+#endif
+
+	/*********************************************************************************************/
+	template<typename V>
+	inline V nmea_to_radians(V ddmm) {
+		V a = lfabs(ddmm); // southern and western fixes are negative
+		V d = lfloor(a / V(100.0));
+
+		return lcopysign((d + (a - d * V(100.0)) / V(60.0)) * V(radians_per_degree), ddmm);
+	}
+
+	/**
+	 * `E` provides the local ellipsoid, either the context itself or one of `StaticEllipsoid`s,
+	 *   the datum shift and the projection always come from the context.
+	 */
+	template<typename V, typename E>
+	void gk_forward(const GCSContext& c, const E& e, V B, V L, V H, V* x, V* y, V* z) {
+		V X, Y, Z, sinB, cosB, sinL, cosL, N, l;
+
+		B = nmea_to_radians(B);
+		L = nmea_to_radians(L);
+		sinB = lsin(B);
+		cosB = lcos(B);
+		sinL = lsin(L);
+		cosL = lcos(L);
+
+		{ // WGS84 geodetic coordinates => ECEF
+			V N84 = V(wgs84_a) / lsqrt(V(1.0) - V(wgs84_e2) * sinB * sinB);
+			V r = (N84 + H) * cosB;
+			V x84 = r * cosL;
+			V y84 = r * sinL;
+			V z84 = (N84 * V(1.0 - wgs84_e2) + H) * sinB;
+
+			X = V(c.t[0]) + V(c.m[0]) * x84 + V(c.m[1]) * y84 + V(c.m[2]) * z84;
+			Y = V(c.t[1]) + V(c.m[3]) * x84 + V(c.m[4]) * y84 + V(c.m[5]) * z84;
+			Z = V(c.t[2]) + V(c.m[6]) * x84 + V(c.m[7]) * y84 + V(c.m[8]) * z84;
+		}
+
+		{ // ECEF => local geodetic coordinates (Bowring), the longitude is relative to the central meridian
+			V p = lsqrt(X * X + Y * Y);
+			V u = Z * V(e.a);
+			V w = p * V(e.b);
+			V q = lsqrt(u * u + w * w);
+			V st = u / q;
+			V ct = w / q;
+			V num = Z + V(e.ep2 * e.b) * st * st * st;
+			V den = p - V(e.e2 * e.a) * ct * ct * ct;
+			V r = lsqrt(num * num + den * den);
+
+			sinB = num / r;
+			cosB = den / r;
+			B = latan2(num, den);
+			N = V(e.a) / lsqrt(V(1.0) - V(e.e2) * sinB * sinB);
+			H = p / cosB - N;
+			l = latan2(Y * V(c.cosL0) - X * V(c.sinL0), X * V(c.cosL0) + Y * V(c.sinL0));
+		}
+
+		{ // Gauss-Krüger projection
+			V t = sinB / cosB;
+			V t2 = t * t;
+			V c2 = cosB * cosB;
+			V eta2 = V(e.ep2) * c2;
+			V lc2 = l * l * c2;
+			V sin2B = V(2.0) * sinB * cosB;
+			V cos2B = V(1.0) - V(2.0) * sinB * sinB;
+			V sin4B = V(2.0) * sin2B * cos2B;
+			V cos4B = V(1.0) - V(2.0) * sin2B * sin2B;
+			V sin6B = sin4B * cos2B + cos4B * sin2B;
+			V sin8B = V(2.0) * sin4B * cos4B;
+			V X0 = V(e.arc[0]) * B + V(e.arc[1]) * sin2B + V(e.arc[2]) * sin4B + V(e.arc[3]) * sin6B + V(e.arc[4]) * sin8B;
+			V x4 = (V(5.0) - t2 + V(9.0) * eta2 + V(4.0) * eta2 * eta2) / V(24.0);
+			V x6 = (V(61.0) - V(58.0) * t2 + t2 * t2) / V(720.0);
+			V y3 = (V(1.0) - t2 + eta2) / V(6.0);
+			V y5 = (V(5.0) - V(18.0) * t2 + t2 * t2 + V(14.0) * eta2 - V(58.0) * eta2 * t2) / V(120.0);
+			V gx = X0 + N * t * lc2 * (V(0.5) + lc2 * (x4 + lc2 * x6));
+			V gy = N * l * cosB * (V(1.0) + lc2 * (y3 + lc2 * y5));
+
+			(*x) = V(c.k0) * gx + V(c.dx);
+			(*y) = V(c.k0) * gy + V(c.dy);
+			(*z) = H + V(c.dz);
+		}
+	}
+
+	/*********************************************************************************************/
+	static double radians_to_nmea(double rad) {
+		double deg = fabs(rad / radians_per_degree);
+		double d = floor(deg);
+		double minutes = (deg - d) * 60.0;
+		double ddmm;
+
+		// minutes rounding up to 60 carry into degrees, whole degrees would otherwise come back as `xx59.9999999`, displayed as `xx60.0000`
+		if (minutes >= 60.0 - nmea_minute_resolution * 0.5) {
+			d += 1.0;
+			minutes = 0.0;
+		}
+
+		ddmm = d * 100.0 + minutes;
+
+		return ((rad < 0.0) ? -ddmm : ddmm);
+	}
+
+	template<typename E>
+	static double3 gk_inverse(const GCSContext& c, const E& e, double x, double y, double z, GCSAccuracy tier) {
+		double gx = (x - c.dx) / c.k0;
+		double gy = (y - c.dy) / c.k0;
+		double H = z - c.dz;
+		double mu = gx / e.arc[0];
+		double B, L, X, Y, Z, Bf;
+
+		switch (tier) {
+		case GCSAccuracy::Exact: { // iterate the meridian arc to convergence
+			Bf = mu;
+
+			for (int i = 0; i < 32; i++) {
+				double Bn = (gx - e.arc[1] * sin(2.0 * Bf) - e.arc[2] * sin(4.0 * Bf) - e.arc[3] * sin(6.0 * Bf) - e.arc[4] * sin(8.0 * Bf)) / e.arc[0];
+				bool converged = (fabs(Bn - Bf) < 1e-14);
+
+				Bf = Bn;
+
+				if (converged) {
+					break;
+				}
+			}
+		}; break;
+		default: { // the rectifying latitude series, the same double-angle trick as the forward kernel
+			double s2 = sin(2.0 * mu);
+			double c2 = cos(2.0 * mu);
+			double s4 = 2.0 * s2 * c2;
+			double c4 = 1.0 - 2.0 * s2 * s2;
+
+			Bf = mu + e.footpoint[0] * s2 + e.footpoint[1] * s4 + e.footpoint[2] * (s4 * c2 + c4 * s2) + e.footpoint[3] * (2.0 * s4 * c4);
+		}
+		}
+
+		{ // inverse Gauss-Krüger projection
+			double sinBf = sin(Bf);
+			double cosBf = cos(Bf);
+			double tf = sinBf / cosBf;
+			double tf2 = tf * tf;
+			double etaf2 = e.ep2 * cosBf * cosBf;
+			double W2 = 1.0 - e.e2 * sinBf * sinBf;
+			double Nf = e.a / sqrt(W2);
+			double Mf = e.a * (1.0 - e.e2) / (W2 * sqrt(W2));
+			double D = gy / Nf;
+			double D2 = D * D;
+			double b4 = (5.0 + 3.0 * tf2 + etaf2 - 9.0 * etaf2 * tf2) / 24.0;
+			double l3 = (1.0 + 2.0 * tf2 + etaf2) / 6.0;
+			double b6 = (61.0 + 90.0 * tf2 + 45.0 * tf2 * tf2) / 720.0;
+			double l5 = (5.0 + 28.0 * tf2 + 24.0 * tf2 * tf2 + 6.0 * etaf2 + 8.0 * etaf2 * tf2) / 120.0;
+
+			B = Bf - tf * Nf / Mf * D2 * (0.5 - D2 * (b4 - D2 * b6));
+			L = c.L0 + D * (1.0 - D2 * (l3 - D2 * l5)) / cosBf;
+		}
+
+		{ // local geodetic coordinates => ECEF => WGS84 ECEF
+			double sinB = sin(B);
+			double N = e.a / sqrt(1.0 - e.e2 * sinB * sinB);
+			double r = (N + H) * cos(B);
+			double x0 = r * cos(L) - c.t[0];
+			double y0 = r * sin(L) - c.t[1];
+			double z0 = (N * (1.0 - e.e2) + H) * sinB - c.t[2];
+
+			X = c.minv[0] * x0 + c.minv[1] * y0 + c.minv[2] * z0;
+			Y = c.minv[3] * x0 + c.minv[4] * y0 + c.minv[5] * z0;
+			Z = c.minv[6] * x0 + c.minv[7] * y0 + c.minv[8] * z0;
+		}
+
+		{ // WGS84 ECEF => WGS84 geodetic coordinates
+			double p = sqrt(X * X + Y * Y);
+
+			L = atan2(Y, X);
+
+			if (tier == GCSAccuracy::Exact) { // iterate the latitude to convergence
+				B = atan2(Z, p * (1.0 - wgs84_e2));
+
+				for (int i = 0; i < 32; i++) {
+					double sinB = sin(B);
+					double N = wgs84_a / sqrt(1.0 - wgs84_e2 * sinB * sinB);
+					double Bn;
+
+					H = p / cos(B) - N;
+					Bn = atan2(Z, p * (1.0 - wgs84_e2 * N / (N + H)));
+
+					if (fabs(Bn - B) < 1e-14) {
+						B = Bn;
+						break;
+					}
+
+					B = Bn;
+				}
+			} else { // Bowring
+				double u = Z * wgs84_a;
+				double w = p * wgs84_b;
+				double q = sqrt(u * u + w * w);
+				double st = u / q;
+				double ct = w / q;
+				double num = Z + wgs84_ep2 * wgs84_b * st * st * st;
+				double den = p - wgs84_e2 * wgs84_a * ct * ct * ct;
+				double r = sqrt(num * num + den * den);
+				double sinB = num / r;
+				double cosB = den / r;
+
+				B = atan2(num, den);
+				H = p / cosB - wgs84_a / sqrt(1.0 - wgs84_e2 * sinB * sinB);
+			}
+		}
+
+		return double3(radians_to_nmea(B), radians_to_nmea(L), H);
+	}
+
+	/*********************************************************************************************/
+	template<GCSDatum D>
+	struct StaticEllipsoid {
+		static constexpr GCSEllipsoid ellipsoid = gcs_ellipsoid(GCSDatumEllipsoid<D>::a, GCSDatumEllipsoid<D>::f);
+
+		static constexpr double a = ellipsoid.a;
+		static constexpr double b = ellipsoid.b;
+		static constexpr double e2 = ellipsoid.e2;
+		static constexpr double ep2 = ellipsoid.ep2;
+		static constexpr double arc[5] = { ellipsoid.arc[0], ellipsoid.arc[1], ellipsoid.arc[2], ellipsoid.arc[3], ellipsoid.arc[4] };
+		static constexpr double footpoint[4] = { ellipsoid.footpoint[0], ellipsoid.footpoint[1], ellipsoid.footpoint[2], ellipsoid.footpoint[3] };
+	};
+
+	template<typename E>
+	void gk_forward_batch(const GCSContext& c, const E& e, const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count) {
+		size_t i = 0;
+
+#if defined(GK_SIMD_AVX2)
+		if (simd_avx2_supported()) {
+			for (; i + lane::N <= count; i += lane::N) {
+				lane x, y, z;
+
+				gk_forward(c, e, lload(Bs + i), lload(Ls + i), lload(Hs + i), &x, &y, &z);
+				lstore(xs + i, x);
+				lstore(ys + i, y);
+				lstore(zs + i, z);
+			}
+
+			_mm256_zeroupper(); // the rest may be legacy SSE code, if the build does not target AVX
+		}
+#elif defined(GK_SIMD_NEON)
+		for (; i + lane::N <= count; i += lane::N) {
+			lane x, y, z;
+
+			gk_forward(c, e, lload(Bs + i), lload(Ls + i), lload(Hs + i), &x, &y, &z);
+			lstore(xs + i, x);
+			lstore(ys + i, y);
+			lstore(zs + i, z);
+		}
+#endif
+
+		for (; i < count; i++) {
+			gk_forward(c, e, Bs[i], Ls[i], Hs[i], xs + i, ys + i, zs + i);
+		}
+	}
+
+	template<typename E>
+	void gk_forward_scalar(const GCSContext& c, const E& e, const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			gk_forward(c, e, Bs[i], Ls[i], Hs[i], xs + i, ys + i, zs + i);
+		}
+	}
+
+	template<typename E>
+	void gk_inverse_batch(const GCSContext& c, const E& e, const double* xs, const double* ys, const double* zs, double* Bs, double* Ls, double* Hs, size_t count, GCSAccuracy tier) {
+		for (size_t i = 0; i < count; i++) {
+			double3 blh = gk_inverse(c, e, xs[i], ys[i], zs[i], tier);
+
+			Bs[i] = blh.x;
+			Ls[i] = blh.y;
+			Hs[i] = blh.z;
+		}
+	}
+
+	/**
+	 * Picks the kernel specialized for the datum of the context, or the generic one.
+	 */
+#define GK_DISPATCH(c, kernel, ...) \
+	switch (c.datum) { \
+	case GCSDatum::WGS84: kernel(c, StaticEllipsoid<GCSDatum::WGS84>(), __VA_ARGS__); break; \
+	case GCSDatum::CGCS2000: kernel(c, StaticEllipsoid<GCSDatum::CGCS2000>(), __VA_ARGS__); break; \
+	case GCSDatum::Beijing54: kernel(c, StaticEllipsoid<GCSDatum::Beijing54>(), __VA_ARGS__); break; \
+	case GCSDatum::Xian80: kernel(c, StaticEllipsoid<GCSDatum::Xian80>(), __VA_ARGS__); break; \
+	default: kernel(c, c, __VA_ARGS__); \
+	}
+}
+
+/*************************************************************************************************/
+double3 WarGrey::DTPM::gauss_krueger_forward(double latitude, double longitude, double altitude, const GCSContext& gcs) {
+	double x, y, z;
+
+	GK_DISPATCH(gcs, gk_forward, latitude, longitude, altitude, &x, &y, &z);
+
+	return double3(x, y, z);
+}
+
+double3 WarGrey::DTPM::gauss_krueger_inverse(double x, double y, double z, const GCSContext& gcs, GCSAccuracy tier) {
+	double B, L, H;
+
+	GK_DISPATCH(gcs, gk_inverse_batch, &x, &y, &z, &B, &L, &H, 1, tier);
+
+	return double3(B, L, H);
+}
+
+void WarGrey::DTPM::gauss_krueger_forward(const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count, const GCSContext& gcs) {
+	GK_DISPATCH(gcs, gk_forward_batch, Bs, Ls, Hs, xs, ys, zs, count);
+}
+
+void WarGrey::DTPM::gauss_krueger_forward_scalar(const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count, const GCSContext& gcs) {
+	GK_DISPATCH(gcs, gk_forward_scalar, Bs, Ls, Hs, xs, ys, zs, count);
+}
+
+void WarGrey::DTPM::gauss_krueger_inverse(const double* xs, const double* ys, const double* zs, double* Bs, double* Ls, double* Hs, size_t count, const GCSContext& gcs, GCSAccuracy tier) {
+	GK_DISPATCH(gcs, gk_inverse_batch, xs, ys, zs, Bs, Ls, Hs, count, tier);
+}
+
+/*************************************************************************************************/
+double3 WarGrey::DTPM::gauss_krueger_forward(double latitude, double longitude, double altitude, const GCSParameter& gcs) {
+	return gauss_krueger_forward(latitude, longitude, altitude, *gcs_compile(gcs));
+}
+
+double3 WarGrey::DTPM::gauss_krueger_inverse(double x, double y, double z, const GCSParameter& gcs, GCSAccuracy tier) {
+	return gauss_krueger_inverse(x, y, z, *gcs_compile(gcs), tier);
+}
+
+void WarGrey::DTPM::gauss_krueger_forward(const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count, const GCSParameter& gcs) {
+	gauss_krueger_forward(Bs, Ls, Hs, xs, ys, zs, count, *gcs_compile(gcs));
+}
+
+void WarGrey::DTPM::gauss_krueger_forward_scalar(const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count, const GCSParameter& gcs) {
+	gauss_krueger_forward_scalar(Bs, Ls, Hs, xs, ys, zs, count, *gcs_compile(gcs));
+}
+
+void WarGrey::DTPM::gauss_krueger_inverse(const double* xs, const double* ys, const double* zs, double* Bs, double* Ls, double* Hs, size_t count, const GCSParameter& gcs, GCSAccuracy tier) {
+	gauss_krueger_inverse(xs, ys, zs, Bs, Ls, Hs, count, *gcs_compile(gcs), tier);
+}
+
+const char* WarGrey::DTPM::gauss_krueger_simd_name() {
+#if defined(GK_SIMD_AVX2)
+	return (simd_avx2_supported() ? "AVX2" : "scalar");
+#elif defined(GK_SIMD_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
+
+size_t WarGrey::DTPM::gauss_krueger_simd_lanes() {
+#if defined(GK_SIMD_AVX2)
+	return (simd_avx2_supported() ? lane::N : 1U);
+#elif defined(GK_SIMD_NEON)
+	return lane::N;
+#else
+	return 1;
+#endif
+}
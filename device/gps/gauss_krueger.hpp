@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+
+#include "device/gps/gcs_context.hpp"
+
+namespace WarGrey::DTPM {
+	/**
+	 * Accuracy tiers of the inverse projection, the errors are of the round trip near the border of a zone
+	 *   Survey: closed-form footpoint latitude, the full series and Bowring's latitude and height, within 0.4mm;
+	 *   Exact:  iterates the footpoint latitude and the geodetic latitude to convergence, about 4 times as slow as `Survey`.
+	 *
+	 * NOTE: there is no tier cheaper than `Survey`, truncating the series saves a few multiplications,
+	 *   the cost is in the transcendental functions, which every tier has to call.
+	 */
+	enum class GCSAccuracy { Survey, Exact };
+
+	/**
+	 * Gauss-Krüger projection of WGS84 fixes onto the local coordinate system described by `GCSParameter`
+	 *   latitude and longitude are NMEA-styled `ddmm.mmmm`, the same as what GPS reports and what the editor displays,
+	 *   the inverse carries minutes that would be displayed as `60.0000` into degrees, snapping them by up to 0.00005' (9cm);
+	 *   `f` is the inverse flattening, `cm` is the central meridian in degrees;
+	 *   the datum shift is the Bursa-Wolf transformation, `cs_s` in ppm and `cs_rx`, `cs_ry`, `cs_rz` in arc seconds;
+	 *   `gk_dx`, `gk_dy` and `gk_dz` are the false northing, the false easting and the height offset;
+	 *   `utm_s` is the scale factor along the central meridian (1.0 for Gauss-Krüger, 0.9996 for UTM).
+	 *
+	 * The batch versions take structure-of-arrays and run the SIMD kernel whenever the CPU supports it (see `simd_dispatch.hpp`),
+	 *   the scalar version shares the same sequence of floating-point operations, hence results are bit-identical;
+	 *   `gauss_krueger_simd_name()` tells which kernel the running CPU gets.
+	 *
+	 * The `GCSParameter` versions look up the shared context table on each call,
+	 *   the hot paths should compile the context once and hold it.
+	 */
+	WarGrey::SCADA::double3 gauss_krueger_forward(double latitude, double longitude, double altitude, const WarGrey::DTPM::GCSContext& gcs);
+	WarGrey::SCADA::double3 gauss_krueger_inverse(double x, double y, double z, const WarGrey::DTPM::GCSContext& gcs,
+		WarGrey::DTPM::GCSAccuracy tier = WarGrey::DTPM::GCSAccuracy::Survey);
+
+	void gauss_krueger_forward(const double* latitudes, const double* longitudes, const double* altitudes,
+		double* xs, double* ys, double* zs, size_t count, const WarGrey::DTPM::GCSContext& gcs);
+
+	void gauss_krueger_forward_scalar(const double* latitudes, const double* longitudes, const double* altitudes,
+		double* xs, double* ys, double* zs, size_t count, const WarGrey::DTPM::GCSContext& gcs);
+
+	void gauss_krueger_inverse(const double* xs, const double* ys, const double* zs,
+		double* latitudes, double* longitudes, double* altitudes, size_t count, const WarGrey::DTPM::GCSContext& gcs,
+		WarGrey::DTPM::GCSAccuracy tier = WarGrey::DTPM::GCSAccuracy::Survey);
+
+	WarGrey::SCADA::double3 gauss_krueger_forward(double latitude, double longitude, double altitude, const WarGrey::DTPM::GCSParameter& gcs);
+	WarGrey::SCADA::double3 gauss_krueger_inverse(double x, double y, double z, const WarGrey::DTPM::GCSParameter& gcs,
+		WarGrey::DTPM::GCSAccuracy tier = WarGrey::DTPM::GCSAccuracy::Survey);
+
+	void gauss_krueger_forward(const double* latitudes, const double* longitudes, const double* altitudes,
+		double* xs, double* ys, double* zs, size_t count, const WarGrey::DTPM::GCSParameter& gcs);
+
+	void gauss_krueger_forward_scalar(const double* latitudes, const double* longitudes, const double* altitudes,
+		double* xs, double* ys, double* zs, size_t count, const WarGrey::DTPM::GCSParameter& gcs);
+
+	void gauss_krueger_inverse(const double* xs, const double* ys, const double* zs,
+		double* latitudes, double* longitudes, double* altitudes, size_t count, const WarGrey::DTPM::GCSParameter& gcs,
+		WarGrey::DTPM::GCSAccuracy tier = WarGrey::DTPM::GCSAccuracy::Survey);
+
+	const char* gauss_krueger_simd_name();
+	size_t gauss_krueger_simd_lanes();
+}
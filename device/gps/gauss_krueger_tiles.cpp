@@ -0,0 +1,401 @@
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "device/gps/gauss_krueger_tiles.hpp"
+
+using namespace WarGrey::SCADA;
+using namespace WarGrey::DTPM;
+
+static const double pi = 3.14159265358979323846;
+
+static const size_t tile_nodes = 4;                                    // Chebyshev nodes along each axis
+static const size_t tile_samples = tile_nodes * tile_nodes;
+static const size_t tile_terms = 6;                                    // 1, u, v, uu, uv, vv
+static const size_t tile_slope_terms = 3;                              // the slope along altitude is planar within a tile
+static const size_t tile_axis_stride = tile_terms + tile_slope_terms;
+static const size_t tile_stride = tile_axis_stride * 3;
+static const size_t tile_max_count = 4096;
+static const size_t tile_max_refinement = 8;
+static const size_t tile_check_samples = 9;
+
+/*************************************************************************************************/
+namespace {
+	static inline double nmea_to_degrees(double ddmm) {
+		double d = floor(fabs(ddmm) / 100.0);
+		double deg = d + (fabs(ddmm) - d * 100.0) / 60.0;
+
+		return ((ddmm < 0.0) ? -deg : deg);
+	}
+
+	static inline double degrees_to_nmea(double deg) {
+		double d = floor(fabs(deg));
+		double ddmm = d * 100.0 + (fabs(deg) - d) * 60.0;
+
+		return ((deg < 0.0) ? -ddmm : ddmm);
+	}
+
+	/**
+	 * Least-squares quadratic surface through the values at the 4x4 Chebyshev nodes on [-1, 1]^2,
+	 *   the pseudo-inverse only depends on the nodes, it is computed once.
+	 *
+	 * Cubic terms would make tiles larger for the same bound,
+	 *   but the working area is small and the evaluation cost is what matters on the hot path.
+	 */
+	struct QuadraticBasis {
+		double nodes[tile_nodes];
+		double pseudo_inverse[tile_terms][tile_samples];
+
+		QuadraticBasis() {
+			double A[tile_samples][tile_terms];
+			double N[tile_terms][tile_terms * 2];
+
+			for (size_t k = 0; k < tile_nodes; k++) {
+				nodes[k] = cos(double(2 * k + 1) * pi / double(tile_nodes * 2));
+			}
+
+			for (size_t i = 0; i < tile_nodes; i++) { // rows go with latitudes (v), columns go with longitudes (u)
+				for (size_t j = 0; j < tile_nodes; j++) {
+					double* a = A[i * tile_nodes + j];
+					double u = nodes[j];
+					double v = nodes[i];
+
+					a[0] = 1.0; a[1] = u; a[2] = v; a[3] = u * u; a[4] = u * v; a[5] = v * v;
+				}
+			}
+
+			for (size_t r = 0; r < tile_terms; r++) {
+				for (size_t c = 0; c < tile_terms; c++) {
+					N[r][c] = 0.0;
+					N[r][c + tile_terms] = ((r == c) ? 1.0 : 0.0);
+
+					for (size_t k = 0; k < tile_samples; k++) {
+						N[r][c] += A[k][r] * A[k][c];
+					}
+				}
+			}
+
+			for (size_t c = 0; c < tile_terms; c++) { // Gauss-Jordan, A^T A is positive definite
+				for (size_t r = 0; r < tile_terms; r++) {
+					if (r != c) {
+						double f = N[r][c] / N[c][c];
+
+						for (size_t j = 0; j < tile_terms * 2; j++) {
+							N[r][j] -= f * N[c][j];
+						}
+					}
+				}
+			}
+
+			for (size_t r = 0; r < tile_terms; r++) {
+				for (size_t k = 0; k < tile_samples; k++) {
+					pseudo_inverse[r][k] = 0.0;
+
+					for (size_t c = 0; c < tile_terms; c++) {
+						pseudo_inverse[r][k] += N[r][c + tile_terms] / N[r][r] * A[k][c];
+					}
+				}
+			}
+		}
+	};
+
+	static const QuadraticBasis basis;
+
+	static inline double evaluate(const double* c, double u, double v, double uu, double uv, double vv, double h) {
+		// summed pairwise rather than left to right, the chain of dependent additions is the bottleneck
+		return ((c[0] + c[1] * u) + (c[2] * v + c[3] * uu)) + ((c[4] * uv + c[5] * vv) + h * ((c[6] + c[7] * u) + c[8] * v));
+	}
+
+	struct TileView {
+		const double* coefficients;
+		double latitude0;
+		double longitude0;
+		double inverse_step;
+		double altitude0;
+		double inverse_altitude_span;
+		size_t rows;
+		size_t columns;
+	};
+
+	static inline double nmea_to_degrees_fast(double ddmm) {
+		double m = ((ddmm < 0.0) ? -ddmm : ddmm);
+		double d = double(int64_t(m * 0.01));
+		double deg = d + (m - d * 100.0) * (1.0 / 60.0);
+
+		return ((ddmm < 0.0) ? -deg : deg);
+	}
+
+	static inline bool tile_lookup(const TileView& g, double latitude, double longitude, double altitude, double* x, double* y, double* z) {
+		double fr = (nmea_to_degrees_fast(latitude) - g.latitude0) * g.inverse_step;
+		double fc = (nmea_to_degrees_fast(longitude) - g.longitude0) * g.inverse_step;
+		double h = (altitude - g.altitude0) * g.inverse_altitude_span;
+		bool inside = (fr >= 0.0) && (fc >= 0.0) && (fr <= double(g.rows)) && (fc <= double(g.columns)) && (h >= 0.0) && (h <= 1.0);
+
+		if (inside) {
+			size_t row = std::min(size_t(fr), g.rows - 1);
+			size_t col = std::min(size_t(fc), g.columns - 1);
+			const double* tile = g.coefficients + (row * g.columns + col) * tile_stride;
+			double u = (fc - double(col)) * 2.0 - 1.0;
+			double v = (fr - double(row)) * 2.0 - 1.0;
+			double uu = u * u;
+			double uv = u * v;
+			double vv = v * v;
+
+			(*x) = evaluate(tile, u, v, uu, uv, vv, h);
+			(*y) = evaluate(tile + tile_axis_stride, u, v, uu, uv, vv, h);
+			(*z) = evaluate(tile + tile_axis_stride * 2, u, v, uu, uv, vv, h);
+		}
+
+		return inside;
+	}
+}
+
+/*************************************************************************************************/
+GaussKruegerTiles::GaussKruegerTiles(std::shared_ptr<const GCSContext> gcs, const GCSWorkArea& area, double tolerance, double tile_degrees)
+	: gcs(gcs), work_area(area), error(0.0), okay(false) {
+	this->latitude0 = nmea_to_degrees(std::min(area.latitude_min, area.latitude_max));
+	this->longitude0 = nmea_to_degrees(std::min(area.longitude_min, area.longitude_max));
+	this->altitude0 = std::min(area.altitude_min, area.altitude_max);
+	this->altitude_span = std::max(fabs(area.altitude_max - area.altitude_min), 1.0);
+	this->rows = this->columns = 0;
+	this->inverse_altitude_span = 1.0 / this->altitude_span;
+	this->step = tile_degrees;
+
+	for (size_t i = 0; i < tile_max_refinement; i++) {
+		if (this->fit(tile_degrees, tolerance)) {
+			this->okay = true;
+			break;
+		}
+
+		tile_degrees *= 0.5;
+	}
+
+	if (!this->okay) {
+		this->coefficients.clear();
+		this->rows = this->columns = 0;
+	}
+}
+
+bool GaussKruegerTiles::fit(double tile_degrees, double tolerance) {
+	double latitude_span = nmea_to_degrees(std::max(this->work_area.latitude_min, this->work_area.latitude_max)) - this->latitude0;
+	double longitude_span = nmea_to_degrees(std::max(this->work_area.longitude_min, this->work_area.longitude_max)) - this->longitude0;
+	size_t rows = std::max(size_t(ceil(latitude_span / tile_degrees)), size_t(1));
+	size_t columns = std::max(size_t(ceil(longitude_span / tile_degrees)), size_t(1));
+	const GCSContext& c = *this->gcs;
+	double worst = 0.0;
+
+	if ((rows * columns > tile_max_count) || !(tile_degrees > 0.0)) {
+		return false;
+	}
+
+	this->coefficients.resize(rows * columns * tile_stride);
+	this->rows = rows;
+	this->columns = columns;
+	this->step = tile_degrees;
+	this->inverse_step = 1.0 / tile_degrees;
+
+	for (size_t row = 0; row < rows; row++) {
+		for (size_t col = 0; col < columns; col++) {
+			double* tile = &this->coefficients[(row * columns + col) * tile_stride];
+			double B0 = this->latitude0 + double(row) * tile_degrees;
+			double L0 = this->longitude0 + double(col) * tile_degrees;
+
+			double layers[2][3][tile_terms];
+
+			for (size_t layer = 0; layer < 2; layer++) {
+				double H = this->altitude0 + this->altitude_span * double(layer);
+				double values[3][tile_samples];
+
+				for (size_t i = 0; i < tile_nodes; i++) {
+					for (size_t j = 0; j < tile_nodes; j++) {
+						double B = B0 + (basis.nodes[i] + 1.0) * 0.5 * tile_degrees;
+						double L = L0 + (basis.nodes[j] + 1.0) * 0.5 * tile_degrees;
+						double3 xyz = gauss_krueger_forward(degrees_to_nmea(B), degrees_to_nmea(L), H, c);
+
+						values[0][i * tile_nodes + j] = xyz.x;
+						values[1][i * tile_nodes + j] = xyz.y;
+						values[2][i * tile_nodes + j] = xyz.z;
+					}
+				}
+
+				for (size_t axis = 0; axis < 3; axis++) {
+					for (size_t t = 0; t < tile_terms; t++) {
+						layers[layer][axis][t] = 0.0;
+
+						for (size_t k = 0; k < tile_samples; k++) {
+							layers[layer][axis][t] += basis.pseudo_inverse[t][k] * values[axis][k];
+						}
+					}
+				}
+			}
+
+			for (size_t axis = 0; axis < 3; axis++) { // the difference between layers, keeping only terms of the order 0 and 1
+				double* poly = tile + axis * tile_axis_stride;
+
+				for (size_t t = 0; t < tile_terms; t++) {
+					poly[t] = layers[0][axis][t];
+				}
+
+				for (size_t t = 0; t < tile_slope_terms; t++) {
+					poly[tile_terms + t] = layers[1][axis][t] - layers[0][axis][t];
+				}
+			}
+
+			for (size_t i = 0; i < tile_check_samples; i++) {
+				for (size_t j = 0; j < tile_check_samples; j++) {
+					if ((row + 1 < rows) && (i + 1 == tile_check_samples)) continue; // the edge belongs to the next tile
+					if ((col + 1 < columns) && (j + 1 == tile_check_samples)) continue;
+
+					for (size_t h = 0; h < 3; h++) {
+						double B = B0 + tile_degrees * double(i) / double(tile_check_samples - 1);
+						double L = L0 + tile_degrees * double(j) / double(tile_check_samples - 1);
+						double H = this->altitude0 + this->altitude_span * double(h) * 0.5;
+						double3 exact = gauss_krueger_forward(degrees_to_nmea(B), degrees_to_nmea(L), H, c);
+						double3 approx = this->forward(degrees_to_nmea(B), degrees_to_nmea(L), H);
+						double dx = approx.x - exact.x;
+						double dy = approx.y - exact.y;
+						double dz = approx.z - exact.z;
+
+						worst = std::max(worst, sqrt(dx * dx + dy * dy + dz * dz));
+					}
+				}
+			}
+
+			if (!(worst <= tolerance)) {
+				return false;
+			}
+		}
+	}
+
+	this->error = worst;
+
+	return true;
+}
+
+/*************************************************************************************************/
+double3 GaussKruegerTiles::forward(double latitude, double longitude, double altitude) {
+	TileView grid = { this->coefficients.data(), this->latitude0, this->longitude0, this->inverse_step, this->altitude0, this->inverse_altitude_span, this->rows, this->columns };
+	double x, y, z;
+
+	if ((this->rows == 0) || !tile_lookup(grid, latitude, longitude, altitude, &x, &y, &z)) {
+		return gauss_krueger_forward(latitude, longitude, altitude, *this->gcs);
+	}
+
+	return double3(x, y, z);
+}
+
+void GaussKruegerTiles::forward(const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count) {
+	if (!this->okay) {
+		gauss_krueger_forward(Bs, Ls, Hs, xs, ys, zs, count, *this->gcs);
+	} else { // the view is local, so that stores into the outputs would not force reloading the grid
+		const TileView grid = { this->coefficients.data(), this->latitude0, this->longitude0, this->inverse_step, this->altitude0, this->inverse_altitude_span, this->rows, this->columns };
+
+		for (size_t i = 0; i < count; i++) {
+			if (!tile_lookup(grid, Bs[i], Ls[i], Hs[i], xs + i, ys + i, zs + i)) {
+				double3 xyz = gauss_krueger_forward(Bs[i], Ls[i], Hs[i], *this->gcs);
+
+				xs[i] = xyz.x;
+				ys[i] = xyz.y;
+				zs[i] = xyz.z;
+			}
+		}
+	}
+}
+
+/*************************************************************************************************/
+const GCSContext& GaussKruegerTiles::context() {
+	return *this->gcs;
+}
+
+const GCSWorkArea& GaussKruegerTiles::area() {
+	return this->work_area;
+}
+
+bool GaussKruegerTiles::ready() {
+	return this->okay;
+}
+
+double GaussKruegerTiles::error_bound() {
+	return this->error;
+}
+
+double GaussKruegerTiles::tile_degrees() {
+	return this->step;
+}
+
+size_t GaussKruegerTiles::tile_count() {
+	return this->rows * this->columns;
+}
+
+/*************************************************************************************************/
+#ifdef GK_TILES_MAIN
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+#include "device/gps/gcs_benchmark.hpp"
+
+int main(int argc, char* argv[]) {
+	size_t count = ((argc > 1) ? size_t(strtoull(argv[1], nullptr, 10)) : 1000000U);
+	double width = ((argc > 2) ? strtod(argv[2], nullptr) : 0.1); // degrees
+	size_t preset_count;
+	const GCSBenchmarkPreset* ps = gcs_benchmark_presets(&preset_count);
+	std::vector<double> Bs(count), Ls(count), Hs(count), xs(count), ys(count), zs(count), txs(count), tys(count), tzs(count);
+	volatile double sink = 0.0;
+	int status = 0;
+
+	printf("%-24s %6s %10s %12s %12s %12s %12s %12s %8s\n", "configuration", "tiles", "bound(mm)",
+		"exact(pt/s)", "tiled(pt/s)", "scalar(pt/s)", "tiled1(pt/s)", "err(mm)", "build(ms)");
+
+	for (size_t p = 0; p < preset_count; p++) {
+		double B0 = (ps[p].latitude_min + ps[p].latitude_max) * 0.5;
+		double L0 = ps[p].parameter.cm + 1.0;
+		GCSWorkArea area = { degrees_to_nmea(B0), degrees_to_nmea(B0 + width), degrees_to_nmea(L0), degrees_to_nmea(L0 + width), -20.0, 80.0 };
+		std::shared_ptr<const GCSContext> gcs = gcs_compile(ps[p].parameter);
+		std::mt19937_64 prng(p);
+		std::uniform_real_distribution<double> latitude(B0, B0 + width);
+		std::uniform_real_distribution<double> longitude(L0, L0 + width);
+		std::uniform_real_distribution<double> altitude(-20.0, 80.0);
+		double worst = 0.0;
+
+		for (size_t i = 0; i < count; i++) {
+			Bs[i] = degrees_to_nmea(latitude(prng));
+			Ls[i] = degrees_to_nmea(longitude(prng));
+			Hs[i] = altitude(prng);
+		}
+
+		auto t0 = std::chrono::steady_clock::now();
+		gauss_krueger_forward(Bs.data(), Ls.data(), Hs.data(), xs.data(), ys.data(), zs.data(), count, *gcs);
+		auto t1 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < count; i++) sink = sink + gauss_krueger_forward(Bs[i], Ls[i], Hs[i], *gcs).x;
+		auto t2 = std::chrono::steady_clock::now();
+		GaussKruegerTiles tiles(gcs, area);
+		auto t3 = std::chrono::steady_clock::now();
+		tiles.forward(Bs.data(), Ls.data(), Hs.data(), txs.data(), tys.data(), tzs.data(), count);
+		auto t4 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < count; i++) sink = sink + tiles.forward(Bs[i], Ls[i], Hs[i]).x;
+		auto t5 = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < count; i++) {
+			double dx = txs[i] - xs[i];
+			double dy = tys[i] - ys[i];
+			double dz = tzs[i] - zs[i];
+
+			worst = std::max(worst, sqrt(dx * dx + dy * dy + dz * dz));
+		}
+
+		printf("%-24s %6u %10.6f %12.0f %12.0f %12.0f %12.0f %12.6f %8.2f\n", ps[p].name, (unsigned int)tiles.tile_count(), tiles.error_bound() * 1000.0,
+			double(count) / std::chrono::duration<double>(t1 - t0).count(),
+			double(count) / std::chrono::duration<double>(t4 - t3).count(),
+			double(count) / std::chrono::duration<double>(t2 - t1).count(),
+			double(count) / std::chrono::duration<double>(t5 - t4).count(),
+			worst * 1000.0, std::chrono::duration<double, std::milli>(t3 - t2).count());
+
+		if (!tiles.ready() || (worst > 0.001)) {
+			status = 1;
+		}
+	}
+
+	return status;
+}
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "device/gps/gauss_krueger.hpp"
+
+namespace WarGrey::DTPM {
+	/**
+	 * The working area, latitudes and longitudes are NMEA-styled `ddmm.mmmm` as the fixes are.
+	 */
+	struct GCSWorkArea {
+		double latitude_min;
+		double latitude_max;
+		double longitude_min;
+		double longitude_max;
+		double altitude_min;
+		double altitude_max;
+	};
+
+	/**
+	 * Piecewise polynomial replacement of `gauss_krueger_forward()` over a working area,
+	 *   each tile holds quadratic surfaces (6 terms) of X, Y and Z least-squares fitted at 4x4 Chebyshev nodes,
+	 *   plus planar slopes (3 terms) along the altitude,
+	 *   evaluating them costs a few dozens of multiplications instead of the whole ellipsoidal series.
+	 *
+	 * Every tile is checked against the exact path on a dense sample when the grid is built,
+	 *   tiles are halved until the worst error is within `tolerance` (meter), `error_bound()` reports the worst error seen.
+	 * If the bound cannot be met, or the area is too large to be covered, the grid is not `ready()` and everything goes through the exact path;
+	 *   fixes outside the area always go through the exact path.
+	 */
+	class GaussKruegerTiles {
+	public:
+		GaussKruegerTiles(std::shared_ptr<const WarGrey::DTPM::GCSContext> gcs, const WarGrey::DTPM::GCSWorkArea& area,
+			double tolerance = 0.001, double tile_degrees = 0.05);
+
+	public:
+		WarGrey::SCADA::double3 forward(double latitude, double longitude, double altitude);
+		void forward(const double* latitudes, const double* longitudes, const double* altitudes,
+			double* xs, double* ys, double* zs, size_t count);
+
+	public:
+		const WarGrey::DTPM::GCSContext& context();
+		const WarGrey::DTPM::GCSWorkArea& area();
+		bool ready();
+		double error_bound();
+		double tile_degrees();
+		size_t tile_count();
+
+	private:
+		bool fit(double tile_degrees, double tolerance);
+
+	private:
+		std::shared_ptr<const WarGrey::DTPM::GCSContext> gcs;
+		WarGrey::DTPM::GCSWorkArea work_area;
+		std::vector<double> coefficients;
+		double latitude0;
+		double longitude0;
+		double step;
+		double inverse_step;
+		double altitude0;
+		double altitude_span;
+		double inverse_altitude_span;
+		size_t rows;
+		size_t columns;
+		double error;
+		bool okay;
+	};
+}
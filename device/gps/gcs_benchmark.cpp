@@ -0,0 +1,213 @@
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include "device/gps/gcs_benchmark.hpp"
+
+using namespace WarGrey::SCADA;
+using namespace WarGrey::DTPM;
+
+static const double pi = 3.14159265358979323846;
+static const double radians_per_degree = pi / 180.0;
+static const double earth_radius = 6378137.0;
+
+/*************************************************************************************************/
+static const GCSBenchmarkPreset presets[] = {
+	{ "WGS84 GK-3 121E", { 6378137.0, 298.257223563, 121.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 500000.0, 0.0, 1.0 }, 18.0, 42.0, 3.0 },
+	{ "CGCS2000 GK-3 123E", { 6378137.0, 298.257222101, 123.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 500000.0, 0.0, 1.0 }, 18.0, 42.0, 3.0 },
+	{ "Beijing54 GK-6 117E 7P", { 6378245.0, 298.3, 117.0, -15.415, 157.025, 94.74, 1.3, 0.312, 0.08, -0.102, 0.0, 500000.0, 0.0, 1.0 }, 18.0, 42.0, 6.0 },
+	{ "Xian80 GK-3 114E 7P", { 6378140.0, 298.257, 114.0, 24.0, -123.0, -94.0, -2.4, 0.02, -0.25, 0.13, 0.0, 500000.0, 0.0, 1.0 }, 18.0, 42.0, 3.0 },
+	{ "WGS84 UTM 51N", { 6378137.0, 298.257223563, 123.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 500000.0, 0.0, 0.9996 }, 0.0, 60.0, 6.0 },
+
+	// southern and western hemispheres, negative NMEA latitudes and longitudes
+	{ "WGS84 UTM 23S", { 6378137.0, 298.257223563, -45.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10000000.0, 500000.0, 0.0, 0.9996 }, -60.0, 0.0, 6.0 },
+	{ "SIRGAS2000 GK-3 51W", { 6378137.0, 298.257222101, -51.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10000000.0, 500000.0, 0.0, 1.0 }, -35.0, -5.0, 3.0 },
+	{ "NAD83 UTM 15N", { 6378137.0, 298.257222101, -93.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 500000.0, 0.0, 0.9996 }, 25.0, 49.0, 6.0 },
+	{ "GDA94 UTM 55S", { 6378137.0, 298.257222101, 147.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10000000.0, 500000.0, 0.0, 0.9996 }, -44.0, -10.0, 6.0 }
+};
+
+static inline double degrees_to_nmea(double deg) {
+	double d = floor(fabs(deg));
+	double ddmm = d * 100.0 + (fabs(deg) - d) * 60.0;
+
+	return ((deg < 0.0) ? -ddmm : ddmm);
+}
+
+static inline double nmea_to_degrees(double ddmm) {
+	double d = floor(fabs(ddmm) / 100.0);
+	double deg = d + (fabs(ddmm) - d * 100.0) / 60.0;
+
+	return ((ddmm < 0.0) ? -deg : deg);
+}
+
+// minutes that would be displayed as `60.0000` are carried into degrees by the inverse, the round trip expects the same
+static inline double nmea_carried(double ddmm) {
+	double d = floor(fabs(ddmm) / 100.0);
+
+	return (((fabs(ddmm) - d * 100.0) >= 60.0 - 0.00005) ? copysign((d + 1.0) * 100.0, ddmm) : ddmm);
+}
+
+static inline double percentile(std::vector<double>& samples, double p) {
+	size_t nth = size_t(double(samples.size() - 1) * p);
+
+	std::nth_element(samples.begin(), samples.begin() + nth, samples.end());
+
+	return samples[nth];
+}
+
+template<typename F>
+static double seconds_of(F run) {
+	auto start = std::chrono::steady_clock::now();
+
+	run();
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*************************************************************************************************/
+GCSBenchmarkReport WarGrey::DTPM::gcs_benchmark(const GCSBenchmarkPreset& preset, size_t count, uint64_t seed, GCSAccuracy tier) {
+	std::shared_ptr<const GCSContext> gcs = gcs_compile(preset.parameter);
+	std::vector<double> Bs(count), Ls(count), Hs(count);
+	std::vector<double> xs(count), ys(count), zs(count);
+	std::vector<double> sxs(count), sys(count), szs(count);
+	std::vector<double> rBs(count), rLs(count), rHs(count);
+	std::vector<double> latencies(count);
+	std::mt19937_64 prng(seed);
+	std::uniform_real_distribution<double> latitude(preset.latitude_min, preset.latitude_max);
+	std::uniform_real_distribution<double> longitude(preset.parameter.cm - preset.longitude_span * 0.5, preset.parameter.cm + preset.longitude_span * 0.5);
+	std::uniform_real_distribution<double> altitude(-50.0, 150.0);
+	GCSBenchmarkReport report;
+	volatile double sink = 0.0;
+	bool generic_identical = false;
+	double seconds;
+
+	memset(&report, 0, sizeof(GCSBenchmarkReport));
+	report.points = count;
+
+	if (count == 0) {
+		return report;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		Bs[i] = degrees_to_nmea(latitude(prng));
+		Ls[i] = degrees_to_nmea(longitude(prng));
+		Hs[i] = altitude(prng);
+	}
+
+	seconds = seconds_of([&]() { gauss_krueger_forward(Bs.data(), Ls.data(), Hs.data(), xs.data(), ys.data(), zs.data(), count, *gcs); });
+	report.forward_batch_rate = double(count) / seconds;
+
+	{ // the same parameter forced through the generic kernel
+		GCSContext generic = (*gcs);
+
+		generic.datum = GCSDatum::_;
+		seconds = seconds_of([&]() { gauss_krueger_forward(Bs.data(), Ls.data(), Hs.data(), sxs.data(), sys.data(), szs.data(), count, generic); });
+		report.forward_generic_rate = double(count) / seconds;
+		generic_identical = (memcmp(xs.data(), sxs.data(), sizeof(double) * count) == 0)
+			&& (memcmp(ys.data(), sys.data(), sizeof(double) * count) == 0)
+			&& (memcmp(zs.data(), szs.data(), sizeof(double) * count) == 0);
+	}
+
+	seconds = seconds_of([&]() { gauss_krueger_forward_scalar(Bs.data(), Ls.data(), Hs.data(), sxs.data(), sys.data(), szs.data(), count, *gcs); });
+	report.forward_scalar_rate = double(count) / seconds;
+
+	seconds = seconds_of([&]() { gauss_krueger_inverse(xs.data(), ys.data(), zs.data(), rBs.data(), rLs.data(), rHs.data(), count, *gcs, tier); });
+	report.inverse_batch_rate = double(count) / seconds;
+
+	report.simd_bit_identical = generic_identical
+		&& (memcmp(xs.data(), sxs.data(), sizeof(double) * count) == 0)
+		&& (memcmp(ys.data(), sys.data(), sizeof(double) * count) == 0)
+		&& (memcmp(zs.data(), szs.data(), sizeof(double) * count) == 0);
+
+	for (size_t i = 0; i < count; i++) {
+		double B = nmea_to_degrees(nmea_carried(Bs[i])) * radians_per_degree;
+		double north = (nmea_to_degrees(rBs[i]) * radians_per_degree - B) * earth_radius;
+		double east = (nmea_to_degrees(rLs[i]) - nmea_to_degrees(nmea_carried(Ls[i]))) * radians_per_degree * earth_radius * cos(B);
+		double up = rHs[i] - Hs[i];
+		double error = sqrt(north * north + east * east + up * up) * 1000.0;
+
+		report.max_roundtrip_error = std::max(report.max_roundtrip_error, error);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		auto start = std::chrono::steady_clock::now();
+		double3 xyz = gauss_krueger_forward(Bs[i], Ls[i], Hs[i], *gcs);
+
+		latencies[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		sink = sink + xyz.x;
+	}
+
+	report.forward_p50 = percentile(latencies, 0.50);
+	report.forward_p99 = percentile(latencies, 0.99);
+	report.forward_p999 = percentile(latencies, 0.999);
+
+	for (size_t i = 0; i < count; i++) {
+		auto start = std::chrono::steady_clock::now();
+		double3 blh = gauss_krueger_inverse(xs[i], ys[i], zs[i], *gcs, tier);
+
+		latencies[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		sink = sink + blh.x;
+	}
+
+	report.inverse_p50 = percentile(latencies, 0.50);
+	report.inverse_p99 = percentile(latencies, 0.99);
+	report.inverse_p999 = percentile(latencies, 0.999);
+
+	return report;
+}
+
+const GCSBenchmarkPreset* WarGrey::DTPM::gcs_benchmark_presets(size_t* count) {
+	(*count) = sizeof(presets) / sizeof(GCSBenchmarkPreset);
+
+	return presets;
+}
+
+/*************************************************************************************************/
+#ifdef GCS_BENCHMARK_MAIN
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * Arguments: points per configuration, the tolerance of the round trip (mm), the inverse tier (`survey` or `exact`).
+ */
+int main(int argc, char* argv[]) {
+	size_t count = ((argc > 1) ? size_t(strtoull(argv[1], nullptr, 10)) : 1000000U);
+	double tolerance = ((argc > 2) ? strtod(argv[2], nullptr) : 1.0);
+	bool exact = ((argc > 3) && (strcmp(argv[3], "exact") == 0));
+	GCSAccuracy tier = (exact ? GCSAccuracy::Exact : GCSAccuracy::Survey);
+	size_t preset_count;
+	const GCSBenchmarkPreset* ps = gcs_benchmark_presets(&preset_count);
+	int status = 0;
+
+#if defined(__FMA__) || defined(__ARM_FEATURE_FMA)
+	const char* fma = "with FMA";
+#else
+	const char* fma = "without FMA";
+#endif
+
+	printf("kernel: %s x %u (%s), %s inverse, %u points per configuration\n", gauss_krueger_simd_name(), (unsigned int)gauss_krueger_simd_lanes(),
+		fma, (exact ? "exact" : "survey"), (unsigned int)count);
+	printf("%-24s %12s %12s %12s %12s %9s %9s %9s %9s %9s %9s %12s %s\n",
+		"configuration", "fwd(pt/s)", "generic(pt/s)", "scalar(pt/s)", "inv(pt/s)",
+		"fwd p50", "fwd p99", "fwd p999", "inv p50", "inv p99", "inv p999", "err(mm)", "bits");
+
+	for (size_t i = 0; i < preset_count; i++) {
+		GCSBenchmarkReport r = gcs_benchmark(ps[i], count, i, tier);
+		bool okay = r.simd_bit_identical && (r.max_roundtrip_error <= tolerance);
+
+		printf("%-24s %12.0f %12.0f %12.0f %12.0f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %12.6f %s\n", ps[i].name,
+			r.forward_batch_rate, r.forward_generic_rate, r.forward_scalar_rate, r.inverse_batch_rate,
+			r.forward_p50, r.forward_p99, r.forward_p999, r.inverse_p50, r.inverse_p99, r.inverse_p999,
+			r.max_roundtrip_error, (r.simd_bit_identical ? "same" : "DIFF"));
+
+		if (!okay) {
+			status = 1;
+		}
+	}
+
+	return status;
+}
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "device/gps/gauss_krueger.hpp"
+
+namespace WarGrey::DTPM {
+	struct GCSBenchmarkPreset {
+		const char* name;
+		WarGrey::DTPM::GCSParameter parameter;
+
+		// degrees, the sampling area is centered at the central meridian
+		double latitude_min;
+		double latitude_max;
+		double longitude_span;
+	};
+
+	struct GCSBenchmarkReport {
+		size_t points;
+
+		// points per second
+		double forward_batch_rate;
+		double forward_scalar_rate;
+		double forward_generic_rate; // the batch path with the datum specialization turned off
+		double inverse_batch_rate;
+
+		// nanoseconds per scalar call
+		double forward_p50;
+		double forward_p99;
+		double forward_p999;
+		double inverse_p50;
+		double inverse_p99;
+		double inverse_p999;
+
+		// B/L/H => X/Y/Z => B/L/H, millimeters
+		double max_roundtrip_error;
+		bool simd_bit_identical; // the batch, the scalar and the generic kernels agree bit by bit
+	};
+
+	/**
+	 * Runs `count` random B/L/H points through `gauss_krueger_forward()` and `gauss_krueger_inverse()`,
+	 *   measures the throughput of both the batch and the scalar paths, the per-call latency percentiles,
+	 *   and the maximum round-trip error, so that optimizations of the convertor can be gated on both speed and accuracy.
+	 *
+	 * The module only depends on the standard library and `GCSParameter`, define `GCS_BENCHMARK_MAIN` to get a headless command line driver:
+	 *   c++ -std=c++17 -O2 -DGCS_BENCHMARK_MAIN -I. -I<path to cs/wgs_xy.hpp> device/gps/{gauss_krueger,gcs_context,gcs_benchmark}.cpp
+	 * Build it once more with `-march=haswell` (or any target with FMA), where the compiler is free to contract the kernels,
+	 *   the bit-identity check is what guards `fp_contract.hpp`, the driver exits with 1 on any `DIFF`.
+	 */
+	WarGrey::DTPM::GCSBenchmarkReport gcs_benchmark(const WarGrey::DTPM::GCSBenchmarkPreset& preset, size_t count, uint64_t seed = 0,
+		WarGrey::DTPM::GCSAccuracy tier = WarGrey::DTPM::GCSAccuracy::Survey);
+
+	const WarGrey::DTPM::GCSBenchmarkPreset* gcs_benchmark_presets(size_t* count);
+}
@@ -0,0 +1,463 @@
+#include <cmath>
+#include <cstring>
+
+#include "device/gps/gcs_cache.hpp"
+#include "device/gps/gauss_krueger_tiles.hpp"
+
+using namespace WarGrey::SCADA;
+using namespace WarGrey::DTPM;
+
+static const double meters_per_minute = 1852.0;         // along the meridian, and the most along the parallel
+static const double minimum_curvature_radius = 6.3e6;   // meters, the meridian radius at the equator is ~6335km
+static const double rounding_error = 1e-7;              // meters, a few ulps of 10^7m amplified by the forward differences
+static const size_t cache_chunk = 16;                   // misses converted in one batch
+
+enum { CacheMiss = 0, CacheHit, CacheInterpolated };
+
+/*************************************************************************************************/
+struct GCSResultCache::Key {
+	uint64_t hash;
+	int64_t cell[3];
+	size_t slot;
+};
+
+/**
+ * Fields are atomics accessed relaxedly, the sequence orders them,
+ *   it is odd while the slot is being written.
+ */
+struct alignas(64) GCSResultCache::Slot {
+	std::atomic<uint32_t> sequence;
+	std::atomic<bool> filled;
+	std::atomic<uint64_t> hash;
+	std::atomic<int64_t> cell[3];
+	std::atomic<double> source[3];
+	std::atomic<double> result[3];
+	std::atomic<double> jacobian[9]; // d(x, y, z) / d(latitude, longitude, altitude), row-major
+};
+
+namespace {
+	static inline uint64_t cell_mix(uint64_t hash, const int64_t cell[3]) {
+		hash ^= uint64_t(cell[0]) * 0x9E3779B97F4A7C15ULL;
+		hash ^= uint64_t(cell[1]) * 0xC2B2AE3D27D4EB4FULL;
+		hash ^= uint64_t(cell[2]) * 0x165667B19E3779F9ULL;
+		hash ^= (hash >> 29);
+		hash *= 0xBF58476D1CE4E5B9ULL;
+		hash ^= (hash >> 32);
+
+		return hash;
+	}
+
+	static inline bool slot_try_lock(std::atomic<uint32_t>& sequence, uint32_t* seq) {
+		uint32_t s = sequence.load(std::memory_order_relaxed);
+		bool okay = false;
+
+		if ((s & 1U) == 0U) {
+			okay = sequence.compare_exchange_strong(s, s + 1U, std::memory_order_acquire, std::memory_order_relaxed);
+
+			if (okay) {
+				std::atomic_thread_fence(std::memory_order_release);
+				(*seq) = s;
+			}
+		}
+
+		return okay;
+	}
+
+	static inline void slot_unlock(std::atomic<uint32_t>& sequence, uint32_t seq) {
+		sequence.store(seq + 2U, std::memory_order_release);
+	}
+}
+
+/*************************************************************************************************/
+GCSResultCache::GCSResultCache(size_t capacity, double resolution, double tolerance)
+	: hits(0), interpolations(0), misses(0), contentions(0) {
+	size_t size = 1;
+
+	while (size < capacity) {
+		size <<= 1U;
+	}
+
+	if (!(resolution > 0.0)) {
+		resolution = 0.05;
+	}
+
+	this->slots = std::unique_ptr<Slot[]>(new Slot[size]);
+	this->mask = size - 1;
+	this->horizontal_quantum = resolution / meters_per_minute;
+	this->vertical_quantum = resolution;
+
+	/**
+	 * A fix is at most a cell diagonal away from the one that filled the cell,
+	 *   the linearization error of the projection over distance d is about d^2 / 2R,
+	 *   it is doubled to cover the forward differences of the Jacobian.
+	 */
+	this->linearization_error = 3.0 * resolution * resolution / minimum_curvature_radius + rounding_error;
+	this->interpolation = (this->linearization_error <= tolerance);
+
+	for (size_t idx = 0; idx < size; idx++) {
+		Slot* slot = &this->slots[idx];
+
+		slot->sequence.store(0U, std::memory_order_relaxed);
+		slot->filled.store(false, std::memory_order_relaxed);
+	}
+}
+
+GCSResultCache::~GCSResultCache() {}
+
+/*************************************************************************************************/
+double3 GCSResultCache::forward(double latitude, double longitude, double altitude, const GCSContext& gcs, GaussKruegerTiles* tiles) {
+	double3 xyz;
+	Key key;
+
+	this->make_key(latitude, longitude, altitude, gcs, &key);
+
+	switch (this->lookup(key, latitude, longitude, altitude, &xyz.x, &xyz.y, &xyz.z)) {
+	case CacheHit: this->hits.fetch_add(1U, std::memory_order_relaxed); break;
+	case CacheInterpolated: this->interpolations.fetch_add(1U, std::memory_order_relaxed); break;
+	default: {
+		this->misses.fetch_add(1U, std::memory_order_relaxed);
+		this->convert(&latitude, &longitude, &altitude, &key, &xyz.x, &xyz.y, &xyz.z, 1, gcs, tiles);
+	}
+	}
+
+	return xyz;
+}
+
+void GCSResultCache::forward(const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count,
+	const GCSContext& gcs, GaussKruegerTiles* tiles) {
+	double mBs[cache_chunk], mLs[cache_chunk], mHs[cache_chunk], mxs[cache_chunk], mys[cache_chunk], mzs[cache_chunk];
+	Key keys[cache_chunk];
+	size_t indices[cache_chunk];
+	size_t repeats[cache_chunk];
+	size_t i = 0;
+
+	while (i < count) {
+		size_t pending = 0;
+		size_t repeated = 0;
+		uint64_t hit = 0;
+		uint64_t interpolated = 0;
+
+		while ((i < count) && (pending < cache_chunk) && (repeated < cache_chunk)) {
+			Key* key = &keys[pending];
+
+			if ((i > 0) && (Bs[i] == Bs[i - 1]) && (Ls[i] == Ls[i - 1]) && (Hs[i] == Hs[i - 1])) {
+				// the previous one may still be pending, the slot is not filled until the chunk is converted
+				repeats[repeated++] = i;
+			} else {
+				this->make_key(Bs[i], Ls[i], Hs[i], gcs, key);
+
+				switch (this->lookup(*key, Bs[i], Ls[i], Hs[i], xs + i, ys + i, zs + i)) {
+				case CacheHit: hit++; break;
+				case CacheInterpolated: interpolated++; break;
+				default: {
+					mBs[pending] = Bs[i];
+					mLs[pending] = Ls[i];
+					mHs[pending] = Hs[i];
+					indices[pending] = i;
+					pending++;
+				}
+				}
+			}
+
+			i++;
+		}
+
+		if (pending > 0) {
+			this->convert(mBs, mLs, mHs, keys, mxs, mys, mzs, pending, gcs, tiles);
+
+			for (size_t j = 0; j < pending; j++) {
+				xs[indices[j]] = mxs[j];
+				ys[indices[j]] = mys[j];
+				zs[indices[j]] = mzs[j];
+			}
+		}
+
+		for (size_t j = 0; j < repeated; j++) {
+			xs[repeats[j]] = xs[repeats[j] - 1];
+			ys[repeats[j]] = ys[repeats[j] - 1];
+			zs[repeats[j]] = zs[repeats[j] - 1];
+		}
+
+		this->hits.fetch_add(hit + repeated, std::memory_order_relaxed);
+		this->interpolations.fetch_add(interpolated, std::memory_order_relaxed);
+		this->misses.fetch_add(pending, std::memory_order_relaxed);
+	}
+}
+
+/*************************************************************************************************/
+void GCSResultCache::make_key(double latitude, double longitude, double altitude, const GCSContext& gcs, Key* key) {
+	key->hash = gcs.hash;
+	key->cell[0] = int64_t(floor(latitude / this->horizontal_quantum));
+	key->cell[1] = int64_t(floor(longitude / this->horizontal_quantum));
+	key->cell[2] = int64_t(floor(altitude / this->vertical_quantum));
+	key->slot = size_t(cell_mix(key->hash, key->cell)) & this->mask;
+}
+
+int GCSResultCache::lookup(const Key& key, double latitude, double longitude, double altitude, double* x, double* y, double* z) {
+	Slot* slot = &this->slots[key.slot];
+	uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+	double source[3], result[3], jacobian[9];
+	int status = CacheMiss;
+
+	// a torn key can only turn a hit into a miss, which is harmless
+	if (((seq & 1U) == 0U) && slot->filled.load(std::memory_order_relaxed)
+		&& (slot->hash.load(std::memory_order_relaxed) == key.hash)
+		&& (slot->cell[0].load(std::memory_order_relaxed) == key.cell[0])
+		&& (slot->cell[1].load(std::memory_order_relaxed) == key.cell[1])
+		&& (slot->cell[2].load(std::memory_order_relaxed) == key.cell[2])) {
+		for (size_t idx = 0; idx < 3; idx++) {
+			source[idx] = slot->source[idx].load(std::memory_order_relaxed);
+			result[idx] = slot->result[idx].load(std::memory_order_relaxed);
+		}
+
+		if (this->interpolation) {
+			for (size_t idx = 0; idx < 9; idx++) {
+				jacobian[idx] = slot->jacobian[idx].load(std::memory_order_relaxed);
+			}
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (slot->sequence.load(std::memory_order_relaxed) == seq) {
+			if ((source[0] == latitude) && (source[1] == longitude) && (source[2] == altitude)) {
+				(*x) = result[0];
+				(*y) = result[1];
+				(*z) = result[2];
+				status = CacheHit;
+			} else if (this->interpolation) {
+				double dB = latitude - source[0];
+				double dL = longitude - source[1];
+				double dH = altitude - source[2];
+
+				(*x) = result[0] + jacobian[0] * dB + jacobian[1] * dL + jacobian[2] * dH;
+				(*y) = result[1] + jacobian[3] * dB + jacobian[4] * dL + jacobian[5] * dH;
+				(*z) = result[2] + jacobian[6] * dB + jacobian[7] * dL + jacobian[8] * dH;
+				status = CacheInterpolated;
+			}
+		}
+	}
+
+	return status;
+}
+
+void GCSResultCache::convert(const double* Bs, const double* Ls, const double* Hs, const Key* keys,
+	double* xs, double* ys, double* zs, size_t count, const GCSContext& gcs, GaussKruegerTiles* tiles) {
+	size_t stride = (this->interpolation ? 4 : 1);
+	double pBs[cache_chunk * 4], pLs[cache_chunk * 4], pHs[cache_chunk * 4];
+	double pxs[cache_chunk * 4], pys[cache_chunk * 4], pzs[cache_chunk * 4];
+	double steps[3] = { this->horizontal_quantum, this->horizontal_quantum, this->vertical_quantum };
+	uint64_t contended = 0;
+
+	// the fix itself, then one step along the latitude, the longitude and the altitude respectively
+	for (size_t i = 0; i < count; i++) {
+		for (size_t j = 0; j < stride; j++) {
+			pBs[i * stride + j] = Bs[i] + ((j == 1) ? steps[0] : 0.0);
+			pLs[i * stride + j] = Ls[i] + ((j == 2) ? steps[1] : 0.0);
+			pHs[i * stride + j] = Hs[i] + ((j == 3) ? steps[2] : 0.0);
+		}
+	}
+
+	if (tiles == nullptr) {
+		gauss_krueger_forward(pBs, pLs, pHs, pxs, pys, pzs, count * stride, gcs);
+	} else {
+		tiles->forward(pBs, pLs, pHs, pxs, pys, pzs, count * stride);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		size_t base = i * stride;
+		Slot* slot = &this->slots[keys[i].slot];
+		uint32_t seq;
+
+		xs[i] = pxs[base];
+		ys[i] = pys[base];
+		zs[i] = pzs[base];
+
+		if (slot_try_lock(slot->sequence, &seq)) {
+			slot->hash.store(keys[i].hash, std::memory_order_relaxed);
+			slot->source[0].store(Bs[i], std::memory_order_relaxed);
+			slot->source[1].store(Ls[i], std::memory_order_relaxed);
+			slot->source[2].store(Hs[i], std::memory_order_relaxed);
+			slot->result[0].store(xs[i], std::memory_order_relaxed);
+			slot->result[1].store(ys[i], std::memory_order_relaxed);
+			slot->result[2].store(zs[i], std::memory_order_relaxed);
+
+			for (size_t idx = 0; idx < 3; idx++) {
+				slot->cell[idx].store(keys[i].cell[idx], std::memory_order_relaxed);
+			}
+
+			if (this->interpolation) {
+				for (size_t d = 0; d < 3; d++) {
+					slot->jacobian[0 + d].store((pxs[base + 1 + d] - pxs[base]) / steps[d], std::memory_order_relaxed);
+					slot->jacobian[3 + d].store((pys[base + 1 + d] - pys[base]) / steps[d], std::memory_order_relaxed);
+					slot->jacobian[6 + d].store((pzs[base + 1 + d] - pzs[base]) / steps[d], std::memory_order_relaxed);
+				}
+			}
+
+			slot->filled.store(true, std::memory_order_relaxed);
+			slot_unlock(slot->sequence, seq);
+		} else {
+			contended++;
+		}
+	}
+
+	if (contended > 0) {
+		this->contentions.fetch_add(contended, std::memory_order_relaxed);
+	}
+}
+
+/*************************************************************************************************/
+void GCSResultCache::clear() {
+	for (size_t idx = 0; idx <= this->mask; idx++) {
+		Slot* slot = &this->slots[idx];
+		uint32_t seq;
+
+		while (!slot_try_lock(slot->sequence, &seq));
+
+		slot->filled.store(false, std::memory_order_relaxed);
+		slot_unlock(slot->sequence, seq);
+	}
+
+	this->hits.store(0U);
+	this->interpolations.store(0U);
+	this->misses.store(0U);
+	this->contentions.store(0U);
+}
+
+GCSCacheStatistics GCSResultCache::statistics() {
+	GCSCacheStatistics s;
+
+	s.hits = this->hits.load(std::memory_order_relaxed);
+	s.interpolations = this->interpolations.load(std::memory_order_relaxed);
+	s.misses = this->misses.load(std::memory_order_relaxed);
+	s.contentions = this->contentions.load(std::memory_order_relaxed);
+
+	return s;
+}
+
+size_t GCSResultCache::capacity() {
+	return this->mask + 1;
+}
+
+double GCSResultCache::resolution() {
+	return this->vertical_quantum;
+}
+
+double GCSResultCache::error_bound() {
+	return (this->interpolation ? this->linearization_error : 0.0);
+}
+
+bool GCSResultCache::interpolating() {
+	return this->interpolation;
+}
+
+/*************************************************************************************************/
+#ifdef GCS_CACHE_MAIN
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include "device/gps/gcs_benchmark.hpp"
+
+/**
+ * An anchored dredger: fixes random-walk within a few centimeters around the anchorage,
+ *   the ingest thread converts them in batches while the UI thread converts the latest ones one by one.
+ */
+int main(int argc, char* argv[]) {
+	size_t count = ((argc > 1) ? size_t(strtoull(argv[1], nullptr, 10)) : 1000000U);
+	double wander = ((argc > 2) ? strtod(argv[2], nullptr) : 0.05); // meters
+	size_t preset_count;
+	const GCSBenchmarkPreset* ps = gcs_benchmark_presets(&preset_count);
+	std::vector<double> Bs(count), Ls(count), Hs(count), xs(count), ys(count), zs(count), cxs(count), cys(count), czs(count);
+	int status = 0;
+
+	printf("%-24s %12s %12s %12s %8s %8s %10s %12s %9s\n", "configuration", "exact(pt/s)", "cached(pt/s)", "shared(pt/s)",
+		"hit(%)", "interp(%)", "contended", "err(mm)", "bound(mm)");
+
+	for (size_t p = 0; p < preset_count; p++) {
+		std::shared_ptr<const GCSContext> gcs = gcs_compile(ps[p].parameter);
+		std::mt19937_64 prng(p);
+		std::normal_distribution<double> step(0.0, 0.002);
+		double B0 = floor((ps[p].latitude_min + ps[p].latitude_max) * 0.5) * 100.0 + 30.0; // ddmm.mmmm
+		double L0 = floor(ps[p].parameter.cm + 1.0) * 100.0 + 30.0;
+		double dB = 0.0, dL = 0.0, dH = 0.0;
+		double worst = 0.0;
+
+		for (size_t i = 0; i < count; i++) { // meters, kept within the wander
+			dB = std::max(-wander, std::min(wander, dB + step(prng)));
+			dL = std::max(-wander, std::min(wander, dL + step(prng)));
+			dH = std::max(-wander, std::min(wander, dH + step(prng)));
+
+			Bs[i] = B0 + dB / meters_per_minute;
+			Ls[i] = L0 + dL / meters_per_minute;
+			Hs[i] = 10.0 + dH;
+
+			// repeated fixes when the receiver reports at a higher rate than it resolves
+			if ((i > 0) && ((prng() & 0x3U) == 0U)) {
+				Bs[i] = Bs[i - 1];
+				Ls[i] = Ls[i - 1];
+				Hs[i] = Hs[i - 1];
+			}
+		}
+
+		auto t0 = std::chrono::steady_clock::now();
+		gauss_krueger_forward(Bs.data(), Ls.data(), Hs.data(), xs.data(), ys.data(), zs.data(), count, *gcs);
+		auto t1 = std::chrono::steady_clock::now();
+
+		GCSResultCache cache;
+		auto t2 = std::chrono::steady_clock::now();
+		cache.forward(Bs.data(), Ls.data(), Hs.data(), cxs.data(), cys.data(), czs.data(), count, *gcs);
+		auto t3 = std::chrono::steady_clock::now();
+		GCSCacheStatistics s = cache.statistics();
+
+		for (size_t i = 0; i < count; i++) {
+			double ex = cxs[i] - xs[i];
+			double ey = cys[i] - ys[i];
+			double ez = czs[i] - zs[i];
+
+			worst = std::max(worst, sqrt(ex * ex + ey * ey + ez * ez));
+		}
+
+		{ // the same cache shared by a batch ingest thread and a scalar UI thread
+			GCSResultCache shared;
+			std::vector<double> uxs(count);
+			double ui_worst = 0.0;
+
+			auto t4 = std::chrono::steady_clock::now();
+			std::thread ingest([&]() { shared.forward(Bs.data(), Ls.data(), Hs.data(), cxs.data(), cys.data(), czs.data(), count, *gcs); });
+
+			for (size_t i = 0; i < count; i++) {
+				double3 xyz = shared.forward(Bs[count - i - 1], Ls[count - i - 1], Hs[count - i - 1], *gcs);
+
+				ui_worst = std::max(ui_worst, fabs(xyz.x - xs[count - i - 1]) + fabs(xyz.y - ys[count - i - 1]) + fabs(xyz.z - zs[count - i - 1]));
+			}
+
+			ingest.join();
+			auto t5 = std::chrono::steady_clock::now();
+			GCSCacheStatistics ss = shared.statistics();
+
+			for (size_t i = 0; i < count; i++) {
+				worst = std::max(worst, fabs(cxs[i] - xs[i]) + fabs(cys[i] - ys[i]) + fabs(czs[i] - zs[i]));
+			}
+
+			worst = std::max(worst, ui_worst);
+
+			printf("%-24s %12.0f %12.0f %12.0f %8.2f %8.2f %10llu %12.9f %9.6f\n", ps[p].name,
+				double(count) / std::chrono::duration<double>(t1 - t0).count(),
+				double(count) / std::chrono::duration<double>(t3 - t2).count(),
+				double(count * 2) / std::chrono::duration<double>(t5 - t4).count(),
+				double(s.hits) * 100.0 / double(count), double(s.interpolations) * 100.0 / double(count),
+				(unsigned long long)ss.contentions, worst * 1000.0, cache.error_bound() * 1000.0);
+		}
+
+		if (worst > cache.error_bound()) {
+			status = 1;
+		}
+	}
+
+	return status;
+}
+#endif
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "device/gps/gauss_krueger.hpp"
+
+namespace WarGrey::DTPM {
+	class GaussKruegerTiles;
+
+	struct GCSCacheStatistics {
+		uint64_t hits;           // the fix repeats a converted one, the result is returned as is
+		uint64_t interpolations; // the fix falls in a cached cell, the result is interpolated within the cell
+		uint64_t misses;
+		uint64_t contentions;    // the slot was being written by another thread, the fix is converted but not cached
+	};
+
+	/**
+	 * Bounded cache in front of `gauss_krueger_forward()` for vessels that are anchored or slow-sailing,
+	 *   fixes are quantized into cells of `resolution` meters (horizontally and vertically),
+	 *   a cell is keyed on the quantized latitude, longitude and altitude plus the hash of the parameter set,
+	 *   and is mapped directly to one of `capacity` slots (rounded up to a power of 2), newer cells replace older ones.
+	 *
+	 * A slot holds the fix that filled it, its exact result and the Jacobian of the projection at that fix,
+	 *   other fixes in the same cell are linearly interpolated if the linearization error of the cell is within `tolerance` meters,
+	 *   otherwise only repeated fixes are served from the cache.
+	 *
+	 * Each slot is guarded by its own sequence lock, readers never block and never write,
+	 *   so that the UI thread and the ingest thread can share a cache without a global lock,
+	 *   a reader that races with a writer simply treats the fix as a miss.
+	 */
+	class GCSResultCache {
+	public:
+		virtual ~GCSResultCache() noexcept;
+		GCSResultCache(size_t capacity = 1024, double resolution = 0.05, double tolerance = 0.0001);
+
+	public:
+		/**
+		 * `tiles`, if given, should be built for `gcs`, misses are converted by it instead of the exact path.
+		 */
+		WarGrey::SCADA::double3 forward(double latitude, double longitude, double altitude,
+			const WarGrey::DTPM::GCSContext& gcs, WarGrey::DTPM::GaussKruegerTiles* tiles = nullptr);
+
+		void forward(const double* latitudes, const double* longitudes, const double* altitudes,
+			double* xs, double* ys, double* zs, size_t count,
+			const WarGrey::DTPM::GCSContext& gcs, WarGrey::DTPM::GaussKruegerTiles* tiles = nullptr);
+
+	public:
+		void clear();
+		WarGrey::DTPM::GCSCacheStatistics statistics();
+		size_t capacity();
+		double resolution();
+		double error_bound();
+		bool interpolating();
+
+	private:
+		struct Slot;
+		struct Key;
+
+	private:
+		void make_key(double latitude, double longitude, double altitude, const WarGrey::DTPM::GCSContext& gcs, Key* key);
+		int lookup(const Key& key, double latitude, double longitude, double altitude, double* x, double* y, double* z);
+		void convert(const double* latitudes, const double* longitudes, const double* altitudes, const Key* keys,
+			double* xs, double* ys, double* zs, size_t count,
+			const WarGrey::DTPM::GCSContext& gcs, WarGrey::DTPM::GaussKruegerTiles* tiles);
+
+	private:
+		std::unique_ptr<Slot[]> slots;
+		size_t mask;
+		double horizontal_quantum; // minutes
+		double vertical_quantum;   // meters
+		double linearization_error;
+		bool interpolation;
+
+	private:
+		std::atomic<uint64_t> hits;
+		std::atomic<uint64_t> interpolations;
+		std::atomic<uint64_t> misses;
+		std::atomic<uint64_t> contentions;
+	};
+}
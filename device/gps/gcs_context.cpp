@@ -0,0 +1,214 @@
+#include "fp_contract.hpp" // before `gcs_ellipsoid()`, which must match its constexpr evaluation in the datum specializations
+
+#include <cmath>
+#include <mutex>
+
+#include "device/gps/gcs_context.hpp"
+
+using namespace WarGrey::DTPM;
+
+static const double pi = 3.14159265358979323846;
+static const double radians_per_degree = pi / 180.0;
+static const double radians_per_arcsecond = pi / 648000.0;
+
+static const size_t gcs_context_slot_count = 8;
+
+/*************************************************************************************************/
+namespace {
+	inline uint64_t fnv1a_double(uint64_t hash, double v) {
+		union { double d; uint64_t u; } bits;
+
+		bits.d = v + 0.0; // +0.0 and -0.0 should not make difference
+
+		for (int shift = 0; shift < 64; shift += 8) {
+			hash ^= (bits.u >> shift) & 0xFFU;
+			hash *= 0x100000001B3ULL;
+		}
+
+		return hash;
+	}
+
+	struct GCSDatumRecord {
+		GCSDatum datum;
+		double a;
+		double f;
+	};
+
+	static const GCSDatumRecord datums[] = {
+		{ GCSDatum::WGS84, GCSDatumEllipsoid<GCSDatum::WGS84>::a, GCSDatumEllipsoid<GCSDatum::WGS84>::f },
+		{ GCSDatum::CGCS2000, GCSDatumEllipsoid<GCSDatum::CGCS2000>::a, GCSDatumEllipsoid<GCSDatum::CGCS2000>::f },
+		{ GCSDatum::Beijing54, GCSDatumEllipsoid<GCSDatum::Beijing54>::a, GCSDatumEllipsoid<GCSDatum::Beijing54>::f },
+		{ GCSDatum::Xian80, GCSDatumEllipsoid<GCSDatum::Xian80>::a, GCSDatumEllipsoid<GCSDatum::Xian80>::f }
+	};
+
+	struct GCSContextSlot {
+		std::shared_ptr<const GCSContext> context;
+		uint64_t last_used;
+	};
+
+	static std::mutex gcs_context_lock;
+	static GCSContextSlot gcs_context_slots[gcs_context_slot_count];
+	static uint64_t gcs_context_tick = 0;
+
+	// `gcs_context_lock` should be held
+	static std::shared_ptr<const GCSContext> gcs_context_find(const GCSParameter& gcs, uint64_t hash) {
+		std::shared_ptr<const GCSContext> ctx = nullptr;
+
+		for (size_t idx = 0; idx < gcs_context_slot_count; idx++) {
+			GCSContextSlot* slot = &gcs_context_slots[idx];
+
+			if ((slot->context != nullptr) && (slot->context->hash == hash) && gcs_parameter_equal(slot->context->parameter, gcs)) {
+				slot->last_used = ++gcs_context_tick;
+				ctx = slot->context;
+				break;
+			}
+		}
+
+		return ctx;
+	}
+}
+
+/*************************************************************************************************/
+uint64_t WarGrey::DTPM::gcs_parameter_hash(const GCSParameter& gcs) {
+	uint64_t hash = 0xCBF29CE484222325ULL;
+
+	hash = fnv1a_double(hash, gcs.a);
+	hash = fnv1a_double(hash, gcs.f);
+	hash = fnv1a_double(hash, gcs.cm);
+	hash = fnv1a_double(hash, gcs.cs_tx);
+	hash = fnv1a_double(hash, gcs.cs_ty);
+	hash = fnv1a_double(hash, gcs.cs_tz);
+	hash = fnv1a_double(hash, gcs.cs_s);
+	hash = fnv1a_double(hash, gcs.cs_rx);
+	hash = fnv1a_double(hash, gcs.cs_ry);
+	hash = fnv1a_double(hash, gcs.cs_rz);
+	hash = fnv1a_double(hash, gcs.gk_dx);
+	hash = fnv1a_double(hash, gcs.gk_dy);
+	hash = fnv1a_double(hash, gcs.gk_dz);
+	hash = fnv1a_double(hash, gcs.utm_s);
+
+	return hash;
+}
+
+bool WarGrey::DTPM::gcs_parameter_equal(const GCSParameter& lhs, const GCSParameter& rhs) {
+	return (lhs.a == rhs.a) && (lhs.f == rhs.f) && (lhs.cm == rhs.cm)
+		&& (lhs.cs_tx == rhs.cs_tx) && (lhs.cs_ty == rhs.cs_ty) && (lhs.cs_tz == rhs.cs_tz) && (lhs.cs_s == rhs.cs_s)
+		&& (lhs.cs_rx == rhs.cs_rx) && (lhs.cs_ry == rhs.cs_ry) && (lhs.cs_rz == rhs.cs_rz)
+		&& (lhs.gk_dx == rhs.gk_dx) && (lhs.gk_dy == rhs.gk_dy) && (lhs.gk_dz == rhs.gk_dz) && (lhs.utm_s == rhs.utm_s);
+}
+
+GCSDatum WarGrey::DTPM::gcs_datum(const GCSParameter& gcs) {
+	GCSDatum datum = GCSDatum::_;
+
+	for (size_t idx = 0; idx < sizeof(datums) / sizeof(GCSDatumRecord); idx++) {
+		if ((gcs.a == datums[idx].a) && ((gcs.f == datums[idx].f) || (gcs.f == 1.0 / datums[idx].f))) {
+			datum = datums[idx].datum;
+			break;
+		}
+	}
+
+	return datum;
+}
+
+void WarGrey::DTPM::gcs_context_fill(GCSContext* c, const GCSParameter& gcs) {
+	GCSEllipsoid ellipsoid = gcs_ellipsoid(gcs.a, gcs.f);
+	double s = 1.0 + gcs.cs_s * 1e-6;
+	double rx = gcs.cs_rx * radians_per_arcsecond;
+	double ry = gcs.cs_ry * radians_per_arcsecond;
+	double rz = gcs.cs_rz * radians_per_arcsecond;
+
+	c->parameter = gcs;
+	c->datum = gcs_datum(gcs);
+	c->hash = gcs_parameter_hash(gcs);
+
+	c->a = ellipsoid.a;
+	c->b = ellipsoid.b;
+	c->e2 = ellipsoid.e2;
+	c->ep2 = ellipsoid.ep2;
+
+	c->L0 = gcs.cm * radians_per_degree;
+	c->sinL0 = sin(c->L0);
+	c->cosL0 = cos(c->L0);
+	c->k0 = ((gcs.utm_s > 0.0) ? gcs.utm_s : 1.0);
+	c->dx = gcs.gk_dx;
+	c->dy = gcs.gk_dy;
+	c->dz = gcs.gk_dz;
+
+	for (size_t idx = 0; idx < sizeof(c->arc) / sizeof(double); idx++) {
+		c->arc[idx] = ellipsoid.arc[idx];
+	}
+
+	for (size_t idx = 0; idx < sizeof(c->footpoint) / sizeof(double); idx++) {
+		c->footpoint[idx] = ellipsoid.footpoint[idx];
+	}
+
+	c->m[0] = s;       c->m[1] = s * rz;  c->m[2] = -s * ry;
+	c->m[3] = -s * rz; c->m[4] = s;       c->m[5] = s * rx;
+	c->m[6] = s * ry;  c->m[7] = -s * rx; c->m[8] = s;
+
+	c->t[0] = gcs.cs_tx;
+	c->t[1] = gcs.cs_ty;
+	c->t[2] = gcs.cs_tz;
+
+	{ // invert the rotation-scale matrix by cofactors
+		const double* m = c->m;
+		double c0 = m[4] * m[8] - m[5] * m[7];
+		double c1 = m[5] * m[6] - m[3] * m[8];
+		double c2 = m[3] * m[7] - m[4] * m[6];
+		double det = m[0] * c0 + m[1] * c1 + m[2] * c2;
+
+		c->minv[0] = c0 / det;
+		c->minv[1] = (m[2] * m[7] - m[1] * m[8]) / det;
+		c->minv[2] = (m[1] * m[5] - m[2] * m[4]) / det;
+		c->minv[3] = c1 / det;
+		c->minv[4] = (m[0] * m[8] - m[2] * m[6]) / det;
+		c->minv[5] = (m[2] * m[3] - m[0] * m[5]) / det;
+		c->minv[6] = c2 / det;
+		c->minv[7] = (m[1] * m[6] - m[0] * m[7]) / det;
+		c->minv[8] = (m[0] * m[4] - m[1] * m[3]) / det;
+	}
+}
+
+std::shared_ptr<const GCSContext> WarGrey::DTPM::gcs_compile(const GCSParameter& gcs) {
+	uint64_t hash = gcs_parameter_hash(gcs);
+	std::shared_ptr<const GCSContext> ctx;
+
+	{ // lookup
+		std::unique_lock<std::mutex> guard(gcs_context_lock);
+
+		ctx = gcs_context_find(gcs, hash);
+	}
+
+	/** NOTE
+	 * Contexts are compiled outside the lock, lookups of other parameters need not wait for it,
+	 *   then the table is checked again, along with choosing the victim, in the same critical section as inserting,
+	 *   so that concurrent misses neither insert the same parameter twice nor evict a slot just filled.
+	 */
+	if (ctx == nullptr) {
+		std::shared_ptr<GCSContext> compiled = std::make_shared<GCSContext>();
+
+		gcs_context_fill(compiled.get(), gcs);
+
+		{ // evict the least recently used one
+			std::unique_lock<std::mutex> guard(gcs_context_lock);
+
+			ctx = gcs_context_find(gcs, hash);
+
+			if (ctx == nullptr) {
+				size_t victim = 0;
+
+				for (size_t idx = 1; idx < gcs_context_slot_count; idx++) {
+					if (gcs_context_slots[idx].last_used < gcs_context_slots[victim].last_used) {
+						victim = idx;
+					}
+				}
+
+				ctx = compiled;
+				gcs_context_slots[victim].context = ctx;
+				gcs_context_slots[victim].last_used = ++gcs_context_tick;
+			}
+		}
+	}
+
+	return ctx;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include "cs/wgs_xy.hpp"
+
+namespace WarGrey::DTPM {
+	/**
+	 * Ellipsoids the editor almost always holds, `_` for anything else.
+	 */
+	enum class GCSDatum : uint8_t { WGS84, CGCS2000, Beijing54, Xian80, _ };
+
+	/**
+	 * Constants of the local ellipsoid, see `GCSContext` for the meaning of fields.
+	 */
+	struct GCSEllipsoid {
+		double a;
+		double b;
+		double e2;
+		double ep2;
+		double arc[5];
+		double footpoint[4];
+	};
+
+	constexpr double gcs_sqrt(double x) {
+		double r = ((x > 1.0) ? x : 1.0);
+		double last = 0.0;
+
+		while (r != last) { // Newton's iteration decreases monotonically from above
+			last = r;
+			r = 0.5 * (r + x / r);
+
+			if (r >= last) {
+				break;
+			}
+		}
+
+		return ((x > 0.0) ? r : 0.0);
+	}
+
+	/**
+	 * Also used by `gcs_context_fill()`, so that coefficients of the specialized kernels are bit-identical to the runtime ones.
+	 */
+	constexpr WarGrey::DTPM::GCSEllipsoid gcs_ellipsoid(double a, double f) {
+		WarGrey::DTPM::GCSEllipsoid ellipsoid = {};
+		double flattening = ((f > 1.0) ? (1.0 / f) : f);
+		double e2 = flattening * (2.0 - flattening);
+		double e4 = e2 * e2;
+		double e6 = e4 * e2;
+		double e8 = e6 * e2;
+		double ma = a * (1.0 - e2);
+		double e1 = (1.0 - gcs_sqrt(1.0 - e2)) / (1.0 + gcs_sqrt(1.0 - e2));
+
+		ellipsoid.a = a;
+		ellipsoid.b = a * (1.0 - flattening);
+		ellipsoid.e2 = e2;
+		ellipsoid.ep2 = e2 / (1.0 - e2);
+
+		ellipsoid.arc[0] = ma * (1.0 + 3.0 / 4.0 * e2 + 45.0 / 64.0 * e4 + 175.0 / 256.0 * e6 + 11025.0 / 16384.0 * e8);
+		ellipsoid.arc[1] = ma * -(3.0 / 4.0 * e2 + 15.0 / 16.0 * e4 + 525.0 / 512.0 * e6 + 2205.0 / 2048.0 * e8) / 2.0;
+		ellipsoid.arc[2] = ma * (15.0 / 64.0 * e4 + 105.0 / 256.0 * e6 + 2205.0 / 4096.0 * e8) / 4.0;
+		ellipsoid.arc[3] = ma * -(35.0 / 512.0 * e6 + 315.0 / 2048.0 * e8) / 6.0;
+		ellipsoid.arc[4] = ma * (315.0 / 16384.0 * e8) / 8.0;
+
+		ellipsoid.footpoint[0] = 3.0 / 2.0 * e1 - 27.0 / 32.0 * e1 * e1 * e1;
+		ellipsoid.footpoint[1] = 21.0 / 16.0 * e1 * e1 - 55.0 / 32.0 * e1 * e1 * e1 * e1;
+		ellipsoid.footpoint[2] = 151.0 / 96.0 * e1 * e1 * e1;
+		ellipsoid.footpoint[3] = 1097.0 / 512.0 * e1 * e1 * e1 * e1;
+
+		return ellipsoid;
+	}
+
+	template<WarGrey::DTPM::GCSDatum D> struct GCSDatumEllipsoid;
+	template<> struct GCSDatumEllipsoid<GCSDatum::WGS84> { static constexpr double a = 6378137.0; static constexpr double f = 298.257223563; };
+	template<> struct GCSDatumEllipsoid<GCSDatum::CGCS2000> { static constexpr double a = 6378137.0; static constexpr double f = 298.257222101; };
+	template<> struct GCSDatumEllipsoid<GCSDatum::Beijing54> { static constexpr double a = 6378245.0; static constexpr double f = 298.3; };
+	template<> struct GCSDatumEllipsoid<GCSDatum::Xian80> { static constexpr double a = 6378140.0; static constexpr double f = 298.257; };
+
+	/**
+	 * Immutable constants derived from a `GCSParameter`,
+	 *   built once per parameter set so that converting a point costs nothing but the projection arithmetic.
+	 */
+	struct GCSContext {
+		WarGrey::DTPM::GCSParameter parameter;
+		WarGrey::DTPM::GCSDatum datum;
+		uint64_t hash;
+
+		// the local ellipsoid
+		double a;
+		double b;
+		double e2;
+		double ep2;
+
+		// the Gauss-Krüger projection
+		double L0;
+		double sinL0;
+		double cosL0;
+		double k0;
+		double dx;
+		double dy;
+		double dz;
+
+		// a(1 - e^2) * { A0, -A2/2, A4/4, -A6/6, A8/8 } of the meridian arc series
+		double arc[5];
+
+		// coefficients of sin(2mu), sin(4mu), sin(6mu), sin(8mu) of the footpoint latitude series, mu is the rectifying latitude
+		double footpoint[4];
+
+		// Bursa-Wolf, (1 + S) * R and its inverse
+		double m[9];
+		double minv[9];
+		double t[3];
+	};
+
+	/**
+	 * The datum whose `a` and `f` match exactly, `f` could be either the inverse flattening or the flattening.
+	 */
+	WarGrey::DTPM::GCSDatum gcs_datum(const WarGrey::DTPM::GCSParameter& gcs);
+
+	uint64_t gcs_parameter_hash(const WarGrey::DTPM::GCSParameter& gcs);
+	bool gcs_parameter_equal(const WarGrey::DTPM::GCSParameter& lhs, const WarGrey::DTPM::GCSParameter& rhs);
+
+	void gcs_context_fill(WarGrey::DTPM::GCSContext* ctx, const WarGrey::DTPM::GCSParameter& gcs);
+
+	/**
+	 * Contexts are shared among all callers (the editor, the live positioning path, ...) in a small table keyed by the parameter hash,
+	 *   the table is protected by a lock, look it up once per parameter set rather than once per point.
+	 */
+	std::shared_ptr<const WarGrey::DTPM::GCSContext> gcs_compile(const WarGrey::DTPM::GCSParameter& gcs);
+}
@@ -0,0 +1,464 @@
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include "device/gps/helmert.hpp"
+
+#include "project/parallel.hpp"
+
+using namespace WarGrey::SCADA;
+using namespace WarGrey::DTPM;
+
+static const double wgs84_a = 6378137.0;
+static const double wgs84_f = 1.0 / 298.257223563;
+static const double wgs84_e2 = wgs84_f * (2.0 - wgs84_f);
+
+static const double pi = 3.14159265358979323846;
+static const double radians_per_degree = pi / 180.0;
+static const double radians_per_arcsecond = pi / 648000.0;
+
+static const size_t helmert_points_per_thread = 2048;
+static const size_t helmert_max_iterations = 16;
+
+/*************************************************************************************************/
+namespace {
+	struct NormalEquation {
+		double N[7][7];
+		double u[7];
+	};
+
+	static inline double nmea_to_radians(double ddmm) {
+		double d = floor(fabs(ddmm) / 100.0);
+		double rad = (d + (fabs(ddmm) - d * 100.0) / 60.0) * radians_per_degree;
+
+		return ((ddmm < 0.0) ? -rad : rad);
+	}
+
+	static inline void wgs84_ecef(double latitude, double longitude, double altitude, double* X, double* Y, double* Z) {
+		double B = nmea_to_radians(latitude);
+		double L = nmea_to_radians(longitude);
+		double sinB = sin(B);
+		double N = wgs84_a / sqrt(1.0 - wgs84_e2 * sinB * sinB);
+		double r = (N + altitude) * cos(B);
+
+		(*X) = r * cos(L);
+		(*Y) = r * sin(L);
+		(*Z) = (N * (1.0 - wgs84_e2) + altitude) * sinB;
+	}
+
+	static bool cholesky_solve(double N[7][7], double u[7], size_t n, double x[7]) {
+		double L[7][7];
+		double y[7];
+
+		memset(L, 0, sizeof(L));
+
+		for (size_t j = 0; j < n; j++) {
+			double d = N[j][j];
+
+			for (size_t k = 0; k < j; k++) {
+				d -= L[j][k] * L[j][k];
+			}
+
+			if (!(d > N[j][j] * 1e-14) || !(d > 0.0)) { // not positive definite, or numerically singular
+				return false;
+			}
+
+			L[j][j] = sqrt(d);
+
+			for (size_t i = j + 1; i < n; i++) {
+				double s = N[i][j];
+
+				for (size_t k = 0; k < j; k++) {
+					s -= L[i][k] * L[j][k];
+				}
+
+				L[i][j] = s / L[j][j];
+			}
+		}
+
+		for (size_t i = 0; i < n; i++) {
+			double s = u[i];
+
+			for (size_t k = 0; k < i; k++) {
+				s -= L[i][k] * y[k];
+			}
+
+			y[i] = s / L[i][i];
+		}
+
+		for (size_t i = n; i > 0; i--) {
+			double s = y[i - 1];
+
+			for (size_t k = i; k < n; k++) {
+				s -= L[k][i - 1] * x[k];
+			}
+
+			x[i - 1] = s / L[i - 1][i - 1];
+		}
+
+		return true;
+	}
+
+	/**
+	 * Gauss-Newton on the Bursa-Wolf model with centroid-reduced coordinates:
+	 *   local = (1 + d) * R(rx, ry, rz) * (wgs - centroid) + t',  t = t' - (1 + d) * R * centroid;
+	 * the scale and rotations are solved as `d * sigma` and `r * sigma` where `sigma` is the RMS spread of the points.
+	 */
+	static bool bursa_wolf(const double* wXs, const double* wYs, const double* wZs, const double* lXs, const double* lYs, const double* lZs,
+		size_t count, size_t parallelism, GCSParameter* gcs, size_t* iterations) {
+		std::vector<NormalEquation> partials(parallelism);
+		std::vector<double> partial_sums(parallelism * 4);
+		double cx, cy, cz, sigma, p[7];
+
+		parallel_ranges(count, parallelism, [&](size_t tid, size_t start, size_t end) {
+			double* sum = &partial_sums[tid * 4];
+
+			sum[0] = sum[1] = sum[2] = sum[3] = 0.0;
+
+			for (size_t i = start; i < end; i++) {
+				sum[0] += wXs[i];
+				sum[1] += wYs[i];
+				sum[2] += wZs[i];
+			}
+		});
+
+		cx = cy = cz = 0.0;
+		for (size_t i = 0; i < parallelism; i++) {
+			cx += partial_sums[i * 4 + 0];
+			cy += partial_sums[i * 4 + 1];
+			cz += partial_sums[i * 4 + 2];
+		}
+
+		cx /= double(count);
+		cy /= double(count);
+		cz /= double(count);
+
+		parallel_ranges(count, parallelism, [&](size_t tid, size_t start, size_t end) {
+			double* sum = &partial_sums[tid * 4];
+
+			for (size_t i = start; i < end; i++) {
+				double x = wXs[i] - cx;
+				double y = wYs[i] - cy;
+				double z = wZs[i] - cz;
+
+				sum[3] += x * x + y * y + z * z;
+			}
+		});
+
+		sigma = 0.0;
+		for (size_t i = 0; i < parallelism; i++) {
+			sigma += partial_sums[i * 4 + 3];
+		}
+
+		sigma = sqrt(sigma / double(count));
+		memset(p, 0, sizeof(p));
+
+		if (!(sigma > 0.0)) {
+			return false;
+		}
+
+		for ((*iterations) = 1; (*iterations) <= helmert_max_iterations; (*iterations)++) {
+			double s = 1.0 + p[3] / sigma;
+			double rx = p[4] / sigma;
+			double ry = p[5] / sigma;
+			double rz = p[6] / sigma;
+			double delta[7];
+			NormalEquation total;
+			bool converged = true;
+
+			parallel_ranges(count, parallelism, [&](size_t tid, size_t start, size_t end) {
+				NormalEquation* ne = &partials[tid];
+
+				memset(ne, 0, sizeof(NormalEquation));
+
+				for (size_t i = start; i < end; i++) {
+					double x = wXs[i] - cx;
+					double y = wYs[i] - cy;
+					double z = wZs[i] - cz;
+					double Rx = x + rz * y - ry * z;
+					double Ry = -rz * x + y + rx * z;
+					double Rz = ry * x - rx * y + z;
+					double v[3] = { lXs[i] - (s * Rx + p[0]), lYs[i] - (s * Ry + p[1]), lZs[i] - (s * Rz + p[2]) };
+					double J[3][7] = {
+						{ 1.0, 0.0, 0.0, Rx / sigma, 0.0, -s * z / sigma, s * y / sigma },
+						{ 0.0, 1.0, 0.0, Ry / sigma, s * z / sigma, 0.0, -s * x / sigma },
+						{ 0.0, 0.0, 1.0, Rz / sigma, -s * y / sigma, s * x / sigma, 0.0 }
+					};
+
+					for (size_t r = 0; r < 3; r++) {
+						for (size_t j = 0; j < 7; j++) {
+							if (J[r][j] != 0.0) {
+								for (size_t k = 0; k <= j; k++) {
+									ne->N[j][k] += J[r][j] * J[r][k];
+								}
+
+								ne->u[j] += J[r][j] * v[r];
+							}
+						}
+					}
+				}
+			});
+
+			memset(&total, 0, sizeof(NormalEquation));
+			for (size_t t = 0; t < parallelism; t++) {
+				for (size_t j = 0; j < 7; j++) {
+					for (size_t k = 0; k <= j; k++) {
+						total.N[j][k] += partials[t].N[j][k];
+					}
+
+					total.u[j] += partials[t].u[j];
+				}
+			}
+
+			for (size_t j = 0; j < 7; j++) {
+				for (size_t k = j + 1; k < 7; k++) {
+					total.N[j][k] = total.N[k][j];
+				}
+			}
+
+			if (!cholesky_solve(total.N, total.u, 7, delta)) {
+				return false;
+			}
+
+			for (size_t j = 0; j < 7; j++) {
+				p[j] += delta[j];
+				converged = converged && (fabs(delta[j]) < 1e-7); // 0.1 micrometer
+			}
+
+			if (converged) {
+				break;
+			}
+		}
+
+		{ // recover the translation of the geocenter
+			double s = 1.0 + p[3] / sigma;
+			double rx = p[4] / sigma;
+			double ry = p[5] / sigma;
+			double rz = p[6] / sigma;
+
+			gcs->cs_tx = p[0] - s * (cx + rz * cy - ry * cz);
+			gcs->cs_ty = p[1] - s * (-rz * cx + cy + rx * cz);
+			gcs->cs_tz = p[2] - s * (ry * cx - rx * cy + cz);
+			gcs->cs_s = (s - 1.0) * 1e6;
+			gcs->cs_rx = rx / radians_per_arcsecond;
+			gcs->cs_ry = ry / radians_per_arcsecond;
+			gcs->cs_rz = rz / radians_per_arcsecond;
+		}
+
+		(*iterations) = std::min((*iterations), helmert_max_iterations);
+
+		return true;
+	}
+}
+
+/*************************************************************************************************/
+bool WarGrey::DTPM::helmert_solve(const double* Bs, const double* Ls, const double* Hs, const double* xs, const double* ys, const double* zs
+	, size_t count, const GCSParameter& gcs, HelmertSolution* solution, HelmertUnknowns unknowns, size_t parallelism) {
+	GCSParameter parameter = gcs;
+	size_t iterations = 0;
+	bool okay = true;
+
+	parallelism = parallel_degree(count, parallelism, helmert_points_per_thread);
+
+	if (unknowns != HelmertUnknowns::Offsets) {
+		if (count >= 3) {
+			std::vector<double> ecef(count * 6);
+			double* wXs = ecef.data();
+			double* wYs = wXs + count;
+			double* wZs = wYs + count;
+			double* lXs = wZs + count;
+			double* lYs = lXs + count;
+			double* lZs = lYs + count;
+			GCSContext local;
+
+			/** NOTE
+			 * With the datum shift zeroed out, the inverse projection stops at the local ECEF coordinates,
+			 *   which are then reported as if they were WGS84 geodetic ones, converting them back yields the local ECEF.
+			 */
+			parameter.cs_tx = parameter.cs_ty = parameter.cs_tz = 0.0;
+			parameter.cs_s = parameter.cs_rx = parameter.cs_ry = parameter.cs_rz = 0.0;
+			gcs_context_fill(&local, parameter);
+
+			parallel_ranges(count, parallelism, [&](size_t, size_t start, size_t end) {
+				gauss_krueger_inverse(xs + start, ys + start, zs + start, lXs + start, lYs + start, lZs + start, end - start, local, GCSAccuracy::Exact);
+
+				for (size_t i = start; i < end; i++) {
+					wgs84_ecef(Bs[i], Ls[i], Hs[i], &wXs[i], &wYs[i], &wZs[i]);
+					wgs84_ecef(lXs[i], lYs[i], lZs[i], &lXs[i], &lYs[i], &lZs[i]);
+				}
+			});
+
+			okay = bursa_wolf(wXs, wYs, wZs, lXs, lYs, lZs, count, parallelism, &parameter, &iterations);
+		} else {
+			okay = false;
+		}
+	}
+
+	if (okay && (unknowns != HelmertUnknowns::Bursa)) {
+		if (count >= 1) { // the offsets are linear, one step is enough
+			std::vector<double> residuals(count * 3);
+			double* dxs = residuals.data();
+			double* dys = dxs + count;
+			double* dzs = dys + count;
+			double mx = 0.0;
+			double my = 0.0;
+			double mz = 0.0;
+			HelmertSolution offsets;
+
+			helmert_residuals(Bs, Ls, Hs, xs, ys, zs, count, parameter, &offsets, dxs, dys, dzs);
+
+			for (size_t i = 0; i < count; i++) {
+				mx += dxs[i];
+				my += dys[i];
+				mz += dzs[i];
+			}
+
+			parameter.gk_dx += mx / double(count);
+			parameter.gk_dy += my / double(count);
+			parameter.gk_dz += mz / double(count);
+			iterations += 1;
+		} else {
+			okay = false;
+		}
+	}
+
+	if (!okay) {
+		parameter = gcs;
+	}
+
+	helmert_residuals(Bs, Ls, Hs, xs, ys, zs, count, parameter, solution);
+	solution->iterations = iterations;
+	solution->okay = okay;
+
+	return okay;
+}
+
+void WarGrey::DTPM::helmert_residuals(const double* Bs, const double* Ls, const double* Hs, const double* xs, const double* ys, const double* zs
+	, size_t count, const GCSParameter& gcs, HelmertSolution* solution, double* dxs, double* dys, double* dzs) {
+	std::shared_ptr<const GCSContext> context = gcs_compile(gcs);
+	std::vector<double> projected(count * 3);
+	double sxx = 0.0;
+	double syy = 0.0;
+	double szz = 0.0;
+
+	memset(solution, 0, sizeof(HelmertSolution));
+	solution->parameter = gcs;
+	solution->points = count;
+	solution->okay = true;
+
+	gauss_krueger_forward(Bs, Ls, Hs, projected.data(), projected.data() + count, projected.data() + count * 2, count, *context);
+
+	for (size_t i = 0; i < count; i++) {
+		double dx = xs[i] - projected[i];
+		double dy = ys[i] - projected[i + count];
+		double dz = zs[i] - projected[i + count * 2];
+		double horizontal = sqrt(dx * dx + dy * dy);
+
+		if (dxs != nullptr) dxs[i] = dx;
+		if (dys != nullptr) dys[i] = dy;
+		if (dzs != nullptr) dzs[i] = dz;
+
+		sxx += dx * dx;
+		syy += dy * dy;
+		szz += dz * dz;
+
+		if (horizontal > solution->max_horizontal) {
+			solution->max_horizontal = horizontal;
+			solution->worst = i;
+		}
+
+		solution->max_vertical = std::max(solution->max_vertical, fabs(dz));
+	}
+
+	if (count > 0) {
+		solution->rms_x = sqrt(sxx / double(count));
+		solution->rms_y = sqrt(syy / double(count));
+		solution->rms_z = sqrt(szz / double(count));
+	}
+}
+
+/*************************************************************************************************/
+#ifdef HELMERT_MAIN
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+	struct HelmertCase {
+		const char* name;
+		GCSParameter truth;
+		double latitude;  // degrees, the center of the survey area
+		double longitude;
+	};
+
+	static inline double degrees_to_nmea(double deg) {
+		double d = floor(fabs(deg));
+		double ddmm = d * 100.0 + (fabs(deg) - d) * 60.0;
+
+		return ((deg < 0.0) ? -ddmm : ddmm);
+	}
+}
+
+/**
+ * Synthesizes `count` (5000 by default) control points in a survey area of `span` degrees (0.2 by default) from known parameters,
+ *   solves the seven parameters starting from zeros, and checks that they are recovered, then times the solver.
+ */
+int main(int argc, char* argv[]) {
+	size_t count = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 5000U);
+	double span = ((argc > 2) ? strtod(argv[2], nullptr) : 0.2);
+	const size_t rounds = 10;
+	const HelmertCase cases[] = {
+		{ "Beijing54 GK-6 117E", { 6378245.0, 298.3, 117.0, -15.415, 157.025, 94.74, 1.3, 0.312, 0.08, -0.102, 0.0, 500000.0, 0.0, 1.0 }, 39.9, 116.4 },
+		{ "Xian80 GK-3 114E", { 6378140.0, 298.257, 114.0, 24.0, -123.0, -94.0, -2.4, 0.02, -0.25, 0.13, 0.0, 500000.0, 0.0, 1.0 }, 22.5, 114.1 },
+		{ "SAD69 UTM 23S", { 6378160.0, 298.25, -45.0, 67.35, -3.88, 38.22, 0.0, 0.0, 0.0, 0.0, 10000000.0, 500000.0, 0.0, 0.9996 }, -23.5, -46.6 }
+	};
+	int status = 0;
+
+	for (size_t c = 0; c < sizeof(cases) / sizeof(HelmertCase); c++) {
+		const HelmertCase& hc = cases[c];
+		std::shared_ptr<const GCSContext> truth = gcs_compile(hc.truth);
+		std::vector<double> Bs(count), Ls(count), Hs(count), xs(count), ys(count), zs(count);
+		std::mt19937_64 prng(c);
+		std::uniform_real_distribution<double> latitude(hc.latitude - span * 0.5, hc.latitude + span * 0.5);
+		std::uniform_real_distribution<double> longitude(hc.longitude - span * 0.5, hc.longitude + span * 0.5);
+		std::uniform_real_distribution<double> altitude(-20.0, 80.0);
+		GCSParameter guess = hc.truth;
+		HelmertSolution solution;
+		double best = 1e300;
+		double dt, ds, dr;
+		bool okay = true;
+
+		for (size_t i = 0; i < count; i++) {
+			Bs[i] = degrees_to_nmea(latitude(prng));
+			Ls[i] = degrees_to_nmea(longitude(prng));
+			Hs[i] = altitude(prng);
+		}
+
+		gauss_krueger_forward(Bs.data(), Ls.data(), Hs.data(), xs.data(), ys.data(), zs.data(), count, *truth);
+		guess.cs_tx = guess.cs_ty = guess.cs_tz = 0.0;
+		guess.cs_s = guess.cs_rx = guess.cs_ry = guess.cs_rz = 0.0;
+
+		for (size_t r = 0; r < rounds; r++) {
+			auto t0 = std::chrono::steady_clock::now();
+			okay = helmert_solve(Bs.data(), Ls.data(), Hs.data(), xs.data(), ys.data(), zs.data(), count, guess, &solution) && okay;
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+		}
+
+		dt = std::max(fabs(solution.parameter.cs_tx - hc.truth.cs_tx), std::max(fabs(solution.parameter.cs_ty - hc.truth.cs_ty), fabs(solution.parameter.cs_tz - hc.truth.cs_tz)));
+		ds = fabs(solution.parameter.cs_s - hc.truth.cs_s);
+		dr = std::max(fabs(solution.parameter.cs_rx - hc.truth.cs_rx), std::max(fabs(solution.parameter.cs_ry - hc.truth.cs_ry), fabs(solution.parameter.cs_rz - hc.truth.cs_rz)));
+
+		printf("%-20s %zu points: %8.2f ms (best of %zu), %zu iterations, |dT| %.2e m, |dS| %.2e ppm, |dR| %.2e\", max residual %.3f mm\n",
+			hc.name, count, best, rounds, solution.iterations, dt, ds, dr, solution.max_horizontal * 1000.0);
+
+		// parameters far below what a survey can tell apart, and residuals within the round trip of the projection
+		if ((!okay) || (dt > 1e-3) || (ds > 1e-3) || (dr > 1e-4) || (solution.max_horizontal > 1e-3)) {
+			status = 1;
+		}
+	}
+
+	return status;
+}
+#endif
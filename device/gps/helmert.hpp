@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+
+#include "device/gps/gauss_krueger.hpp"
+
+namespace WarGrey::DTPM {
+	/**
+	 * Bursa:   the seven parameters `cs_tx`, `cs_ty`, `cs_tz`, `cs_s`, `cs_rx`, `cs_ry`, `cs_rz`;
+	 * Offsets: `gk_dx`, `gk_dy`, `gk_dz` only, the seven parameters are held as given;
+	 * Both:    the seven parameters, then the offsets absorb whatever they leave in the mean.
+	 */
+	enum class HelmertUnknowns { Bursa, Offsets, Both };
+
+	struct HelmertSolution {
+		WarGrey::DTPM::GCSParameter parameter;
+		size_t points;
+		size_t iterations;
+		bool okay;
+
+		// residuals of the control points on the projection plane, meter
+		double rms_x;
+		double rms_y;
+		double rms_z;
+		double max_horizontal;
+		double max_vertical;
+		size_t worst;
+	};
+
+	/**
+	 * Estimates the datum shift from control points known both in WGS84 (NMEA-styled `ddmm.mmmm` and ellipsoidal height)
+	 *   and in the local coordinate system (the Gauss-Krüger plane, the same as what the editor displays),
+	 *   the ellipsoid, the central meridian and the scale factor are taken from `gcs`, so are the parameters that are not solved.
+	 *
+	 * The Bursa-Wolf model is solved by Gauss-Newton on normal equations in the geocentric frame,
+	 *   coordinates are reduced to their centroid and the scale and rotations are normalized by the spread of the points,
+	 *   so that the 7x7 system stays well conditioned for Cholesky even if all points lie within a few kilometers.
+	 * Points are split among `parallelism` threads (0 for as many as the hardware has), partial normal equations are summed up.
+	 *
+	 * At least 3 points are required for the seven parameters and 1 point for the offsets,
+	 *   `okay` is false if they are not enough or the points are degenerated (e.g. collinear).
+	 */
+	bool helmert_solve(const double* latitudes, const double* longitudes, const double* altitudes,
+		const double* xs, const double* ys, const double* zs, size_t count,
+		const WarGrey::DTPM::GCSParameter& gcs, WarGrey::DTPM::HelmertSolution* solution,
+		WarGrey::DTPM::HelmertUnknowns unknowns = WarGrey::DTPM::HelmertUnknowns::Bursa, size_t parallelism = 0);
+
+	/**
+	 * Residuals (local minus projected) of the control points under `gcs`, the statistics go into `solution`,
+	 *   `dxs`, `dys` and `dzs` receive the residual of each point if they are not null.
+	 */
+	void helmert_residuals(const double* latitudes, const double* longitudes, const double* altitudes,
+		const double* xs, const double* ys, const double* zs, size_t count,
+		const WarGrey::DTPM::GCSParameter& gcs, WarGrey::DTPM::HelmertSolution* solution,
+		double* dxs = nullptr, double* dys = nullptr, double* dzs = nullptr);
+}
@@ -0,0 +1,523 @@
+#include <chrono>
+#include <vector>
+#include <cstring>
+
+#include "device/gps/nmea.hpp"
+
+using namespace WarGrey::DTPM;
+
+static const size_t nmea_max_field_count = 24;
+
+static const double pow10s[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+/*************************************************************************************************/
+namespace {
+	struct NMEAField {
+		const char* begin;
+		const char* end;
+	};
+
+	inline int hexdigit(char ch) {
+		int d = -1;
+
+		if ((ch >= '0') && (ch <= '9')) {
+			d = ch - '0';
+		} else if ((ch >= 'A') && (ch <= 'F')) {
+			d = ch - 'A' + 10;
+		} else if ((ch >= 'a') && (ch <= 'f')) {
+			d = ch - 'a' + 10;
+		}
+
+		return d;
+	}
+
+	/**
+	 * The mantissa is accumulated as an integer and scaled once,
+	 *   that is exact for the 15 significant digits NMEA could ever carry.
+	 */
+	static bool field_decimal(const NMEAField& f, double* v) {
+		const char* p = f.begin;
+		uint64_t mantissa = 0;
+		size_t digits = 0;
+		size_t fraction = 0;
+		bool negative = false;
+		bool dotted = false;
+
+		if (p < f.end) {
+			if ((*p == '-') || (*p == '+')) {
+				negative = (*p == '-');
+				p++;
+			}
+		}
+
+		for (; p < f.end; p++) {
+			if ((*p >= '0') && (*p <= '9')) {
+				if (digits < 18) {
+					mantissa = mantissa * 10U + uint64_t(*p - '0');
+					digits++;
+					fraction += (dotted ? 1 : 0);
+				} else if (!dotted) {
+					return false;
+				}
+			} else if ((*p == '.') && !dotted) {
+				dotted = true;
+			} else {
+				return false;
+			}
+		}
+
+		if ((digits == 0) || (fraction >= sizeof(pow10s) / sizeof(double))) {
+			return false;
+		}
+
+		(*v) = double(mantissa) / pow10s[fraction];
+
+		if (negative) {
+			(*v) = -(*v);
+		}
+
+		return true;
+	}
+
+	static bool field_unsigned(const NMEAField& f, unsigned int* v) {
+		unsigned int n = 0;
+
+		if (f.begin == f.end) {
+			return false;
+		}
+
+		for (const char* p = f.begin; p < f.end; p++) {
+			if ((*p < '0') || (*p > '9')) {
+				return false;
+			}
+
+			n = n * 10U + (unsigned int)(*p - '0');
+		}
+
+		(*v) = n;
+
+		return true;
+	}
+
+	inline char field_char(const NMEAField& f) {
+		return ((f.begin < f.end) ? f.begin[0] : '\0');
+	}
+
+	static double field_utc(const NMEAField& f, bool* okay) {
+		double hhmmss = 0.0;
+		double seconds = 0.0;
+
+		(*okay) = field_decimal(f, &hhmmss);
+
+		if (*okay) {
+			double hh = double(int(hhmmss / 10000.0));
+			double mm = double(int((hhmmss - hh * 10000.0) / 100.0));
+
+			seconds = hh * 3600.0 + mm * 60.0 + (hhmmss - hh * 10000.0 - mm * 100.0);
+		}
+
+		return seconds;
+	}
+
+	static bool field_position(const NMEAField& v, const NMEAField& hemisphere, char negative, double* ddmm) {
+		bool okay = field_decimal(v, ddmm);
+
+		if (okay) {
+			if (field_char(hemisphere) == negative) {
+				(*ddmm) = -(*ddmm);
+			}
+		}
+
+		return okay;
+	}
+
+	static NMEASentence sentence_type(const NMEAField& address) {
+		NMEASentence type = NMEASentence::_;
+
+		if ((address.end - address.begin) >= 5) { // talker id + sentence formatter
+			const char* s = address.end - 3;
+
+			if (memcmp(s, "GGA", 3) == 0) {
+				type = NMEASentence::GGA;
+			} else if (memcmp(s, "RMC", 3) == 0) {
+				type = NMEASentence::RMC;
+			} else if (memcmp(s, "HDT", 3) == 0) {
+				type = NMEASentence::HDT;
+			} else if (memcmp(s, "VTG", 3) == 0) {
+				type = NMEASentence::VTG;
+			}
+		}
+
+		return type;
+	}
+}
+
+/*************************************************************************************************/
+GPSFixRing::GPSFixRing(size_t capacity) : head(0), tail(0) {
+	size_t size = 2;
+
+	while (size < capacity) {
+		size <<= 1;
+	}
+
+	this->fixes = new GPSFix[size];
+	this->mask = size - 1;
+}
+
+GPSFixRing::~GPSFixRing() {
+	delete[] this->fixes;
+}
+
+bool GPSFixRing::push(const GPSFix& fix) {
+	size_t t = this->tail.load(std::memory_order_relaxed);
+	bool okay = (t - this->head.load(std::memory_order_acquire) <= this->mask);
+
+	if (okay) {
+		this->fixes[t & this->mask] = fix;
+		this->tail.store(t + 1, std::memory_order_release);
+	}
+
+	return okay;
+}
+
+size_t GPSFixRing::pop(GPSFix* dest, size_t count) {
+	size_t h = this->head.load(std::memory_order_relaxed);
+	size_t available = this->tail.load(std::memory_order_acquire) - h;
+	size_t n = ((count < available) ? count : available);
+
+	for (size_t i = 0; i < n; i++) {
+		dest[i] = this->fixes[(h + i) & this->mask];
+	}
+
+	this->head.store(h + n, std::memory_order_release);
+
+	return n;
+}
+
+size_t GPSFixRing::size() {
+	return this->tail.load(std::memory_order_acquire) - this->head.load(std::memory_order_acquire);
+}
+
+size_t GPSFixRing::capacity() {
+	return this->mask + 1;
+}
+
+/*************************************************************************************************/
+NMEAStream::NMEAStream(GPSFixRing* sink, uint16_t antenna) : sink(sink), gga_available(false), carry_size(0) {
+	memset(&this->stats, 0, sizeof(NMEAStatistics));
+	memset(&this->current, 0, sizeof(GPSFix));
+
+	this->current.antenna = antenna;
+}
+
+const NMEAStatistics& NMEAStream::statistics() {
+	return this->stats;
+}
+
+size_t NMEAStream::feed(const char* data, size_t size) {
+	const char* end = data + size;
+	const char* cursor = data;
+	uint64_t sentences0 = this->stats.sentences;
+
+	this->stats.bytes += size;
+
+	if (this->carry_size > 0) { // complete the sentence left by the last buffer
+		const char* nl = (const char*)memchr(cursor, '\n', size);
+		size_t rest = ((nl == nullptr) ? size : size_t(nl - cursor));
+
+		if (this->carry_size + rest > sizeof(this->carry)) {
+			this->stats.malformed++;
+			this->carry_size = 0;
+		} else {
+			memcpy(this->carry + this->carry_size, cursor, rest);
+			this->carry_size += rest;
+		}
+
+		if (nl == nullptr) {
+			return 0;
+		}
+
+		if (this->carry_size > 0) {
+			this->on_sentence(this->carry, this->carry + this->carry_size);
+			this->carry_size = 0;
+		}
+
+		cursor = nl + 1;
+	}
+
+	while (cursor < end) {
+		const char* dollar = (const char*)memchr(cursor, '$', size_t(end - cursor));
+		const char* nl = nullptr;
+
+		if (dollar == nullptr) {
+			break;
+		}
+
+		nl = (const char*)memchr(dollar, '\n', size_t(end - dollar));
+
+		if (nl == nullptr) {
+			size_t rest = size_t(end - dollar);
+
+			if (rest <= sizeof(this->carry)) {
+				memcpy(this->carry, dollar, rest);
+				this->carry_size = rest;
+			} else {
+				this->stats.malformed++;
+			}
+
+			break;
+		}
+
+		this->on_sentence(dollar, nl);
+		cursor = nl + 1;
+	}
+
+	return size_t(this->stats.sentences - sentences0);
+}
+
+void NMEAStream::on_sentence(const char* s, const char* end) {
+	NMEAField fields[nmea_max_field_count];
+	size_t count = 0;
+	const char* star = nullptr;
+	uint8_t checksum = 0;
+
+	while ((end > s) && ((end[-1] == '\r') || (end[-1] == ' '))) {
+		end--;
+	}
+
+	if ((end - s < 4) || (s[0] != '$') || (end[-3] != '*')) {
+		this->stats.malformed++;
+		return;
+	}
+
+	star = end - 3;
+
+	{ // validate the checksum
+		int hi = hexdigit(star[1]);
+		int lo = hexdigit(star[2]);
+
+		for (const char* p = s + 1; p < star; p++) {
+			checksum ^= uint8_t(*p);
+		}
+
+		if ((hi < 0) || (lo < 0) || (checksum != uint8_t(hi * 16 + lo))) {
+			this->stats.checksum_errors++;
+			return;
+		}
+	}
+
+	{ // split fields in place
+		const char* begin = s + 1;
+
+		for (const char* p = begin; p <= star; p++) {
+			if ((p == star) || (*p == ',')) {
+				if (count < nmea_max_field_count) {
+					fields[count].begin = begin;
+					fields[count].end = p;
+					count++;
+				}
+
+				begin = p + 1;
+			}
+		}
+	}
+
+	this->stats.sentences++;
+
+	switch (sentence_type(fields[0])) {
+	case NMEASentence::GGA: {
+		GPSFix* fix = &this->current;
+		unsigned int quality = 0;
+		unsigned int satellites = 0;
+		bool okay = (count >= 10);
+
+		okay = okay && field_unsigned(fields[6], &quality) && (quality > 0);
+
+		if (okay) {
+			fix->utc = field_utc(fields[1], &okay);
+			okay = okay && field_position(fields[2], fields[3], 'S', &fix->latitude);
+			okay = okay && field_position(fields[4], fields[5], 'W', &fix->longitude);
+			okay = okay && field_decimal(fields[9], &fix->altitude);
+		}
+
+		if (okay) {
+			field_unsigned(fields[7], &satellites);
+			fix->quality = uint8_t(quality);
+			fix->satellites = uint8_t(satellites);
+
+			this->gga_available = true;
+			this->on_fix();
+		} else if (quality > 0) {
+			this->stats.malformed++;
+		}
+	}; break;
+	case NMEASentence::RMC: {
+		GPSFix* fix = &this->current;
+		unsigned int date = 0;
+		bool okay = (count >= 10) && (field_char(fields[2]) == 'A');
+
+		if (okay) {
+			double speed, course;
+
+			if (field_unsigned(fields[9], &date)) {
+				fix->date = date;
+			}
+
+			if (field_decimal(fields[7], &speed)) {
+				fix->speed = speed;
+			}
+
+			if (field_decimal(fields[8], &course)) {
+				fix->course = course;
+			}
+
+			if (!this->gga_available) {
+				fix->utc = field_utc(fields[1], &okay);
+				okay = okay && field_position(fields[3], fields[4], 'S', &fix->latitude);
+				okay = okay && field_position(fields[5], fields[6], 'W', &fix->longitude);
+
+				if (okay) {
+					this->on_fix();
+				} else {
+					this->stats.malformed++;
+				}
+			}
+		}
+	}; break;
+	case NMEASentence::HDT: {
+		if ((count < 2) || !field_decimal(fields[1], &this->current.heading)) {
+			this->stats.malformed++;
+		}
+	}; break;
+	case NMEASentence::VTG: {
+		if (count >= 6) {
+			field_decimal(fields[1], &this->current.course);
+			field_decimal(fields[5], &this->current.speed);
+		} else {
+			this->stats.malformed++;
+		}
+	}; break;
+	default: this->stats.unsupported++;
+	}
+}
+
+void NMEAStream::on_fix() {
+	this->stats.fixes++;
+
+	if ((this->sink != nullptr) && (!this->sink->push(this->current))) {
+		this->stats.dropped++;
+	}
+}
+
+/*************************************************************************************************/
+GPSFixBatch::GPSFixBatch(size_t capacity) : count(0), capacity(capacity) {
+	this->fixes = new GPSFix[capacity];
+	this->Bs = new double[capacity * 6];
+	this->Ls = this->Bs + capacity;
+	this->Hs = this->Ls + capacity;
+	this->xs = this->Hs + capacity;
+	this->ys = this->xs + capacity;
+	this->zs = this->ys + capacity;
+}
+
+GPSFixBatch::~GPSFixBatch() {
+	delete[] this->fixes;
+	delete[] this->Bs;
+}
+
+size_t GPSFixBatch::convert(GPSFixRing* source, const GCSContext& gcs) {
+	this->count = source->pop(this->fixes, this->capacity);
+
+	for (size_t i = 0; i < this->count; i++) {
+		this->Bs[i] = this->fixes[i].latitude;
+		this->Ls[i] = this->fixes[i].longitude;
+		this->Hs[i] = this->fixes[i].altitude;
+	}
+
+	gauss_krueger_forward(this->Bs, this->Ls, this->Hs, this->xs, this->ys, this->zs, this->count, gcs);
+
+	return this->count;
+}
+
+/*************************************************************************************************/
+void WarGrey::DTPM::nmea_replay(FILE* source, const GCSContext& gcs, NMEAReplayReport* report, size_t chunk_size) {
+	GPSFixRing ring(4096);
+	GPSFixBatch batch(256);
+	NMEAStream nmea(&ring);
+	std::vector<char> chunk(chunk_size);
+	auto start = std::chrono::steady_clock::now();
+	double first_utc = -1.0;
+	double last_utc = 0.0;
+	double days = 0.0;
+	size_t size = 0;
+
+	memset(report, 0, sizeof(NMEAReplayReport));
+
+	while ((size = fread(chunk.data(), 1, chunk_size, source)) > 0) {
+		nmea.feed(chunk.data(), size);
+
+		while (ring.size() > 0) {
+			batch.convert(&ring, gcs);
+			report->converted += batch.count;
+
+			for (size_t i = 0; i < batch.count; i++) {
+				double utc = batch.fixes[i].utc;
+
+				if (first_utc < 0.0) {
+					first_utc = utc;
+				} else if (utc + 43200.0 < last_utc) { // crossing midnight
+					days += 86400.0;
+				}
+
+				last_utc = utc;
+			}
+		}
+	}
+
+	report->nmea = nmea.statistics();
+	report->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	report->covered_seconds = ((first_utc < 0.0) ? 0.0 : (days + last_utc - first_utc));
+
+	if (report->seconds > 0.0) {
+		report->sentences_per_second = double(report->nmea.sentences) / report->seconds;
+		report->fixes_per_second = double(report->converted) / report->seconds;
+		report->speedup = report->covered_seconds / report->seconds;
+	}
+}
+
+/*************************************************************************************************/
+#ifdef NMEA_REPLAY_MAIN
+#include <cstdlib>
+
+#include "device/gps/gcs_benchmark.hpp"
+
+int main(int argc, char* argv[]) {
+	const char* path = ((argc > 1) ? argv[1] : "-");
+	size_t preset = ((argc > 2) ? size_t(strtoull(argv[2], nullptr, 10)) : 1U);
+	size_t preset_count;
+	const GCSBenchmarkPreset* ps = gcs_benchmark_presets(&preset_count);
+	FILE* source = ((strcmp(path, "-") == 0) ? stdin : fopen(path, "rb"));
+	NMEAReplayReport r;
+
+	if ((source == nullptr) || (preset >= preset_count)) {
+		fprintf(stderr, "usage: %s [path | -] [preset < %u]\n", argv[0], (unsigned int)preset_count);
+		return 1;
+	}
+
+	nmea_replay(source, *gcs_compile(ps[preset].parameter), &r);
+
+	printf("%s: %llu bytes, %llu sentences, %llu fixes converted in %.3fs\n", ps[preset].name,
+		(unsigned long long)r.nmea.bytes, (unsigned long long)r.nmea.sentences, (unsigned long long)r.converted, r.seconds);
+	printf("%.0f sentences/s, %.0f fixes/s, %.0fs of log replayed at %.0fx realtime\n",
+		r.sentences_per_second, r.fixes_per_second, r.covered_seconds, r.speedup);
+	printf("checksum errors: %llu, malformed: %llu, unsupported: %llu, dropped: %llu\n",
+		(unsigned long long)r.nmea.checksum_errors, (unsigned long long)r.nmea.malformed,
+		(unsigned long long)r.nmea.unsupported, (unsigned long long)r.nmea.dropped);
+
+	if (source != stdin) {
+		fclose(source);
+	}
+
+	return 0;
+}
+#endif
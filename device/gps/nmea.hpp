@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+#include "device/gps/gauss_krueger.hpp"
+
+namespace WarGrey::DTPM {
+	enum class NMEASentence : uint8_t { GGA, RMC, HDT, VTG, _ };
+
+	/**
+	 * A position fix merged from GGA (or RMC if the receiver does not speak GGA),
+	 *   along with the latest heading (HDT), course and speed over ground (VTG/RMC) seen before it.
+	 *
+	 * `latitude` and `longitude` are NMEA-styled `ddmm.mmmm`, southern and western ones are negative.
+	 * `utc` is the time of the day in seconds, `date` is `ddmmyy` from RMC, or 0 if unknown.
+	 */
+	struct GPSFix {
+		double utc;
+		double latitude;
+		double longitude;
+		double altitude;
+		double heading;
+		double course;
+		double speed; // knot
+		uint32_t date;
+		uint16_t antenna;
+		uint8_t quality;
+		uint8_t satellites;
+	};
+
+	struct NMEAStatistics {
+		uint64_t bytes;
+		uint64_t sentences;
+		uint64_t fixes;
+		uint64_t checksum_errors;
+		uint64_t malformed;
+		uint64_t unsupported;
+		uint64_t dropped;
+	};
+
+	/**
+	 * Single-producer single-consumer ring of fixes, preallocated once.
+	 *   the ingest thread pushes, the converting thread pops, no locks involved.
+	 */
+	class GPSFixRing {
+	public:
+		virtual ~GPSFixRing() noexcept;
+		GPSFixRing(size_t capacity = 4096);
+
+	public:
+		bool push(const WarGrey::DTPM::GPSFix& fix);
+		size_t pop(WarGrey::DTPM::GPSFix* dest, size_t count);
+		size_t size();
+		size_t capacity();
+
+	private:
+		WarGrey::DTPM::GPSFix* fixes;
+		size_t mask;
+		std::atomic<size_t> head;
+		std::atomic<size_t> tail;
+	};
+
+	/**
+	 * Parses GGA/RMC/HDT/VTG sentences in place on the receive buffer,
+	 *   incomplete sentences at the end of a buffer are carried over into a small internal buffer.
+	 *   sentences without a valid checksum are rejected.
+	 */
+	class NMEAStream {
+	public:
+		NMEAStream(WarGrey::DTPM::GPSFixRing* sink, uint16_t antenna = 0);
+
+	public:
+		size_t feed(const char* data, size_t size);
+		const WarGrey::DTPM::NMEAStatistics& statistics();
+
+	private:
+		void on_sentence(const char* sentence, const char* end);
+		void on_fix();
+
+	private:
+		WarGrey::DTPM::GPSFixRing* sink;
+		WarGrey::DTPM::NMEAStatistics stats;
+		WarGrey::DTPM::GPSFix current;
+		bool gga_available;
+
+	private:
+		char carry[128];
+		size_t carry_size;
+	};
+
+	/**
+	 * Converts the fixes in the ring with the batch kernel, structure-of-arrays are preallocated once.
+	 */
+	class GPSFixBatch {
+	public:
+		virtual ~GPSFixBatch() noexcept;
+		GPSFixBatch(size_t capacity = 256);
+
+	public:
+		size_t convert(WarGrey::DTPM::GPSFixRing* source, const WarGrey::DTPM::GCSContext& gcs);
+
+	public:
+		WarGrey::DTPM::GPSFix* fixes;
+		double* xs;
+		double* ys;
+		double* zs;
+		size_t count;
+
+	private:
+		double* Bs;
+		double* Ls;
+		double* Hs;
+		size_t capacity;
+	};
+
+	struct NMEAReplayReport {
+		WarGrey::DTPM::NMEAStatistics nmea;
+		uint64_t converted;
+		double seconds;
+		double sentences_per_second;
+		double fixes_per_second;
+		double covered_seconds;
+		double speedup;
+	};
+
+	/**
+	 * Replays a capture file or a pipe (e.g. `stdin`) as fast as possible,
+	 *   `speedup` is the ratio of the time the log covers to the wall-clock time of the replay.
+	 */
+	void nmea_replay(std::FILE* source, const WarGrey::DTPM::GCSContext& gcs, WarGrey::DTPM::NMEAReplayReport* report, size_t chunk_size = 65536);
+}
@@ -1,10 +1,9 @@
-#include <map>
-
 #include "device/gps_cs.hpp"
 
 #include "graphlet/shapelet.hpp"
 
 #include "module.hpp"
+#include "enum_array.hpp"
 
 using namespace WarGrey::SCADA;
 using namespace WarGrey::DTPM;
@@ -170,6 +169,29 @@ public:
 		return true;
 	}
 
+	bool calibrate(const double* Bs, const double* Ls, const double* Hs, const double* xs, const double* ys, const double* zs, size_t count
+		, HelmertUnknowns unknowns, HelmertSolution* solution) {
+		HelmertSolution result;
+		bool okay = false;
+
+		this->refresh_entity(); // the fields that are not solved are taken as they are shown
+
+		okay = helmert_solve(Bs, Ls, Hs, xs, ys, zs, count, this->entity->parameter, &result, unknowns);
+
+		if (okay) {
+			this->entity->parameter = result.parameter;
+			this->refresh_parameter_fields();
+			this->refresh_output_fields();
+			this->master->notify_modification();
+		}
+
+		if (solution != nullptr) {
+			(*solution) = result;
+		}
+
+		return okay;
+	}
+
 public:
 	IGraphlet* thumbnail() {
 		return this->gps;
@@ -233,17 +255,23 @@ private:
 			double x = this->is[GCS::X]->get_value();
 			double y = this->is[GCS::Y]->get_value();
 			double z = this->is[GCS::Z]->get_value();
-			double3 xyz = this->convertor->gps_to_xyz(latitude, longitude, altitude, this->entity->parameter);
-			double3 blh = this->convertor->xyz_to_gps(x, y, z, this->entity->parameter);
+			double3 xyz, blh;
+
+			if ((this->context == nullptr) || !gcs_parameter_equal(this->context->parameter, this->entity->parameter)) {
+				this->context = gcs_compile(this->entity->parameter);
+			}
+
+			xyz = this->convertor->gps_to_xyz(latitude, longitude, altitude, *this->context);
+			blh = this->convertor->xyz_to_gps(x, y, z, *this->context);
 
 			this->master->begin_update_sequence();
 
 			this->os[GCS::X]->set_value(xyz.x);
 			this->os[GCS::Y]->set_value(xyz.y);
 			this->os[GCS::Z]->set_value(xyz.z);
-			//this->os[GCS::B]->set_value(blh.x);
-			//this->os[GCS::L]->set_value(blh.y);
-			//this->os[GCS::H]->set_value(blh.z);
+			this->os[GCS::B]->set_value(blh.x);
+			this->os[GCS::L]->set_value(blh.y);
+			this->os[GCS::H]->set_value(blh.z);
 
 			this->master->notify_updated();
 			this->master->end_update_sequence();
@@ -317,20 +345,203 @@ private:
 	DimensionStyle input_style;
 	DimensionStyle output_style;
 	GPSCS^ entity;
+	std::shared_ptr<const GCSContext> context;
 
 private: // never delete these graphlet manually
 	GPSlet* gps;
-	std::map<GCS, Shapelet*> regions;
-	std::map<GCS, Labellet*> labels;
-	std::map<GCS, Credit<Dimensionlet, GCS>*> ps;
-	std::map<GCS, Credit<Dimensionlet, GCS>*> is;
-	std::map<GCS, Credit<Dimensionlet, GCS>*> os;
+	EnumArray<GCS, Shapelet*, GCS::__> regions;
+	EnumArray<GCS, Labellet*> labels;
+	EnumArray<GCS, Credit<Dimensionlet, GCS>*> ps;
+	EnumArray<GCS, Credit<Dimensionlet, GCS>*, GCS::__> is;
+	EnumArray<GCS, Credit<Dimensionlet, GCS>*, GCS::__> os;
 	
 private:
 	GPSCSEditor* master;
 	IGPSConvertor* convertor;
 };
 
+/*************************************************************************************************/
+void IGPSConvertor::gps_to_xyz(const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count, GCSParameter& gcs) {
+	std::shared_ptr<const GCSContext> context = gcs_compile(gcs); // once per batch, the overloads of `GCSParameter` look it up per point
+
+	for (size_t idx = 0; idx < count; idx++) {
+		double3 xyz = this->gps_to_xyz(Bs[idx], Ls[idx], Hs[idx], *context);
+
+		xs[idx] = xyz.x;
+		ys[idx] = xyz.y;
+		zs[idx] = xyz.z;
+	}
+}
+
+void IGPSConvertor::xyz_to_gps(const double* xs, const double* ys, const double* zs, double* Bs, double* Ls, double* Hs, size_t count, GCSParameter& gcs) {
+	std::shared_ptr<const GCSContext> context = gcs_compile(gcs);
+
+	for (size_t idx = 0; idx < count; idx++) {
+		double3 blh = this->xyz_to_gps(xs[idx], ys[idx], zs[idx], *context);
+
+		Bs[idx] = blh.x;
+		Ls[idx] = blh.y;
+		Hs[idx] = blh.z;
+	}
+}
+
+double3 IGPSConvertor::gps_to_xyz(double latitude, double longitude, double altitude, const GCSContext& gcs) {
+	GCSParameter parameter = gcs.parameter;
+
+	return this->gps_to_xyz(latitude, longitude, altitude, parameter);
+}
+
+double3 IGPSConvertor::xyz_to_gps(double x, double y, double z, const GCSContext& gcs) {
+	GCSParameter parameter = gcs.parameter;
+
+	return this->xyz_to_gps(x, y, z, parameter);
+}
+
+void IGPSConvertor::gps_to_xyz(const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count, const GCSContext& gcs) {
+	GCSParameter parameter = gcs.parameter;
+
+	this->gps_to_xyz(Bs, Ls, Hs, xs, ys, zs, count, parameter);
+}
+
+void IGPSConvertor::xyz_to_gps(const double* xs, const double* ys, const double* zs, double* Bs, double* Ls, double* Hs, size_t count, const GCSContext& gcs) {
+	GCSParameter parameter = gcs.parameter;
+
+	this->xyz_to_gps(xs, ys, zs, Bs, Ls, Hs, count, parameter);
+}
+
+/*************************************************************************************************/
+GaussKruegerConvertor::GaussKruegerConvertor(GCSAccuracy inverse_accuracy)
+	: inverse_accuracy(inverse_accuracy), tiles_victim(0), tolerance(0.001), approximation(false) {}
+
+void GaussKruegerConvertor::approximate(const GCSWorkArea& area, double tolerance) {
+	this->work_area = area;
+	this->tolerance = tolerance;
+	this->approximation = true;
+
+	for (size_t idx = 0; idx < sizeof(this->tiles) / sizeof(this->tiles[0]); idx++) {
+		std::atomic_store(&this->tiles[idx], std::shared_ptr<GaussKruegerTiles>(nullptr));
+	}
+}
+
+void GaussKruegerConvertor::disable_approximation() {
+	this->approximation = false;
+
+	for (size_t idx = 0; idx < sizeof(this->tiles) / sizeof(this->tiles[0]); idx++) {
+		std::atomic_store(&this->tiles[idx], std::shared_ptr<GaussKruegerTiles>(nullptr));
+	}
+}
+
+void GaussKruegerConvertor::cache(size_t capacity, double resolution, double tolerance) {
+	std::atomic_store(&this->results, std::make_shared<GCSResultCache>(capacity, resolution, tolerance));
+}
+
+void GaussKruegerConvertor::disable_cache() {
+	std::atomic_store(&this->results, std::shared_ptr<GCSResultCache>(nullptr));
+}
+
+GCSCacheStatistics GaussKruegerConvertor::cache_statistics() {
+	std::shared_ptr<GCSResultCache> cache = std::atomic_load(&this->results);
+	GCSCacheStatistics s = {};
+
+	if (cache != nullptr) {
+		s = cache->statistics();
+	}
+
+	return s;
+}
+
+std::shared_ptr<GaussKruegerTiles> GaussKruegerConvertor::tiles_for(const GCSContext& gcs) {
+	std::shared_ptr<GaussKruegerTiles> grid = nullptr;
+
+	if (this->approximation) {
+		grid = this->tiles_fitted(gcs);
+
+		if (grid == nullptr) {
+			std::lock_guard<std::mutex> guard(this->tiles_fitting);
+
+			// another thread may have fitted it while this one was waiting
+			grid = this->tiles_fitted(gcs);
+
+			if (grid == nullptr) { // grids are replaced in turn, there are only a few parameters alive at the same time
+				const size_t slot_count = sizeof(this->tiles) / sizeof(this->tiles[0]);
+
+				grid = std::make_shared<GaussKruegerTiles>(gcs_compile(gcs.parameter), this->work_area, this->tolerance);
+				std::atomic_store(&this->tiles[this->tiles_victim.fetch_add(1) % slot_count], grid);
+			}
+		}
+	}
+
+	return grid;
+}
+
+std::shared_ptr<GaussKruegerTiles> GaussKruegerConvertor::tiles_fitted(const GCSContext& gcs) {
+	std::shared_ptr<GaussKruegerTiles> grid = nullptr;
+
+	for (size_t idx = 0; idx < sizeof(this->tiles) / sizeof(this->tiles[0]); idx++) {
+		std::shared_ptr<GaussKruegerTiles> slot = std::atomic_load(&this->tiles[idx]);
+
+		if ((slot != nullptr) && (slot->context().hash == gcs.hash) && gcs_parameter_equal(slot->context().parameter, gcs.parameter)) {
+			grid = slot;
+			break;
+		}
+	}
+
+	return grid;
+}
+
+double3 GaussKruegerConvertor::gps_to_xyz(double latitude, double longitude, double altitude, GCSParameter& gcs) {
+	return this->gps_to_xyz(latitude, longitude, altitude, *gcs_compile(gcs));
+}
+
+double3 GaussKruegerConvertor::xyz_to_gps(double x, double y, double z, GCSParameter& gcs) {
+	return gauss_krueger_inverse(x, y, z, gcs, this->inverse_accuracy);
+}
+
+void GaussKruegerConvertor::gps_to_xyz(const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count, GCSParameter& gcs) {
+	this->gps_to_xyz(Bs, Ls, Hs, xs, ys, zs, count, *gcs_compile(gcs));
+}
+
+void GaussKruegerConvertor::xyz_to_gps(const double* xs, const double* ys, const double* zs, double* Bs, double* Ls, double* Hs, size_t count, GCSParameter& gcs) {
+	gauss_krueger_inverse(xs, ys, zs, Bs, Ls, Hs, count, gcs, this->inverse_accuracy);
+}
+
+double3 GaussKruegerConvertor::gps_to_xyz(double latitude, double longitude, double altitude, const GCSContext& gcs) {
+	std::shared_ptr<GaussKruegerTiles> grid = this->tiles_for(gcs);
+	std::shared_ptr<GCSResultCache> cache = std::atomic_load(&this->results);
+	double3 xyz;
+
+	if (cache != nullptr) {
+		xyz = cache->forward(latitude, longitude, altitude, gcs, grid.get());
+	} else if (grid != nullptr) {
+		xyz = grid->forward(latitude, longitude, altitude);
+	} else {
+		xyz = gauss_krueger_forward(latitude, longitude, altitude, gcs);
+	}
+
+	return xyz;
+}
+
+double3 GaussKruegerConvertor::xyz_to_gps(double x, double y, double z, const GCSContext& gcs) {
+	return gauss_krueger_inverse(x, y, z, gcs, this->inverse_accuracy);
+}
+
+void GaussKruegerConvertor::gps_to_xyz(const double* Bs, const double* Ls, const double* Hs, double* xs, double* ys, double* zs, size_t count, const GCSContext& gcs) {
+	std::shared_ptr<GaussKruegerTiles> grid = this->tiles_for(gcs);
+	std::shared_ptr<GCSResultCache> cache = std::atomic_load(&this->results);
+
+	if (cache != nullptr) {
+		cache->forward(Bs, Ls, Hs, xs, ys, zs, count, gcs, grid.get());
+	} else if (grid != nullptr) {
+		grid->forward(Bs, Ls, Hs, xs, ys, zs, count);
+	} else {
+		gauss_krueger_forward(Bs, Ls, Hs, xs, ys, zs, count, gcs);
+	}
+}
+
+void GaussKruegerConvertor::xyz_to_gps(const double* xs, const double* ys, const double* zs, double* Bs, double* Ls, double* Hs, size_t count, const GCSContext& gcs) {
+	gauss_krueger_inverse(xs, ys, zs, Bs, Ls, Hs, count, gcs, this->inverse_accuracy);
+}
+
 /*************************************************************************************************/
 GPSCSEditor::GPSCSEditor(IGPSConvertor* gc, Platform::String^ gps) : EditorPlanet(__MODULE__) {
 	this->self = new GPSCSEditor::Self(this, gps, gc);
@@ -366,6 +577,11 @@ IGraphlet* GPSCSEditor::thumbnail_graphlet() {
 	return this->self->thumbnail();
 }
 
+bool GPSCSEditor::calibrate(const double* Bs, const double* Ls, const double* Hs, const double* xs, const double* ys, const double* zs, size_t count
+	, HelmertUnknowns unknowns, HelmertSolution* solution) {
+	return this->self->calibrate(Bs, Ls, Hs, xs, ys, zs, count, unknowns, solution);
+}
+
 bool GPSCSEditor::on_apply() {
 	return this->self->on_apply();
 }
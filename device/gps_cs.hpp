@@ -1,16 +1,99 @@
 #pragma once
 
+#include <mutex>
+#include <atomic>
+
 #include "editor.hpp"
 
 #include "graphlet/filesystem/configuration/gpslet.hpp"
 
-#include "cs/wgs_xy.hpp"
+#include "device/gps/gauss_krueger.hpp"
+#include "device/gps/gauss_krueger_tiles.hpp"
+#include "device/gps/gcs_cache.hpp"
+#include "device/gps/helmert.hpp"
 
 namespace WarGrey::DTPM {
 	private class IGPSConvertor abstract {
 	public:
 		virtual WarGrey::SCADA::double3 gps_to_xyz(double latitude, double longitude, double altitude, WarGrey::DTPM::GCSParameter& gcs) = 0;
 		virtual WarGrey::SCADA::double3 xyz_to_gps(double x, double y, double z, WarGrey::DTPM::GCSParameter& gcs) = 0;
+
+	public: // structure-of-arrays, the default implementations compile the context once, then fall back to the scalar ones point by point
+		virtual void gps_to_xyz(const double* latitudes, const double* longitudes, const double* altitudes,
+			double* xs, double* ys, double* zs, size_t count, WarGrey::DTPM::GCSParameter& gcs);
+
+		virtual void xyz_to_gps(const double* xs, const double* ys, const double* zs,
+			double* latitudes, double* longitudes, double* altitudes, size_t count, WarGrey::DTPM::GCSParameter& gcs);
+
+	public: // compiled contexts, the default implementations fall back to the raw parameter
+		virtual WarGrey::SCADA::double3 gps_to_xyz(double latitude, double longitude, double altitude, const WarGrey::DTPM::GCSContext& gcs);
+		virtual WarGrey::SCADA::double3 xyz_to_gps(double x, double y, double z, const WarGrey::DTPM::GCSContext& gcs);
+
+		virtual void gps_to_xyz(const double* latitudes, const double* longitudes, const double* altitudes,
+			double* xs, double* ys, double* zs, size_t count, const WarGrey::DTPM::GCSContext& gcs);
+
+		virtual void xyz_to_gps(const double* xs, const double* ys, const double* zs,
+			double* latitudes, double* longitudes, double* altitudes, size_t count, const WarGrey::DTPM::GCSContext& gcs);
+	};
+
+	private class GaussKruegerConvertor : public WarGrey::DTPM::IGPSConvertor {
+	public:
+		GaussKruegerConvertor(WarGrey::DTPM::GCSAccuracy inverse_accuracy = WarGrey::DTPM::GCSAccuracy::Survey);
+
+	public:
+		WarGrey::SCADA::double3 gps_to_xyz(double latitude, double longitude, double altitude, WarGrey::DTPM::GCSParameter& gcs) override;
+		WarGrey::SCADA::double3 xyz_to_gps(double x, double y, double z, WarGrey::DTPM::GCSParameter& gcs) override;
+
+	public:
+		void gps_to_xyz(const double* latitudes, const double* longitudes, const double* altitudes,
+			double* xs, double* ys, double* zs, size_t count, WarGrey::DTPM::GCSParameter& gcs) override;
+
+		void xyz_to_gps(const double* xs, const double* ys, const double* zs,
+			double* latitudes, double* longitudes, double* altitudes, size_t count, WarGrey::DTPM::GCSParameter& gcs) override;
+
+	public:
+		WarGrey::SCADA::double3 gps_to_xyz(double latitude, double longitude, double altitude, const WarGrey::DTPM::GCSContext& gcs) override;
+		WarGrey::SCADA::double3 xyz_to_gps(double x, double y, double z, const WarGrey::DTPM::GCSContext& gcs) override;
+
+		void gps_to_xyz(const double* latitudes, const double* longitudes, const double* altitudes,
+			double* xs, double* ys, double* zs, size_t count, const WarGrey::DTPM::GCSContext& gcs) override;
+
+		void xyz_to_gps(const double* xs, const double* ys, const double* zs,
+			double* latitudes, double* longitudes, double* altitudes, size_t count, const WarGrey::DTPM::GCSContext& gcs) override;
+
+	public:
+		/**
+		 * Fixes within the area are converted with the tiled approximation whose error is within `tolerance` meters,
+		 *   the tiles are fitted lazily for each parameter, and the last few grids are kept,
+		 *   so that alternating between, say, the parameter being edited and the live one does not refit on every switch.
+		 * Configure it before conversions start, the tiles themselves are safe to be shared among threads,
+		 *   a grid is fitted (1-30ms) by the first thread converting with its parameter, others needing it wait rather than fit it again.
+		 */
+		void approximate(const WarGrey::DTPM::GCSWorkArea& area, double tolerance = 0.001);
+		void disable_approximation();
+
+		/**
+		 * Fixes are looked up in a `GCSResultCache` before being converted, misses go to the tiles if the approximation is enabled.
+		 * The cache is shared by all threads converting through this convertor, cells are keyed on the parameter hash,
+		 *   so that changing the parameter does not need to flush it.
+		 */
+		void cache(size_t capacity = 1024, double resolution = 0.05, double tolerance = 0.0001);
+		void disable_cache();
+		WarGrey::DTPM::GCSCacheStatistics cache_statistics();
+
+	private:
+		std::shared_ptr<WarGrey::DTPM::GaussKruegerTiles> tiles_for(const WarGrey::DTPM::GCSContext& gcs);
+		std::shared_ptr<WarGrey::DTPM::GaussKruegerTiles> tiles_fitted(const WarGrey::DTPM::GCSContext& gcs);
+
+	private:
+		WarGrey::DTPM::GCSAccuracy inverse_accuracy;
+		std::shared_ptr<WarGrey::DTPM::GaussKruegerTiles> tiles[4];
+		std::atomic<size_t> tiles_victim;
+		std::mutex tiles_fitting;
+		std::shared_ptr<WarGrey::DTPM::GCSResultCache> results;
+		WarGrey::DTPM::GCSWorkArea work_area;
+		double tolerance;
+		bool approximation;
 	};
 
 	private class GPSCSEditor : public WarGrey::DTPM::EditorPlanet {
@@ -24,6 +107,12 @@ namespace WarGrey::DTPM {
 		void on_graphlet_ready(WarGrey::SCADA::IGraphlet* g) override;
 		WarGrey::SCADA::IGraphlet* thumbnail_graphlet() override;
 
+	public:
+		bool calibrate(const double* latitudes, const double* longitudes, const double* altitudes,
+			const double* xs, const double* ys, const double* zs, size_t count,
+			WarGrey::DTPM::HelmertUnknowns unknowns = WarGrey::DTPM::HelmertUnknowns::Bursa,
+			WarGrey::DTPM::HelmertSolution* solution = nullptr);
+
 	protected:
 		bool on_apply() override;
 		bool on_reset() override;
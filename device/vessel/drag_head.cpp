@@ -0,0 +1,331 @@
+#include <cmath>
+
+#include "device/vessel/drag_head.hpp"
+#include "simd_dispatch.hpp"
+
+#if defined(SIMD_AVX2)
+#define DH_SIMD_AVX2
+#elif defined(_M_ARM64)
+#include <arm64_neon.h>
+#define DH_SIMD_NEON
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define DH_SIMD_NEON
+#endif
+
+using namespace WarGrey::SCADA;
+using namespace WarGrey::DTPM;
+
+static const double pi = 3.14159265358979323846;
+static const double radians_per_degree = pi / 180.0;
+static const double gravity = 9.80665;
+
+// Cody-Waite reduction by pi/4 and the minimax polynomials on [-pi/4, pi/4], after Cephes
+static const double pio4_1 = 7.85398125648498535156E-1;
+static const double pio4_2 = 3.77489470793079817668E-8;
+static const double pio4_3 = 2.69515142907905952645E-15;
+static const double four_over_pi = 1.27323954473516268615;
+
+static const double sin_coefficients[] = {
+	1.58962301576546568060E-10, -2.50507477628578072866E-8, 2.75573136213857245213E-6,
+	-1.98412698295895385996E-4, 8.33333333332211858878E-3, -1.66666666666666307295E-1
+};
+
+static const double cos_coefficients[] = {
+	-1.13585365213876817300E-11, 2.08757008419747316778E-9, -2.75573141792967388112E-7,
+	2.48015872888517045348E-5, -1.38888888888730564116E-3, 4.16666666666665929218E-2
+};
+
+/*************************************************************************************************/
+namespace {
+	inline double lfloor(double x) { return floor(x); }
+	inline double labs(double x) { return fabs(x); }
+	inline bool lgt(double a, double b) { return (a > b); }
+	inline double lselect(bool m, double a, double b) { return (m ? a : b); }
+	template<typename V> inline V lload(const double* src) { return (*src); }
+	inline void lstore(double* dest, double x) { (*dest) = x; }
+
+#if defined(DH_SIMD_AVX2)
+	struct lane {
+		static const size_t N = 4;
+
+		lane() {}
+		lane(double s) : v(_mm256_set1_pd(s)) {}
+		lane(__m256d v) : v(v) {}
+
+		__m256d v;
+	};
+
+	inline lane operator+(lane a, lane b) { return _mm256_add_pd(a.v, b.v); }
+	inline lane operator-(lane a, lane b) { return _mm256_sub_pd(a.v, b.v); }
+	inline lane operator*(lane a, lane b) { return _mm256_mul_pd(a.v, b.v); }
+	inline lane operator/(lane a, lane b) { return _mm256_div_pd(a.v, b.v); }
+	inline lane lfloor(lane x) { return _mm256_floor_pd(x.v); }
+	inline lane labs(lane x) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x.v); }
+	inline lane lgt(lane a, lane b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ); }
+	inline lane lselect(lane m, lane a, lane b) { return _mm256_blendv_pd(b.v, a.v, m.v); }
+	template<> inline lane lload<lane>(const double* src) { return _mm256_loadu_pd(src); }
+	inline void lstore(double* dest, lane x) { _mm256_storeu_pd(dest, x.v); }
+#elif defined(DH_SIMD_NEON)
+	struct lane {
+		static const size_t N = 2;
+
+		lane() {}
+		lane(double s) : v(vdupq_n_f64(s)) {}
+		lane(float64x2_t v) : v(v) {}
+
+		float64x2_t v;
+	};
+
+	inline lane operator+(lane a, lane b) { return vaddq_f64(a.v, b.v); }
+	inline lane operator-(lane a, lane b) { return vsubq_f64(a.v, b.v); }
+	inline lane operator*(lane a, lane b) { return vmulq_f64(a.v, b.v); }
+	inline lane operator/(lane a, lane b) { return vdivq_f64(a.v, b.v); }
+	inline lane lfloor(lane x) { return vrndmq_f64(x.v); }
+	inline lane labs(lane x) { return vabsq_f64(x.v); }
+	inline lane lgt(lane a, lane b) { return vreinterpretq_f64_u64(vcgtq_f64(a.v, b.v)); }
+	inline lane lselect(lane m, lane a, lane b) { return vbslq_f64(vreinterpretq_u64_f64(m.v), a.v, b.v); }
+	template<> inline lane lload<lane>(const double* src) { return vld1q_f64(src); }
+	inline void lstore(double* dest, lane x) { vst1q_f64(dest, x.v); }
+#endif
+
+	/*********************************************************************************************/
+	template<typename V>
+	inline V polynomial(const double* coefficients, V x) {
+		V r = V(coefficients[0]);
+
+		for (size_t i = 1; i < 6; i++) {
+			r = r * x + V(coefficients[i]);
+		}
+
+		return r;
+	}
+
+	/**
+	 * Both sine and cosine of `x` (radian), errors are within a few ulps for |x| up to thousands of radians,
+	 *   way more than headings and pipe angles need.
+	 *
+	 * Scalars go through libm, which is faster than evaluating the polynomials one at a time.
+	 */
+	inline void lsincos(double x, double* sine, double* cosine) {
+		(*sine) = sin(x);
+		(*cosine) = cos(x);
+	}
+
+	template<typename V>
+	inline void lsincos(V x, V* sine, V* cosine) {
+		V ax = labs(x);
+		V q = lfloor(ax * V(four_over_pi));
+		V o = q - V(2.0) * lfloor(q / V(2.0));    // q is made even, so that z is within [-pi/4, pi/4]
+		V z, zz, sp, cp, octant, swap, ssign, csign, t;
+
+		q = q + o;
+		z = ((ax - q * V(pio4_1)) - q * V(pio4_2)) - q * V(pio4_3);
+		zz = z * z;
+		sp = z + z * zz * polynomial(sin_coefficients, zz);
+		cp = V(1.0) - V(0.5) * zz + zz * zz * polynomial(cos_coefficients, zz);
+
+		octant = q / V(2.0);                           // the quadrant, 0, 1, 2 or 3 (modulo 4)
+		octant = octant - V(4.0) * lfloor(octant / V(4.0));
+		swap = octant - V(2.0) * lfloor(octant / V(2.0));
+		ssign = V(1.0) - V(2.0) * lfloor(octant / V(2.0));
+		t = lfloor((octant + V(1.0)) / V(2.0));
+		csign = V(1.0) - V(2.0) * (t - V(2.0) * lfloor(t / V(2.0)));
+
+		(*sine) = lselect(lgt(swap, V(0.5)), cp, sp) * ssign;
+		(*sine) = lselect(lgt(V(0.0), x), V(0.0) - (*sine), (*sine));
+		(*cosine) = lselect(lgt(swap, V(0.5)), sp, cp) * csign;
+	}
+
+	template<typename V, bool Pressure, bool Pose>
+	inline void drag_head(const DragHeadGeometry& g, double outboard, const DragHeadSamples& s, size_t i,
+		double* xs, double* ys, double* depths) {
+		V hx = V(g.hinge[(outboard > 0.0) ? 1 : 0].x);
+		V hy = V(g.hinge[(outboard > 0.0) ? 1 : 0].y);
+		V su, cu, sl, cl, sw, cw, x, y, depth;
+
+		lsincos(lload<V>(s.upper_angles + i) * V(radians_per_degree), &su, &cu);
+		lsincos(lload<V>(s.lower_angles + i) * V(radians_per_degree), &sl, &cl);
+		lsincos(lload<V>(s.swing_angles + i) * V(radians_per_degree), &sw, &cw);
+
+		{ // the pipes trail aft and swing outboard
+			V reach = V(g.upper_length) * cu + V(g.lower_length) * cl;
+
+			x = hx - reach * cw;
+			y = hy + reach * sw * V(outboard);
+			depth = V(g.hinge_depth) + V(g.upper_length) * su + V(g.lower_length) * sl;
+		}
+
+		if (Pressure) {
+			V p = lload<V>(s.pressures + i);
+
+			depth = lselect(lgt(p, V(0.0)), p * V(1000.0 / (g.water_density * gravity)), depth);
+		}
+
+		if (Pose) {
+			V sh, ch;
+
+			lsincos(lload<V>(s.headings + i) * V(radians_per_degree), &sh, &ch);
+
+			lstore(xs + i, lload<V>(s.origin_xs + i) + (x * ch - y * sh));
+			lstore(ys + i, lload<V>(s.origin_ys + i) + (x * sh + y * ch));
+		} else {
+			lstore(xs + i, x);
+			lstore(ys + i, y);
+		}
+
+		lstore(depths + i, depth);
+	}
+
+	template<bool Pressure, bool Pose>
+	void drag_head_batch(const DragHeadGeometry& g, double outboard, const DragHeadSamples& s, size_t count,
+		double* xs, double* ys, double* depths, bool simd) {
+		size_t i = 0;
+
+#if defined(DH_SIMD_AVX2)
+		if (simd && simd_avx2_supported()) {
+			for (; i + lane::N <= count; i += lane::N) {
+				drag_head<lane, Pressure, Pose>(g, outboard, s, i, xs, ys, depths);
+			}
+
+			_mm256_zeroupper(); // the rest may be legacy SSE code, if the build does not target AVX
+		}
+#elif defined(DH_SIMD_NEON)
+		if (simd) {
+			for (; i + lane::N <= count; i += lane::N) {
+				drag_head<lane, Pressure, Pose>(g, outboard, s, i, xs, ys, depths);
+			}
+		}
+#else
+		(void)simd;
+#endif
+
+		for (; i < count; i++) {
+			drag_head<double, Pressure, Pose>(g, outboard, s, i, xs, ys, depths);
+		}
+	}
+
+	void drag_head_dispatch(const DragHeadGeometry& g, DragHeadSide side, const DragHeadSamples& s, size_t count,
+		double* xs, double* ys, double* depths, bool simd) {
+		double outboard = ((side == DragHeadSide::SB) ? +1.0 : -1.0); // the `y` axis points to the starboard
+		bool pose = (s.origin_xs != nullptr) && (s.origin_ys != nullptr) && (s.headings != nullptr);
+
+		if (s.pressures != nullptr) {
+			if (pose) {
+				drag_head_batch<true, true>(g, outboard, s, count, xs, ys, depths, simd);
+			} else {
+				drag_head_batch<true, false>(g, outboard, s, count, xs, ys, depths, simd);
+			}
+		} else {
+			if (pose) {
+				drag_head_batch<false, true>(g, outboard, s, count, xs, ys, depths, simd);
+			} else {
+				drag_head_batch<false, false>(g, outboard, s, count, xs, ys, depths, simd);
+			}
+		}
+	}
+}
+
+/*************************************************************************************************/
+void WarGrey::DTPM::drag_head_solve(const DragHeadGeometry& g, DragHeadSide side, const DragHeadSamples& s, size_t count,
+	double* xs, double* ys, double* depths) {
+	drag_head_dispatch(g, side, s, count, xs, ys, depths, true);
+}
+
+void WarGrey::DTPM::drag_head_solve_scalar(const DragHeadGeometry& g, DragHeadSide side, const DragHeadSamples& s, size_t count,
+	double* xs, double* ys, double* depths) {
+	drag_head_dispatch(g, side, s, count, xs, ys, depths, false);
+}
+
+/*************************************************************************************************/
+#ifdef DRAG_HEAD_MAIN
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+/**
+ * Re-processes `days` of history sampled at 50Hz for both sides,
+ *   a chunk of samples is generated once and solved repeatedly, as if the history were read chunk by chunk.
+ */
+int main(int argc, char* argv[]) {
+	double days = ((argc > 1) ? strtod(argv[1], nullptr) : 1.0);
+	size_t chunk = 1U << 16;
+	size_t total = size_t(days * 86400.0 * 50.0);
+	std::mt19937_64 prng(0);
+	std::uniform_real_distribution<double> upper(0.0, 60.0), lower(0.0, 75.0), swing(-5.0, 25.0), heading(0.0, 360.0), pressure(150.0, 400.0);
+	std::vector<double> us(chunk), ls(chunk), ws(chunk), ps(chunk), oxs(chunk), oys(chunk), hs(chunk);
+	std::vector<double> xs(chunk), ys(chunk), ds(chunk), sxs(chunk), sys(chunk), sds(chunk);
+	DragHeadGeometry g = { { double2(40.0, -8.0), double2(40.0, 8.0) }, 4.5, 28.0, 30.0, 1025.0 };
+	DragHeadSamples samples = { us.data(), ls.data(), ws.data(), ps.data(), oxs.data(), oys.data(), hs.data() };
+	double seconds[3] = { 0.0, 0.0, 0.0 };
+	double worst = 0.0;
+	double batch_worst = 0.0;
+
+	for (size_t i = 0; i < chunk; i++) {
+		us[i] = upper(prng);
+		ls[i] = lower(prng);
+		ws[i] = swing(prng);
+		ps[i] = (((prng() & 0x7U) == 0U) ? 0.0 : pressure(prng)); // the sensor drops out now and then
+		oxs[i] = 3375000.0 + double(i) * 0.05;
+		oys[i] = 596000.0 + double(i) * 0.02;
+		hs[i] = heading(prng);
+	}
+
+	for (size_t side = 0; side < 2; side++) {
+		DragHeadSide s = ((side == 0) ? DragHeadSide::PS : DragHeadSide::SB);
+		double outboard = ((side == 0) ? -1.0 : +1.0);
+
+		for (size_t done = 0; done < total; done += chunk) {
+			size_t n = std::min(chunk, total - done);
+
+			auto t0 = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < n; i++) { // the straightforward way, what the ad hoc code does
+				double u = us[i] * radians_per_degree, l = ls[i] * radians_per_degree, w = ws[i] * radians_per_degree, h = hs[i] * radians_per_degree;
+				double reach = g.upper_length * cos(u) + g.lower_length * cos(l);
+				double x = g.hinge[side].x - reach * cos(w);
+				double y = g.hinge[side].y + reach * sin(w) * outboard;
+
+				sxs[i] = oxs[i] + (x * cos(h) - y * sin(h));
+				sys[i] = oys[i] + (x * sin(h) + y * cos(h));
+				sds[i] = ((ps[i] > 0.0) ? ps[i] * 1000.0 / (g.water_density * gravity) : g.hinge_depth + g.upper_length * sin(u) + g.lower_length * sin(l));
+			}
+			auto t1 = std::chrono::steady_clock::now();
+			drag_head_solve_scalar(g, s, samples, n, xs.data(), ys.data(), ds.data());
+			auto t2 = std::chrono::steady_clock::now();
+
+			for (size_t i = 0; i < n; i++) {
+				worst = std::max(worst, std::max(fabs(xs[i] - sxs[i]), std::max(fabs(ys[i] - sys[i]), fabs(ds[i] - sds[i]))));
+			}
+
+			auto t3 = std::chrono::steady_clock::now();
+			drag_head_solve(g, s, samples, n, sxs.data(), sys.data(), sds.data());
+			auto t4 = std::chrono::steady_clock::now();
+
+			for (size_t i = 0; i < n; i++) {
+				batch_worst = std::max(batch_worst, std::max(fabs(xs[i] - sxs[i]), std::max(fabs(ys[i] - sys[i]), fabs(ds[i] - sds[i]))));
+			}
+
+			seconds[0] += std::chrono::duration<double>(t1 - t0).count();
+			seconds[1] += std::chrono::duration<double>(t2 - t1).count();
+			seconds[2] += std::chrono::duration<double>(t4 - t3).count();
+		}
+	}
+
+#if defined(DH_SIMD_NEON)
+	const char* kernel = "NEON";
+#else
+	const char* kernel = (simd_avx2_supported() ? "AVX2" : "libm, no AVX2");
+#endif
+
+	printf("%.2f day(s) at 50Hz x 2 sides: %llu samples\n", days, (unsigned long long)(total * 2));
+	printf("%-10s %14.0f samples/s %8.3fs\n", "libm", double(total * 2) / seconds[0], seconds[0]);
+	printf("%-10s %14.0f samples/s %8.3fs\n", "scalar", double(total * 2) / seconds[1], seconds[1]);
+	printf("%-10s %14.0f samples/s %8.3fs (%s)\n", "batch", double(total * 2) / seconds[2], seconds[2], kernel);
+	printf("worst difference from libm: %.3e m (scalar), %.3e m (batch)\n", worst, batch_worst);
+
+	return (((worst < 1e-9) && (batch_worst < 1e-9)) ? 0 : 1);
+}
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+
+#include "device/gps/gcs_context.hpp"
+
+namespace WarGrey::DTPM {
+	enum class DragHeadSide { PS, SB };
+
+	/**
+	 * Per-vessel constants of the suction pipes, in the vessel frame (`x` to the bow, `y` to the starboard),
+	 *   `hinge` is where the upper pipe swings, the suction point plus the trunnion offset (mirrored to the port side);
+	 *   `hinge_depth` is the depth of the trunnion below the water line;
+	 *   `upper_length` and `lower_length` are of the upper pipe (trunnion to the intermediate joint) and the lower pipe (to the drag head);
+	 *   `water_density` (kg/m^3) converts the pressure at the drag head into the depth.
+	 */
+	struct DragHeadGeometry {
+		WarGrey::SCADA::double2 hinge[2];
+		double hinge_depth;
+		double upper_length;
+		double lower_length;
+		double water_density;
+	};
+
+	/**
+	 * Works for whatever holds fields of the same names, say, `TrailingSuctionDredger^`,
+	 *   the trunnion offset is given for the starboard side, the port side mirrors it.
+	 */
+	template<typename V>
+	void drag_head_geometry_fill(WarGrey::DTPM::DragHeadGeometry* geometry, V vessel,
+		double hinge_depth, double upper_length, double lower_length, double water_density = 1025.0) {
+		geometry->hinge[0] = WarGrey::SCADA::double2(vessel->ps_suction.x + vessel->trunnion.x, vessel->ps_suction.y - vessel->trunnion.y);
+		geometry->hinge[1] = WarGrey::SCADA::double2(vessel->sb_suction.x + vessel->trunnion.x, vessel->sb_suction.y + vessel->trunnion.y);
+		geometry->hinge_depth = hinge_depth;
+		geometry->upper_length = upper_length;
+		geometry->lower_length = lower_length;
+		geometry->water_density = water_density;
+	}
+
+	/**
+	 * Samples of one side in structure-of-arrays, angles are in degrees
+	 *   `upper_angles` and `lower_angles` are the inclinations of the pipes below the horizon;
+	 *   `swing_angles` are how far the pipe swings outboard from the center line;
+	 *   `pressures` (kPa) are of the drag head, optional, non-positive ones mean not available;
+	 *   `origin_xs`, `origin_ys` and `headings` are poses of the vessel on the plane, optional, see `VesselPose`.
+	 */
+	struct DragHeadSamples {
+		const double* upper_angles;
+		const double* lower_angles;
+		const double* swing_angles;
+		const double* pressures;
+		const double* origin_xs;
+		const double* origin_ys;
+		const double* headings;
+	};
+
+	/**
+	 * Positions of the drag head, on the plane if the poses are given, otherwise in the vessel frame,
+	 *   the depth comes from the pressure if it is available, otherwise from the pipes.
+	 *
+	 * The batch version runs the SIMD kernel whenever the CPU supports it (see `simd_dispatch.hpp`), sines and cosines are evaluated by polynomials in the lanes,
+	 *   the scalar version, as well as the batch one on CPUs without AVX2, calls libm; both agree within 1e-9 m.
+	 */
+	void drag_head_solve(const WarGrey::DTPM::DragHeadGeometry& geometry, WarGrey::DTPM::DragHeadSide side,
+		const WarGrey::DTPM::DragHeadSamples& samples, size_t count, double* xs, double* ys, double* depths);
+
+	void drag_head_solve_scalar(const WarGrey::DTPM::DragHeadGeometry& geometry, WarGrey::DTPM::DragHeadSide side,
+		const WarGrey::DTPM::DragHeadSamples& samples, size_t count, double* xs, double* ys, double* depths);
+}
@@ -1,6 +1,7 @@
-#include <map>
+#include <vector>
 
 #include "device/vessel/trailing_suction_dredger.hpp"
+#include "device/vessel/vessel_fleet.hpp"
 
 #include "graphlet/filesystem/configuration/vessel/trailing_suction_dredgerlet.hpp"
 #include "graphlet/shapelet.hpp"
@@ -9,6 +10,8 @@
 #include "datum/flonum.hpp"
 
 #include "module.hpp"
+#include "enum_array.hpp"
+#include "sketch_script.hpp"
 
 using namespace WarGrey::SCADA;
 using namespace WarGrey::DTPM;
@@ -51,6 +54,86 @@ namespace {
 		tail, bridge,
 	};
 
+	// sub-shapes of the vessel preview, as bits
+	private enum class TSDShape : unsigned int {
+		GPS = 1U << 0U, Suction = 1U << 1U, Body = 1U << 2U, Hopper = 1U << 3U, Bridge = 1U << 4U, Trunnion = 1U << 5U, Barge = 1U << 6U,
+		All = (1U << 7U) - 1U
+	};
+
+	static unsigned int shape_of(TSD id) {
+		TSDShape shape = TSDShape::All;
+
+		if ((id == TSD::GPS1) || (id == TSD::GPS2)) {
+			shape = TSDShape::GPS;
+		} else if ((id == TSD::PS_Suction) || (id == TSD::SB_Suction)) {
+			shape = TSDShape::Suction;
+		} else if ((id >= TSD::Body1) && (id <= TSD::Body7)) {
+			shape = TSDShape::Body;
+		} else if ((id >= TSD::Hopper1) && (id <= TSD::Hopper4)) {
+			shape = TSDShape::Hopper;
+		} else if ((id >= TSD::Bridge1) && (id <= TSD::Bridge10)) {
+			shape = TSDShape::Bridge;
+		} else if (id == TSD::Trunnion) {
+			shape = TSDShape::Trunnion;
+		} else if (id == TSD::Barge) {
+			shape = TSDShape::Barge;
+		}
+
+		return static_cast<unsigned int>(shape);
+	}
+
+	static unsigned int shape_count(unsigned int shapes) {
+		unsigned int count = 0U;
+
+		for (; shapes > 0U; shapes &= (shapes - 1U)) {
+			count++;
+		}
+
+		return count;
+	}
+
+	// sketches are in steps, x to the right and y to the bottom, evaluated at compile time
+	static constexpr SketchScript<TSD, 32> body_sketch = []() {
+		SketchScript<TSD, 32> body;
+
+		body.move(+0.0F, +1.0F, TSD::Body1).move(-2.0F, +1.0F, TSD::Body2);
+		body.move(+0.0F, +3.0F, TSD::PS_Suction).move(+0.0F, +1.0F, TSD::Barge).move(+0.0F, +2.0F, TSD::Body3);
+		body.move(+1.0F, +0.5F, TSD::Body4).move(+1.0F, +0.0F, TSD::tail).move(+1.0F, +0.0F, TSD::Body5);
+		body.move(+1.0F, -0.5F, TSD::Body6).move(+0.0F, -3.0F, TSD::SB_Suction).move(+0.0F, -3.0F, TSD::Body7);
+		body.move_to(TSD::Body1).move(+0.0F, +0.5F, TSD::bridge).move(+0.0F, +1.5F, TSD::GPS1).move(+0.0F, +3.5F, TSD::GPS2);
+		body.move_to(TSD::tail).move(+0.0F, +1.0F);
+
+		body.jump(-1.2F, -5.0F, TSD::Hopper1).move(+0.0F, +3.0F, TSD::Hopper2).move(+2.4F, +0.0F, TSD::Hopper3);
+		body.move(+0.0F, -3.0F, TSD::Hopper4).move_to(TSD::Hopper1);
+
+		body.jump_back(TSD::Body5).move(+2.0F, +0.0F, TSD::y);
+		body.jump_back(TSD::Body4).move(-2.0F, +0.0F, TSD::origin).move(+0.0F, -8.0F, TSD::x);
+
+		return body;
+	}();
+
+	static constexpr SketchScript<TSD, 16> bridge_sketch = []() {
+		SketchScript<TSD, 16> bridge(TSD::Bridge3);
+
+		bridge.move(-1.0F, -0.5F, TSD::Bridge2).move(+0.0F, -1.0F, TSD::Bridge1);
+		bridge.move(+2.0F, -0.5F, TSD::Bridge10).move(+0.5F, -0.5F, TSD::Bridge9).move(+1.0F, +0.0F, TSD::Bridge8);
+		bridge.move(+0.5F, +0.5F, TSD::Bridge7).move(+2.0F, +0.5F, TSD::Bridge6).move(+0.0F, +1.0F, TSD::Bridge5);
+		bridge.move(-1.0F, +0.5F, TSD::Bridge4).move_to(TSD::Bridge3);
+
+		return bridge;
+	}();
+
+	static_assert(body_sketch.okay() && bridge_sketch.okay(), "sketch overflow");
+	static_assert(body_sketch.x(TSD::Body2) == -body_sketch.x(TSD::Body7), "the hull should be symmetric");
+	static_assert(body_sketch.x(TSD::Body4) == -body_sketch.x(TSD::Body5), "the stern should be symmetric");
+	static_assert(body_sketch.y(TSD::PS_Suction) == body_sketch.y(TSD::SB_Suction), "suctions should be abreast");
+	static_assert(body_sketch.x(TSD::GPS1) == body_sketch.x(TSD::Body1), "antennas should be on the center line");
+	static_assert((bridge_sketch.x(TSD::Bridge2) + bridge_sketch.x(TSD::Bridge5) == bridge_sketch.x(TSD::Bridge3) + bridge_sketch.x(TSD::Bridge4))
+		&& (bridge_sketch.x(TSD::Bridge1) + bridge_sketch.x(TSD::Bridge6) == bridge_sketch.x(TSD::Bridge3) + bridge_sketch.x(TSD::Bridge4))
+		&& (bridge_sketch.x(TSD::Bridge10) + bridge_sketch.x(TSD::Bridge7) == bridge_sketch.x(TSD::Bridge3) + bridge_sketch.x(TSD::Bridge4))
+		&& (bridge_sketch.x(TSD::Bridge9) + bridge_sketch.x(TSD::Bridge8) == bridge_sketch.x(TSD::Bridge3) + bridge_sketch.x(TSD::Bridge4)),
+		"the bridge should be symmetric");
+
 	static void align_label(Tracklet<TSD>* target, TSD id, Labellet* label, float ahsize, float csize) {
 		GraphletAnchor a = GraphletAnchor::CC;
 		float xoff = 0.0F;
@@ -91,22 +174,9 @@ namespace {
 			this->decorates[TSD::Barge] = this->insert_one(new Circlelet(4.0F, 0xDDDDDD));
 			
 			{ // load body sketch
-				Turtle<TSD>* body = new Turtle<TSD>(stepsize, false);
 				TSD axes[] = { TSD::x, TSD::origin, TSD::y };
 				TSD hoppers[] = { TSD::Hopper1, TSD::Hopper2, TSD::Hopper3, TSD::Hopper4, TSD::Hopper1 };
-
-				body->move_down(1.0F, TSD::Body1)->move_left_down(2.0F, 1.0F, TSD::Body2);
-				body->move_down(3.0F, TSD::PS_Suction)->move_down(1.0F, TSD::Barge)->move_down(2.0F, TSD::Body3);
-				body->move_right_down(1.0F, 0.5F, TSD::Body4)->move_right(1.0F, TSD::tail)->move_right(1.0F, TSD::Body5);
-				body->move_right_up(1.0F, 0.5F, TSD::Body6)->move_up(3.0F, TSD::SB_Suction)->move_up(3.0F, TSD::Body7);
-				body->move_to(TSD::Body1)->move_down(0.5F, TSD::bridge)->move_down(1.5F, TSD::GPS1)->move_down(3.5F, TSD::GPS2);
-				body->move_to(TSD::tail)->move_down(1.0F);
-
-				body->jump_left_up(1.2F, 5.0F, TSD::Hopper1)->move_down(3.0F, TSD::Hopper2)->move_right(2.4F, TSD::Hopper3);
-				body->move_up(3.0F, TSD::Hopper4)->move_to(TSD::Hopper1);
-
-				body->jump_back(TSD::Body5)->move_right(2.0F, TSD::y);
-				body->jump_back(TSD::Body4)->move_left(2.0F, TSD::origin)->move_up(8.0F, TSD::x);
+				Turtle<TSD>* body = sketch_replay(new Turtle<TSD>(stepsize, false, body_sketch.home_anchor()), body_sketch);
 
 				this->body = this->insert_one(new Tracklet(body, thickness, original_color));
 				this->body->push_subtrack(axes, axes_color);
@@ -115,12 +185,7 @@ namespace {
 			}
 
 			{ // load bridge sketch
-				Turtle<TSD>* bridge = new Turtle<TSD>(stepsize, false, TSD::Bridge3);
-				
-				bridge->move_left_up(1.0F, 0.5F, TSD::Bridge2)->move_up(1.0F, TSD::Bridge1);
-				bridge->move_right_up(2.0F, 0.5F, TSD::Bridge10)->move_right_up(0.5F, 0.5F, TSD::Bridge9)->move_right(1.0F, TSD::Bridge8);
-				bridge->move_right_down(0.5F, 0.5F, TSD::Bridge7)->move_right_down(2.0F, 0.5F, TSD::Bridge6)->move_down(1.0F, TSD::Bridge5);
-				bridge->move_left_down(1.0F, 0.5F, TSD::Bridge4)->move_to(TSD::Bridge3);
+				Turtle<TSD>* bridge = sketch_replay(new Turtle<TSD>(stepsize, false, bridge_sketch.home_anchor()), bridge_sketch);
 
 				this->bridge = this->insert_one(new Tracklet(bridge, thickness, bridge_color));
 			}
@@ -186,17 +251,22 @@ namespace {
 	private: // never delete these graphlet manually
 		Tracklet<TSD>* body;
 		Tracklet<TSD>* bridge;
-		std::map<TSD, Labellet*> body_labels;
-		std::map<TSD, Labellet*> bridge_labels;
-		std::map<TSD, Shapelet*> decorates;
+		EnumArray<TSD, Labellet*, TSD::__> body_labels;
+		EnumArray<TSD, Labellet*> bridge_labels;
+		EnumArray<TSD, Shapelet*, TSD::__> decorates;
 	};
 }
 
 class WarGrey::SCADA::TrailingSuctionDredgerEditor::Self {
 public:
-	Self(TrailingSuctionDredgerEditor* master, Platform::String^ vessel) : master(master), label_max_width(0.0F), vessel(vessel), entity(nullptr) {
+	Self(TrailingSuctionDredgerEditor* master, Platform::String^ vessel)
+		: master(master), label_max_width(0.0F), vessel(vessel), entity(nullptr), stale_inputs(false), dredger(nullptr), fleet(64) {
 		this->input_style = make_highlight_dimension_style(label_font->FontSize, 7U, 1U);
 		this->input_style.unit_color = label_color;
+		this->statistics = TrailingSuctionDredgerEditStatistics();
+
+		this->fleet_insert(vessel);
+		this->fleet.select(0);
 	}
 
 public:
@@ -214,16 +284,11 @@ public:
 
 		this->sketch = this->master->insert_one(new Planetlet(new SketchMap()));
 		
-		{ /** WARNING
-		   * Although TrailingSuctionDredgerlet is an asynchronouse graphlet, it has probably been loaded already,
-		   *  thus, the `Planet::on_graghlet_ready()` might be invoked before `Planet::insert()` returns
-		   *  in which case `this->dredger` is still `nullptr` if these two statements are combined.
-		   *
-		   * Also see `this->on_graphlet_ready()`, it checks the graphlet type with `this->dredger == g` instead of dynamic casting.
-		   */
-			this->dredger = new TrailingSuctionDredgerlet(this->vessel, 1.2F);
-			this->master->insert(this->dredger);
+		for (size_t slot = 0; slot < this->members.size(); slot++) {
+			this->load_member(slot);
 		}
+
+		this->dredger = this->members[this->fleet.active()].dredger;
 	}
 
 	void reflow(IGraphlet* frame, float width, float height, float inset) {
@@ -240,25 +305,51 @@ public:
 		this->reflow_input_fields(this->X[1], TSD::Bridge1, TSD::_, inset, pheight, TSD::Trunnion);
 
 		this->master->move_to(this->sketch, frame, GraphletAnchor::RT, GraphletAnchor::RT, -inset, inset);
-		this->master->move_to(this->dredger, this->sketch, GraphletAnchor::CB, GraphletAnchor::CT, 0.0F, inset);
+
+		for (size_t slot = 0; slot < this->members.size(); slot++) {
+			this->master->move_to(this->members[slot].dredger, this->sketch, GraphletAnchor::CB, GraphletAnchor::CT, 0.0F, inset);
+		}
 	}
 
 	void on_graphlet_ready(IGraphlet* g) {
-		if (this->dredger == g) { // also see `this->load()`
-			this->entity = this->dredger->clone_vessel(this->entity, true);
-			this->refresh_input_fields();
+		for (size_t slot = 0; slot < this->members.size(); slot++) {
+			FleetMember* m = &this->members[slot];
+
+			if (m->dredger == g) { // also see `this->load_member()`
+				m->ready = true;
+
+				if (slot == this->fleet.active()) {
+					this->entity = m->dredger->clone_vessel(this->entity, true);
+					this->refresh_input_fields();
+					this->intern_member(slot, this->entity);
+
+					if (this->stale_inputs) {
+						this->stale_inputs = false;
+						this->enable_input_fields(true);
+					}
+				} else {
+					m->entity = m->dredger->clone_vessel(m->entity, true);
+					this->intern_member(slot, m->entity);
+				}
+
+				break;
+			}
 		}
 	}
 
 public:
 	bool on_edit(Credit<Dimensionlet, TSD>* dim) {
 		long double new_value = dim->get_input_number();
-		bool modified = (new_value != dim->get_value());
+		bool modified = (!this->stale_inputs) && (new_value != dim->get_value());
 
 		if (modified) {
 			dim->set_value(new_value);
 
-			this->refresh_entity();
+			if (this->entity == nullptr) {
+				this->refresh_entity();
+			} else if (dim->id < TSD::_) {
+				this->refresh_vertex(dim->id);
+			}
 
 			this->dredger->moor(GraphletAnchor::RB);
 			this->dredger->preview(this->entity);
@@ -269,10 +360,19 @@ public:
 	}
 
 	bool on_apply() {
-		this->refresh_entity(); // duplicate work
-		this->dredger->refresh(this->entity);
+		bool okay = !this->stale_inputs;
 
-		return true;
+		if (okay) {
+			if (this->entity == nullptr) { // otherwise, edits have been patched into the entity
+				this->refresh_entity();
+			}
+
+			this->dredger->refresh(this->entity);
+			this->intern_member(this->fleet.active(), this->entity);
+			this->statistics.dirty_shapes = 0U;
+		}
+
+		return okay;
 	}
 
 	bool on_reset() {
@@ -283,6 +383,8 @@ public:
 			this->refresh_input_fields();
 		}
 
+		this->statistics.dirty_shapes = 0U;
+
 		return true;
 	}
 
@@ -291,6 +393,81 @@ public:
 		return this->sketch;
 	}
 
+	TrailingSuctionDredgerEditStatistics edit_statistics() {
+		return this->statistics;
+	}
+
+public:
+	bool fleet_insert(Platform::String^ vessel) {
+		bool okay = true;
+
+		if (this->fleet.find(vessel->Data()) == VesselFleet::npos) {
+			size_t slot = this->fleet.insert(vessel->Data(), VesselOutline());
+
+			okay = (slot != VesselFleet::npos);
+
+			if (okay) {
+				this->members.push_back({ vessel, nullptr, nullptr, false });
+
+				if (this->dredger != nullptr) { // the editor has been loaded
+					this->load_member(slot);
+				}
+			}
+		}
+
+		return okay;
+	}
+
+	bool fleet_switch(Platform::String^ vessel) {
+		size_t slot = this->fleet.find(vessel->Data());
+		size_t current = this->fleet.active();
+		bool okay = (slot != VesselFleet::npos);
+
+		if (okay && (slot != current)) {
+			FleetMember* from = &this->members[current];
+			FleetMember* to = &this->members[slot];
+
+			// edits not applied yet stay in the entity of the member, until it is applied or reset
+			from->entity = this->entity;
+			this->entity = to->entity;
+			this->fleet.select(slot);
+
+			if (this->dredger != nullptr) {
+				this->dredger->preview(nullptr);
+				from->dredger->camouflage(true);
+				to->dredger->camouflage(false);
+				this->dredger = to->dredger;
+
+				if (this->entity != nullptr) { // redraws edits that were left pending in the member
+					this->dredger->preview(this->entity);
+				}
+			}
+
+			/** NOTE
+			 * Until the member is loaded, the input fields still hold the vertices of the previous one,
+			 *  and the first edit would copy all of them into the new member via `this->refresh_entity()`,
+			 *  hence they stay read-only until `this->on_graphlet_ready()`.
+			 */
+			this->statistics.dirty_shapes = 0U;
+			this->refresh_input_fields();
+
+			if ((this->dredger != nullptr) && (this->stale_inputs == to->ready)) {
+				this->stale_inputs = !to->ready;
+				this->enable_input_fields(to->ready);
+			}
+		}
+
+		return okay;
+	}
+
+	Platform::String^ fleet_active() {
+		return this->members[this->fleet.active()].name;
+	}
+
+	std::shared_ptr<const VesselOutline> fleet_outline(Platform::String^ vessel) {
+		return this->fleet.shared_outline(this->fleet.find(vessel->Data()));
+	}
+
 private:
 	void refresh_entity() {
 		if (this->entity == nullptr) {
@@ -327,6 +504,89 @@ private:
 		Vessel_Refresh_Vertex(this->entity, bridge_vertices[7], this->xs, this->ys, TSD::Bridge8);
 		Vessel_Refresh_Vertex(this->entity, bridge_vertices[8], this->xs, this->ys, TSD::Bridge9);
 		Vessel_Refresh_Vertex(this->entity, bridge_vertices[9], this->xs, this->ys, TSD::Bridge10);
+
+		this->count_rebuilt(_I(TSD::_), static_cast<unsigned int>(TSDShape::All));
+	}
+
+	void refresh_vertex(TSD id) {
+		switch (id) {
+		case TSD::GPS1: Vessel_Refresh_Vertex(this->entity, gps[0], this->xs, this->ys, TSD::GPS1); break;
+		case TSD::GPS2: Vessel_Refresh_Vertex(this->entity, gps[1], this->xs, this->ys, TSD::GPS2); break;
+		case TSD::PS_Suction: Vessel_Refresh_Vertex(this->entity, ps_suction, this->xs, this->ys, TSD::PS_Suction); break;
+		case TSD::SB_Suction: Vessel_Refresh_Vertex(this->entity, sb_suction, this->xs, this->ys, TSD::SB_Suction); break;
+		case TSD::Trunnion: Vessel_Refresh_Vertex(this->entity, trunnion, this->xs, this->ys, TSD::Trunnion); break;
+		case TSD::Barge: Vessel_Refresh_Vertex(this->entity, barge, this->xs, this->ys, TSD::Barge); break;
+		default: {
+			if ((id >= TSD::Body1) && (id <= TSD::Body7)) {
+				unsigned int idx = _I(id) - _I(TSD::Body1);
+
+				Vessel_Refresh_Vertex(this->entity, body_vertices[idx], this->xs, this->ys, id);
+			} else if ((id >= TSD::Hopper1) && (id <= TSD::Hopper4)) {
+				unsigned int idx = _I(id) - _I(TSD::Hopper1);
+
+				Vessel_Refresh_Vertex(this->entity, hopper_vertices[idx], this->xs, this->ys, id);
+			} else if ((id >= TSD::Bridge1) && (id <= TSD::Bridge10)) {
+				unsigned int idx = _I(id) - _I(TSD::Bridge1);
+
+				Vessel_Refresh_Vertex(this->entity, bridge_vertices[idx], this->xs, this->ys, id);
+			}
+		}
+		}
+
+		this->count_rebuilt(1U, shape_of(id));
+	}
+
+	void load_member(size_t slot) {
+		/** WARNING
+		 * Although TrailingSuctionDredgerlet is an asynchronouse graphlet, it has probably been loaded already,
+		 *  thus, the `Planet::on_graghlet_ready()` might be invoked before `Planet::insert()` returns
+		 *  in which case `dredger` of the member is still `nullptr` if these two statements are combined.
+		 *
+		 * Also see `this->on_graphlet_ready()`, it checks the graphlet type with `m->dredger == g` instead of dynamic casting.
+		 */
+		FleetMember* m = &this->members[slot];
+
+		m->dredger = new TrailingSuctionDredgerlet(m->name, 1.2F);
+		this->master->insert(m->dredger);
+
+		if (slot != this->fleet.active()) {
+			m->dredger->camouflage(true);
+		}
+	}
+
+	void intern_member(size_t slot, TrailingSuctionDredger^ entity) {
+		if (entity != nullptr) {
+			VesselOutline outline;
+
+			vessel_outline_fill(&outline, entity);
+			this->fleet.reshape(slot, outline);
+		}
+	}
+
+	void count_rebuilt(unsigned int vertices, unsigned int shapes) {
+		/** NOTE
+		 * `TrailingSuctionDredgerlet::preview()` takes the whole entity and redraws all sub-shapes,
+		 *  the touched ones only go to `dirty_shapes`, which is what a partial redraw would have to rebuild.
+		 */
+		this->statistics.edits++;
+		this->statistics.last_vertices = vertices;
+		this->statistics.last_shapes = shape_count(static_cast<unsigned int>(TSDShape::All));
+		this->statistics.vertices += vertices;
+		this->statistics.shapes += this->statistics.last_shapes;
+		this->statistics.dirty_shapes |= shapes;
+	}
+
+	void enable_input_fields(bool yes) {
+		DimensionState state = (yes ? DimensionState::Input : DimensionState::Default);
+
+		this->master->begin_update_sequence();
+
+		for (TSD id = _E0(TSD); id < TSD::_; id++) {
+			this->xs[id]->set_state(state);
+			this->ys[id]->set_state(state);
+		}
+
+		this->master->end_update_sequence();
 	}
 
 	void refresh_input_fields() {
@@ -406,20 +666,32 @@ private:
 		}
 	}
 
+private:
+	struct FleetMember {
+		Platform::String^ name;
+		TrailingSuctionDredgerlet* dredger;
+		TrailingSuctionDredger^ entity; // of inactive members, that of the active one is `this->entity`
+		bool ready; // `this->on_graphlet_ready()` has been received
+	};
+
 private:
 	float label_max_width;
 	DimensionStyle input_style;
+	TrailingSuctionDredgerEditStatistics statistics;
 	TrailingSuctionDredger^ entity;
+	bool stale_inputs; // the active member has not been loaded yet, and the input fields are those of the previous one
 	Platform::String^ vessel;
+	std::vector<FleetMember> members; // indexed by slots of the fleet
+	VesselFleet fleet;
 
 private: // never delete these graphlet manually
 	TrailingSuctionDredgerlet* dredger;
 	Planetlet* sketch;
 	Labellet* X[2];
 	Labellet* Y[2];
-	std::map<TSD, Labellet*> labels;
-	std::map<TSD, Credit<Dimensionlet, TSD>*> xs;
-	std::map<TSD, Credit<Dimensionlet, TSD>*> ys;
+	EnumArray<TSD, Labellet*> labels;
+	EnumArray<TSD, Credit<Dimensionlet, TSD>*> xs;
+	EnumArray<TSD, Credit<Dimensionlet, TSD>*> ys;
 	
 private:
 	TrailingSuctionDredgerEditor* master;
@@ -460,6 +732,26 @@ IGraphlet* TrailingSuctionDredgerEditor::thumbnail_graphlet() {
 	return this->self->thumbnail();
 }
 
+TrailingSuctionDredgerEditStatistics TrailingSuctionDredgerEditor::edit_statistics() {
+	return this->self->edit_statistics();
+}
+
+bool TrailingSuctionDredgerEditor::fleet_insert(Platform::String^ vessel) {
+	return this->self->fleet_insert(vessel);
+}
+
+bool TrailingSuctionDredgerEditor::fleet_switch(Platform::String^ vessel) {
+	return this->self->fleet_switch(vessel);
+}
+
+Platform::String^ TrailingSuctionDredgerEditor::fleet_active() {
+	return this->self->fleet_active();
+}
+
+std::shared_ptr<const VesselOutline> TrailingSuctionDredgerEditor::fleet_outline(Platform::String^ vessel) {
+	return this->self->fleet_outline(vessel);
+}
+
 bool TrailingSuctionDredgerEditor::on_apply() {
 	return this->self->on_apply();
 }
@@ -1,8 +1,26 @@
 #pragma once
 
+#include <memory>
+
 #include "editor.hpp"
 
+#include "device/vessel/vessel_pose.hpp"
+
 namespace WarGrey::SCADA {
+	/**
+	 * Vertices patched into the entity and sub-shapes of the preview redrawn by edits,
+	 *   the preview is always redrawn as a whole, hence `shapes` and `last_shapes` count all sub-shapes of the vessel;
+	 *   `dirty_shapes` accumulates the sub-shapes (as bits) actually touched since the last apply or reset.
+	 */
+	struct TrailingSuctionDredgerEditStatistics {
+		unsigned int edits;
+		unsigned int vertices;
+		unsigned int shapes;
+		unsigned int last_vertices;
+		unsigned int last_shapes;
+		unsigned int dirty_shapes;
+	};
+
 	private class TrailingSuctionDredgerEditor : public WarGrey::DTPM::EditorPlanet {
 	public:
 		virtual ~TrailingSuctionDredgerEditor() noexcept;
@@ -14,6 +32,15 @@ namespace WarGrey::SCADA {
 		void on_graphlet_ready(WarGrey::SCADA::IGraphlet* g) override;
 		IGraphlet* thumbnail_graphlet() override;
 
+	public:
+		WarGrey::SCADA::TrailingSuctionDredgerEditStatistics edit_statistics();
+
+	public: // fleet mode, vessels share the input fields and the sketch, switching only swaps the active entity and its preview
+		bool fleet_insert(Platform::String^ vessel); // `false` if the fleet is full (64 vessels), existing vessels are fine
+		bool fleet_switch(Platform::String^ vessel);
+		Platform::String^ fleet_active();
+		std::shared_ptr<const WarGrey::DTPM::VesselOutline> fleet_outline(Platform::String^ vessel); // shared by sister ships
+
 	protected:
 		bool on_apply() override;
 		bool on_reset() override;
@@ -0,0 +1,321 @@
+#include "device/vessel/vessel_fleet.hpp"
+
+using namespace WarGrey::SCADA;
+using namespace WarGrey::DTPM;
+
+/*************************************************************************************************/
+namespace {
+	template<typename F>
+	static void outline_for_each(const VesselOutline& outline, F f) {
+		f(outline.gps[0]);
+		f(outline.gps[1]);
+		f(outline.ps_suction);
+		f(outline.sb_suction);
+		f(outline.trunnion);
+		f(outline.barge);
+
+		for (size_t idx = 0; idx < sizeof(outline.body_vertices) / sizeof(double2); idx++) {
+			f(outline.body_vertices[idx]);
+		}
+
+		for (size_t idx = 0; idx < sizeof(outline.hopper_vertices) / sizeof(double2); idx++) {
+			f(outline.hopper_vertices[idx]);
+		}
+
+		for (size_t idx = 0; idx < sizeof(outline.bridge_vertices) / sizeof(double2); idx++) {
+			f(outline.bridge_vertices[idx]);
+		}
+	}
+
+	static inline uint64_t fnv1a_double(uint64_t hash, double v) {
+		union { double d; uint64_t u; } bits;
+
+		bits.d = v + 0.0; // +0.0 and -0.0 should not make difference
+
+		for (int shift = 0; shift < 64; shift += 8) {
+			hash ^= (bits.u >> shift) & 0xFFU;
+			hash *= 0x100000001B3ULL;
+		}
+
+		return hash;
+	}
+
+	static uint64_t outline_hash(const VesselOutline& outline) {
+		uint64_t hash = 0xCBF29CE484222325ULL;
+
+		outline_for_each(outline, [&hash](const double2& v) {
+			hash = fnv1a_double(hash, v.x);
+			hash = fnv1a_double(hash, v.y);
+		});
+
+		return hash;
+	}
+
+	static bool outline_equal(const VesselOutline& lhs, const VesselOutline& rhs) {
+		double2 vertices[27];
+		size_t idx = 0;
+		bool equal = true;
+
+		outline_for_each(lhs, [&vertices, &idx](const double2& v) { vertices[idx++] = v; });
+		idx = 0;
+		outline_for_each(rhs, [&vertices, &idx, &equal](const double2& v) {
+			equal = equal && (vertices[idx].x == v.x) && (vertices[idx].y == v.y);
+			idx++;
+		});
+
+		return equal;
+	}
+}
+
+/*************************************************************************************************/
+VesselFleet::VesselFleet(size_t capacity) : capacity((capacity > 0) ? capacity : 1), selected(npos) {
+	this->names.reserve(this->capacity);
+	this->outlines.reserve(this->capacity);
+	this->slots.reserve(this->capacity);
+}
+
+size_t VesselFleet::insert(const std::wstring& name, const VesselOutline& outline) {
+	size_t slot = this->find(name);
+
+	if (slot != npos) {
+		this->reshape(slot, outline);
+	} else if (this->names.size() < this->capacity) {
+		slot = this->names.size();
+		this->names.push_back(name);
+		this->outlines.push_back(this->intern(outline));
+		this->slots[name] = slot;
+	}
+
+	return slot;
+}
+
+bool VesselFleet::reshape(size_t slot, const VesselOutline& outline) {
+	bool okay = (slot < this->outlines.size());
+
+	if (okay) {
+		this->outlines[slot] = this->intern(outline);
+	}
+
+	return okay;
+}
+
+size_t VesselFleet::find(const std::wstring& name) {
+	auto it = this->slots.find(name);
+
+	return ((it == this->slots.end()) ? npos : it->second);
+}
+
+bool VesselFleet::select(size_t slot) {
+	bool okay = (slot < this->outlines.size());
+
+	if (okay) {
+		this->selected = slot;
+	}
+
+	return okay;
+}
+
+size_t VesselFleet::active() {
+	return this->selected;
+}
+
+const VesselOutline& VesselFleet::outline(size_t slot) {
+	return *this->outlines[slot];
+}
+
+std::shared_ptr<const VesselOutline> VesselFleet::shared_outline(size_t slot) {
+	return ((slot < this->outlines.size()) ? this->outlines[slot] : nullptr);
+}
+
+const std::wstring& VesselFleet::name(size_t slot) {
+	return this->names[slot];
+}
+
+size_t VesselFleet::size() {
+	return this->names.size();
+}
+
+size_t VesselFleet::geometry_count() {
+	size_t count = 0;
+
+	for (auto it = this->geometries.begin(); it != this->geometries.end(); it++) {
+		if (!it->second.expired()) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/*************************************************************************************************/
+std::shared_ptr<const VesselOutline> VesselFleet::intern(const VesselOutline& outline) {
+	uint64_t hash = outline_hash(outline);
+	auto range = this->geometries.equal_range(hash);
+	std::shared_ptr<const VesselOutline> shared = nullptr;
+
+	for (auto it = range.first; it != range.second;) {
+		std::shared_ptr<const VesselOutline> candidate = it->second.lock();
+
+		if (candidate == nullptr) { // no member holds it any more
+			it = this->geometries.erase(it);
+		} else {
+			if ((shared == nullptr) && outline_equal(*candidate, outline)) {
+				shared = candidate;
+			}
+
+			it++;
+		}
+	}
+
+	if (shared == nullptr) {
+		shared = std::make_shared<const VesselOutline>(outline);
+		this->geometries.emplace(hash, shared);
+	}
+
+	return shared;
+}
+
+/*************************************************************************************************/
+#ifdef VESSEL_FLEET_MAIN
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include "config_image.hpp"
+
+namespace {
+	void make_class(VesselOutline* outline, double scale) {
+		double2 body[7] = { double2(60.0, 0.0), double2(52.0, -8.0), double2(-36.0, -8.0), double2(-40.0, -4.0), double2(-40.0, 4.0), double2(-36.0, 8.0), double2(52.0, 8.0) };
+		double2 hopper[4] = { double2(36.0, -5.0), double2(-8.0, -5.0), double2(-8.0, 5.0), double2(36.0, 5.0) };
+
+		outline->gps[0] = double2(40.0 * scale, 0.0);
+		outline->gps[1] = double2(-20.0 * scale, 0.0);
+		outline->ps_suction = double2(10.0 * scale, -8.0 * scale);
+		outline->sb_suction = double2(10.0 * scale, 8.0 * scale);
+		outline->trunnion = double2(1.5, 0.5);
+		outline->barge = double2(0.0, -8.0 * scale);
+
+		for (size_t idx = 0; idx < 7; idx++) {
+			outline->body_vertices[idx] = double2(body[idx].x * scale, body[idx].y * scale);
+		}
+
+		for (size_t idx = 0; idx < 4; idx++) {
+			outline->hopper_vertices[idx] = double2(hopper[idx].x * scale, hopper[idx].y * scale);
+		}
+
+		for (size_t idx = 0; idx < 10; idx++) {
+			outline->bridge_vertices[idx] = double2((-24.0 - double(idx % 5)) * scale, (double(idx) - 4.5) * scale);
+		}
+	}
+
+	double percentile(std::vector<double>& samples, double p) {
+		size_t idx = std::min(samples.size() - 1, size_t(double(samples.size()) * p));
+
+		std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+
+		return samples[idx];
+	}
+}
+
+/**
+ * 50 vessels of 10 classes (5 sister ships each), switched at random `rounds` times,
+ *   a switch finds the member by name, selects it, and displays its 54 coordinates as the editor does,
+ *   compared with reloading the vessel from its configuration image as switching does without the fleet.
+ */
+int main(int argc, char* argv[]) {
+	size_t rounds = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 100000U);
+	std::string root = ((argc > 2) ? argv[2] : "/tmp");
+	const size_t vessel_count = 50;
+	VesselFleet fleet(vessel_count);
+	std::vector<std::wstring> names;
+	std::vector<std::string> paths;
+	std::vector<double> fleet_ns, reload_ns;
+	std::mt19937_64 prng(0);
+	double fields[54];
+	double sink = 0.0;
+
+	for (size_t idx = 0; idx < vessel_count; idx++) {
+		VesselOutline outline;
+		VesselImage image;
+
+		make_class(&outline, 1.0 + double(idx / 5) * 0.1);
+		names.push_back(L"hopper" + std::to_wstring(idx));
+		paths.push_back(root + "/hopper" + std::to_string(idx) + ".cfg");
+		fleet.insert(names.back(), outline);
+
+		config_vessel_fill(&image, &outline);
+		config_image_save(paths.back(), image);
+	}
+
+	if (fleet.geometry_count() != vessel_count / 5) {
+		fprintf(stderr, "sister ships are not interned: %zu geometries\n", fleet.geometry_count());
+		return 1;
+	}
+
+	{ // copy on write
+		VesselOutline outline = fleet.outline(0);
+		const VesselOutline* sister = fleet.shared_outline(1).get();
+
+		outline.barge.x += 1.0;
+		fleet.reshape(0, outline);
+
+		if ((fleet.shared_outline(1).get() != sister) || (fleet.shared_outline(0).get() == sister) || (fleet.geometry_count() != vessel_count / 5 + 1)) {
+			fprintf(stderr, "reshaping a sister ship disturbs the others\n");
+			return 1;
+		}
+	}
+
+	fleet_ns.reserve(rounds);
+	reload_ns.reserve(rounds);
+
+	for (size_t r = 0; r < rounds; r++) {
+		size_t which = size_t(prng() % vessel_count);
+
+		auto t0 = std::chrono::steady_clock::now();
+		if (fleet.select(fleet.find(names[which]))) {
+			size_t idx = 0;
+
+			outline_for_each(fleet.outline(fleet.active()), [&fields, &idx](const double2& v) {
+				fields[idx++] = v.x;
+				fields[idx++] = v.y;
+			});
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		sink += fields[which % 54];
+
+		{
+			ConfigImage image;
+			VesselOutline vessel; // stands for `TrailingSuctionDredger^`
+
+			auto t2 = std::chrono::steady_clock::now();
+			if (image.open(paths[which]) && (image.record<VesselImage>() != nullptr)) {
+				size_t idx = 0;
+
+				config_vessel_restore(&vessel, *image.record<VesselImage>());
+				outline_for_each(vessel, [&fields, &idx](const double2& v) {
+					fields[idx++] = v.x;
+					fields[idx++] = v.y;
+				});
+			}
+			auto t3 = std::chrono::steady_clock::now();
+
+			sink += fields[which % 54];
+			reload_ns.push_back(std::chrono::duration<double, std::nano>(t3 - t2).count());
+		}
+
+		fleet_ns.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+	}
+
+	printf("%zu switches among %zu vessels (%zu geometries), checksum %g\n", rounds, fleet.size(), fleet.geometry_count(), sink);
+	printf("  fleet:  p50 %8.1f ns, p99 %8.1f ns\n", percentile(fleet_ns, 0.50), percentile(fleet_ns, 0.99));
+	printf("  reload: p50 %8.1f ns, p99 %8.1f ns\n", percentile(reload_ns, 0.50), percentile(reload_ns, 0.99));
+
+	for (size_t idx = 0; idx < paths.size(); idx++) {
+		remove(paths[idx].c_str());
+	}
+
+	return 0;
+}
+#endif
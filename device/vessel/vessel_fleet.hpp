@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "device/vessel/vessel_pose.hpp"
+
+namespace WarGrey::DTPM {
+	/**
+	 * Vessels of a fleet loaded together, each is given a slot once it is inserted, slots never move.
+	 *
+	 * Outlines are interned by contents, sister ships share one immutable `VesselOutline`,
+	 *   reshaping a member re-interns its outline rather than modifying the shared one, hence copy-on-write for free.
+	 * Selecting a member is O(1), and so is finding a member by name.
+	 */
+	class VesselFleet {
+	public:
+		static const size_t npos = static_cast<size_t>(-1);
+
+	public:
+		VesselFleet(size_t capacity = 64);
+
+	public:
+		/**
+		 * returns the slot of the member, or `npos` if the fleet is full,
+		 *   inserting an existing name reshapes that member.
+		 */
+		size_t insert(const std::wstring& name, const WarGrey::DTPM::VesselOutline& outline);
+		bool reshape(size_t slot, const WarGrey::DTPM::VesselOutline& outline);
+		size_t find(const std::wstring& name);
+
+	public:
+		bool select(size_t slot);
+		size_t active();
+
+	public:
+		const WarGrey::DTPM::VesselOutline& outline(size_t slot);
+		std::shared_ptr<const WarGrey::DTPM::VesselOutline> shared_outline(size_t slot);
+		const std::wstring& name(size_t slot);
+		size_t size();
+		size_t geometry_count(); // distinct outlines being shared
+
+	private:
+		std::shared_ptr<const WarGrey::DTPM::VesselOutline> intern(const WarGrey::DTPM::VesselOutline& outline);
+
+	private:
+		std::vector<std::wstring> names;
+		std::vector<std::shared_ptr<const WarGrey::DTPM::VesselOutline>> outlines;
+		std::unordered_map<std::wstring, size_t> slots;
+		std::unordered_multimap<uint64_t, std::weak_ptr<const WarGrey::DTPM::VesselOutline>> geometries;
+		size_t capacity;
+		size_t selected;
+	};
+}
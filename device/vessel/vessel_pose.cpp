@@ -0,0 +1,393 @@
+#include <cmath>
+
+#include "device/vessel/vessel_pose.hpp"
+
+using namespace WarGrey::SCADA;
+using namespace WarGrey::DTPM;
+
+static const double pi = 3.14159265358979323846;
+static const double seconds_per_day = 86400.0;
+
+/*************************************************************************************************/
+namespace {
+	static inline double2 body_to_plane(const double2& p, const double2& origin, double c, double s) {
+		return double2(origin.x + p.x * c - p.y * s, origin.y + p.x * s + p.y * c);
+	}
+
+	static inline bool fix_okay(const GPSFix& fix) {
+		return (fix.quality > 0);
+	}
+
+	static inline double utc_difference(double t1, double t2) { // t1 - t2, wrapped around the midnight
+		double diff = t1 - t2;
+
+		if (diff > seconds_per_day * 0.5) {
+			diff -= seconds_per_day;
+		} else if (diff < -seconds_per_day * 0.5) {
+			diff += seconds_per_day;
+		}
+
+		return diff;
+	}
+}
+
+/*************************************************************************************************/
+VesselPoseEngine::VesselPoseEngine(const VesselOutline& outline, size_t capacity, double baseline_tolerance, double pair_window)
+	: baseline_tolerance(baseline_tolerance), pair_window(pair_window), staged(0), capacity((capacity > 0) ? capacity : 1) {
+	this->pairs = new GPSFix[this->capacity * 2];
+	this->Bs = new double[this->capacity * 2 * 6];
+	this->Ls = this->Bs + this->capacity * 2;
+	this->Hs = this->Ls + this->capacity * 2;
+	this->xs = this->Hs + this->capacity * 2;
+	this->ys = this->xs + this->capacity * 2;
+	this->zs = this->ys + this->capacity * 2;
+
+	for (size_t a = 0; a < 2; a++) {
+		this->pending_head[a] = 0;
+		this->pending_count[a] = 0;
+	}
+
+	this->reshape(outline);
+}
+
+VesselPoseEngine::~VesselPoseEngine() {
+	delete[] this->pairs;
+	delete[] this->Bs;
+}
+
+void VesselPoseEngine::reshape(const VesselOutline& outline) {
+	double bx = outline.gps[1].x - outline.gps[0].x;
+	double by = outline.gps[1].y - outline.gps[0].y;
+
+	this->outline = outline;
+	this->configured_baseline = sqrt(bx * bx + by * by);
+	this->configured_bearing = atan2(by, bx);
+}
+
+/*************************************************************************************************/
+size_t VesselPoseEngine::feed(const GPSFix* fixes, size_t count, const GCSContext& gcs, VesselPose* poses) {
+	size_t resolved = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (fixes[i].antenna < 2) {
+			this->pair(fixes[i], gcs, poses, &resolved);
+		}
+	}
+
+	if (this->staged > 0) {
+		resolved += this->flush(gcs, poses + resolved);
+	}
+
+	return resolved;
+}
+
+bool VesselPoseEngine::resolve(const GPSFix& gps1, const GPSFix& gps2, const GCSContext& gcs, VesselPose* pose) {
+	double Bs[2] = { gps1.latitude, gps2.latitude };
+	double Ls[2] = { gps1.longitude, gps2.longitude };
+	double Hs[2] = { gps1.altitude, gps2.altitude };
+	double xs[2], ys[2], zs[2];
+
+	gauss_krueger_forward(Bs, Ls, Hs, xs, ys, zs, 2, gcs);
+
+	pose->utc = gps2.utc;
+	pose->gps[0] = double3(xs[0], ys[0], zs[0]);
+	pose->gps[1] = double3(xs[1], ys[1], zs[1]);
+	pose->okay = fix_okay(gps1) && fix_okay(gps2);
+	this->locate(pose);
+
+	return pose->okay;
+}
+
+/*************************************************************************************************/
+size_t VesselPoseEngine::flush(const GCSContext& gcs, VesselPose* poses) {
+	size_t count = this->staged;
+	size_t n = count * 2;
+
+	for (size_t i = 0; i < n; i++) {
+		this->Bs[i] = this->pairs[i].latitude;
+		this->Ls[i] = this->pairs[i].longitude;
+		this->Hs[i] = this->pairs[i].altitude;
+	}
+
+	gauss_krueger_forward(this->Bs, this->Ls, this->Hs, this->xs, this->ys, this->zs, n, gcs);
+
+	for (size_t i = 0; i < count; i++) {
+		VesselPose* pose = &poses[i];
+		size_t a1 = i * 2 + 0;
+		size_t a2 = i * 2 + 1;
+
+		pose->utc = (this->pairs[a1].utc >= this->pairs[a2].utc) ? this->pairs[a1].utc : this->pairs[a2].utc;
+		pose->gps[0] = double3(this->xs[a1], this->ys[a1], this->zs[a1]);
+		pose->gps[1] = double3(this->xs[a2], this->ys[a2], this->zs[a2]);
+		pose->okay = fix_okay(this->pairs[a1]) && fix_okay(this->pairs[a2]);
+		this->locate(pose);
+	}
+
+	this->staged = 0;
+
+	return count;
+}
+
+bool VesselPoseEngine::pair(const GPSFix& fix, const GCSContext& gcs, VesselPose* poses, size_t* resolved) {
+	size_t self = fix.antenna;
+	size_t mate = 1 - self;
+	size_t capacity = sizeof(this->pending[0]) / sizeof(GPSFix);
+	bool paired = false;
+
+	// mates older than the window would never be paired, since fixes of the same antenna come in order
+	while ((this->pending_count[mate] > 0) && !paired) {
+		const GPSFix& candidate = this->pending[mate][this->pending_head[mate]];
+		double diff = utc_difference(fix.utc, candidate.utc);
+
+		if (diff <= this->pair_window) {
+			if (diff >= -this->pair_window) {
+				this->pairs[this->staged * 2 + self] = fix;
+				this->pairs[this->staged * 2 + mate] = candidate;
+				this->staged++;
+				paired = true;
+
+				this->pending_head[mate] = (this->pending_head[mate] + 1) % capacity;
+				this->pending_count[mate]--;
+			}
+
+			break;
+		}
+
+		this->pending_head[mate] = (this->pending_head[mate] + 1) % capacity;
+		this->pending_count[mate]--;
+	}
+
+	if (paired) {
+		if (this->staged == this->capacity) {
+			(*resolved) += this->flush(gcs, poses + (*resolved));
+		}
+	} else {
+		if (this->pending_count[self] == capacity) { // the mate is gone
+			this->pending_head[self] = (this->pending_head[self] + 1) % capacity;
+			this->pending_count[self]--;
+		}
+
+		this->pending[self][(this->pending_head[self] + this->pending_count[self]) % capacity] = fix;
+		this->pending_count[self]++;
+	}
+
+	return paired;
+}
+
+void VesselPoseEngine::locate(VesselPose* pose) {
+	const VesselOutline& src = this->outline;
+	VesselOutline* dest = &pose->outline;
+	double dx = pose->gps[1].x - pose->gps[0].x;
+	double dy = pose->gps[1].y - pose->gps[0].y;
+	double theta = atan2(dy, dx) - this->configured_bearing;
+	double c = cos(theta);
+	double s = sin(theta);
+	double2 g1 = body_to_plane(src.gps[0], double2(0.0, 0.0), c, s);
+	double2 g2 = body_to_plane(src.gps[1], double2(0.0, 0.0), c, s);
+
+	pose->baseline = sqrt(dx * dx + dy * dy);
+	pose->altitude = (pose->gps[0].z + pose->gps[1].z) * 0.5;
+	pose->heading = fmod(theta * 180.0 / pi + 720.0, 360.0);
+
+	// the origin seen by both antennas, averaged
+	pose->origin.x = ((pose->gps[0].x - g1.x) + (pose->gps[1].x - g2.x)) * 0.5;
+	pose->origin.y = ((pose->gps[0].y - g1.y) + (pose->gps[1].y - g2.y)) * 0.5;
+
+	if (fabs(pose->baseline - this->configured_baseline) > this->baseline_tolerance) {
+		pose->okay = false;
+	}
+
+	dest->gps[0] = double2(pose->gps[0].x, pose->gps[0].y);
+	dest->gps[1] = double2(pose->gps[1].x, pose->gps[1].y);
+	dest->ps_suction = body_to_plane(src.ps_suction, pose->origin, c, s);
+	dest->sb_suction = body_to_plane(src.sb_suction, pose->origin, c, s);
+	dest->trunnion = body_to_plane(src.trunnion, pose->origin, c, s);
+	dest->barge = body_to_plane(src.barge, pose->origin, c, s);
+
+	for (size_t i = 0; i < sizeof(src.body_vertices) / sizeof(double2); i++) {
+		dest->body_vertices[i] = body_to_plane(src.body_vertices[i], pose->origin, c, s);
+	}
+
+	for (size_t i = 0; i < sizeof(src.hopper_vertices) / sizeof(double2); i++) {
+		dest->hopper_vertices[i] = body_to_plane(src.hopper_vertices[i], pose->origin, c, s);
+	}
+
+	for (size_t i = 0; i < sizeof(src.bridge_vertices) / sizeof(double2); i++) {
+		dest->bridge_vertices[i] = body_to_plane(src.bridge_vertices[i], pose->origin, c, s);
+	}
+}
+
+/*************************************************************************************************/
+#ifdef VESSEL_POSE_MAIN
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include "device/gps/gcs_benchmark.hpp"
+
+static void nmea_gga(std::string& log, double utc, double latitude, double longitude, double altitude) {
+	char body[128];
+	char sentence[144];
+	unsigned char checksum = 0;
+	int hh = int(utc / 3600.0);
+	int mm = int((utc - hh * 3600.0) / 60.0);
+	double ss = utc - hh * 3600.0 - mm * 60.0;
+
+	snprintf(body, sizeof(body), "GPGGA,%02d%02d%05.2f,%012.7f,%c,%013.7f,%c,4,14,0.7,%.4f,M,0.0,M,,",
+		hh, mm, ss, fabs(latitude), ((latitude < 0.0) ? 'S' : 'N'), fabs(longitude), ((longitude < 0.0) ? 'W' : 'E'), altitude);
+
+	for (const char* p = body; *p != '\0'; p++) {
+		checksum ^= (unsigned char)(*p);
+	}
+
+	snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, checksum);
+	log.append(sentence);
+}
+
+/**
+ * A dredger sails a circle at 10Hz with both antennas reporting,
+ *   the log is replayed once in large chunks for the throughput, and once pair by pair for the latency.
+ */
+int main(int argc, char* argv[]) {
+	size_t count = ((argc > 1) ? size_t(strtoull(argv[1], nullptr, 10)) : 200000U);
+	size_t preset = ((argc > 2) ? size_t(strtoull(argv[2], nullptr, 10)) : 1U);
+	size_t preset_count;
+	const GCSBenchmarkPreset* ps = gcs_benchmark_presets(&preset_count);
+	std::shared_ptr<const GCSContext> gcs;
+	VesselOutline outline = {};
+	std::vector<double> headings(count), oxs(count), oys(count), latencies;
+	std::vector<VesselPose> poses(count * 2);
+	std::vector<size_t> offsets(count + 1);
+	std::string log;
+	double worst_heading = 0.0, worst_origin = 0.0;
+	size_t resolved = 0;
+	int status = 0;
+
+	if (preset >= preset_count) {
+		fprintf(stderr, "usage: %s [pairs] [preset < %u]\n", argv[0], (unsigned int)preset_count);
+		return 1;
+	}
+
+	gcs = gcs_compile(ps[preset].parameter);
+	outline.gps[0] = double2(80.0, -2.0);
+	outline.gps[1] = double2(25.0, 3.0);
+	outline.trunnion = double2(60.0, -10.0);
+
+	for (size_t i = 0; i < sizeof(outline.body_vertices) / sizeof(double2); i++) {
+		outline.body_vertices[i] = double2(double(i) * 20.0, ((i & 1) ? 10.0 : -10.0));
+	}
+
+	{ // synthesize the log
+		double3 center = gauss_krueger_forward(3030.0, ps[preset].parameter.cm * 100.0 + 30.0, 0.0, *gcs);
+		double radius = 800.0;
+
+		log.reserve(count * 2 * 96);
+
+		for (size_t i = 0; i < count; i++) {
+			double utc = 3600.0 + double(i) * 0.1;
+			double phi = double(i) * 0.0005;
+			double theta = -(phi + pi * 0.5); // the tangent of a counterclockwise circle, clockwise from north
+			double c = cos(theta);
+			double s = sin(theta);
+			double2 origin(center.x + radius * cos(phi), center.y - radius * sin(phi));
+
+			headings[i] = fmod(theta * 180.0 / pi + 720.0, 360.0);
+			oxs[i] = origin.x;
+			oys[i] = origin.y;
+			offsets[i] = log.size();
+
+			for (size_t a = 0; a < 2; a++) {
+				double2 g = body_to_plane(outline.gps[a], origin, c, s);
+				double3 blh = gauss_krueger_inverse(g.x, g.y, 12.0 + double(a), *gcs, GCSAccuracy::Exact);
+
+				nmea_gga(log, utc, blh.x, blh.y, blh.z);
+			}
+		}
+
+		offsets[count] = log.size();
+	}
+
+	{ // throughput, 64KiB chunks, as a serial port reader would hand over
+		GPSFixRing ring0(8192), ring1(8192);
+		NMEAStream gps0(&ring0, 0), gps1(&ring1, 1);
+		VesselPoseEngine engine(outline);
+		GPSFix fixes[16];
+		size_t chunk = 65536;
+		size_t sentence = 0;
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t pos = 0; pos < log.size(); pos += chunk) {
+			size_t n = std::min(chunk, log.size() - pos);
+			size_t popped;
+
+			// antennas come from different ports, here they are interleaved in one log, so split them per sentence
+			while ((sentence < count * 2) && (offsets[sentence / 2] < pos + n)) {
+				size_t begin = (sentence % 2 == 0) ? offsets[sentence / 2] : log.find('$', offsets[sentence / 2] + 1);
+				size_t end = (sentence % 2 == 0) ? log.find('$', begin + 1) : offsets[sentence / 2 + 1];
+
+				((sentence % 2 == 0) ? gps0 : gps1).feed(log.data() + begin, end - begin);
+				sentence++;
+			}
+
+			do { // a few from each port at a time, the engine holds the ones whose mates have not been popped yet
+				size_t n0 = ring0.pop(fixes, 8);
+				size_t n1 = ring1.pop(fixes + n0, 8);
+
+				popped = n0 + n1;
+				resolved += engine.feed(fixes, popped, *gcs, poses.data() + resolved);
+			} while (popped > 0);
+		}
+		auto t1 = std::chrono::steady_clock::now();
+
+		printf("%s: %u poses of %u pairs in %.3fs, %.0f poses/s\n", ps[preset].name, (unsigned int)resolved, (unsigned int)count,
+			std::chrono::duration<double>(t1 - t0).count(), double(resolved) / std::chrono::duration<double>(t1 - t0).count());
+	}
+
+	for (size_t i = 0; i < resolved; i++) {
+		size_t j = size_t((poses[i].utc - 3600.0) / 0.1 + 0.5);
+		double dh = fabs(poses[i].heading - headings[j]);
+
+		worst_heading = std::max(worst_heading, std::min(dh, 360.0 - dh));
+		worst_origin = std::max(worst_origin, hypot(poses[i].origin.x - oxs[j], poses[i].origin.y - oys[j]));
+
+		if (!poses[i].okay) {
+			status = 1;
+		}
+	}
+
+	{ // latency, one pair at a time, as they come at the sensor rate
+		GPSFixRing ring(64);
+		NMEAStream gps0(&ring, 0), gps1(&ring, 1);
+		VesselPoseEngine engine(outline);
+		GPSFix fixes[4];
+		VesselPose pose[4];
+
+		latencies.reserve(count);
+
+		for (size_t i = 0; i < count; i++) {
+			size_t mid = log.find('$', offsets[i] + 1);
+			auto t0 = std::chrono::steady_clock::now();
+
+			gps0.feed(log.data() + offsets[i], mid - offsets[i]);
+			gps1.feed(log.data() + mid, offsets[i + 1] - mid);
+			engine.feed(fixes, ring.pop(fixes, 4), *gcs, pose);
+			latencies.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count());
+		}
+
+		std::sort(latencies.begin(), latencies.end());
+		printf("latency from sentences to pose: p50 %.0fns, p99 %.0fns, p999 %.0fns\n",
+			latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies[latencies.size() * 999 / 1000]);
+	}
+
+	printf("worst heading error: %.6f degrees, worst origin error: %.3fmm\n", worst_heading, worst_origin * 1000.0);
+
+	if ((resolved != count) || (worst_heading > 0.001) || (worst_origin > 0.001)) {
+		status = 1;
+	}
+
+	return status;
+}
+#endif
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+
+#include "device/gps/nmea.hpp"
+
+namespace WarGrey::DTPM {
+	/**
+	 * The vessel in its own frame, the same as what the vessel editor holds,
+	 *   `x` points to the bow and `y` points to the starboard, so that it coincides with the Gauss-Krüger plane when heading north.
+	 */
+	struct VesselOutline {
+		WarGrey::SCADA::double2 gps[2];
+		WarGrey::SCADA::double2 ps_suction;
+		WarGrey::SCADA::double2 sb_suction;
+		WarGrey::SCADA::double2 trunnion;
+		WarGrey::SCADA::double2 barge;
+		WarGrey::SCADA::double2 body_vertices[7];
+		WarGrey::SCADA::double2 hopper_vertices[4];
+		WarGrey::SCADA::double2 bridge_vertices[10];
+	};
+
+	/**
+	 * Works for whatever holds fields of the same names, say, `TrailingSuctionDredger^`.
+	 */
+	template<typename V>
+	void vessel_outline_fill(WarGrey::DTPM::VesselOutline* outline, V vessel) {
+		outline->gps[0] = vessel->gps[0];
+		outline->gps[1] = vessel->gps[1];
+		outline->ps_suction = vessel->ps_suction;
+		outline->sb_suction = vessel->sb_suction;
+		outline->trunnion = vessel->trunnion;
+		outline->barge = vessel->barge;
+
+		for (size_t idx = 0; idx < sizeof(outline->body_vertices) / sizeof(WarGrey::SCADA::double2); idx++) {
+			outline->body_vertices[idx] = vessel->body_vertices[idx];
+		}
+
+		for (size_t idx = 0; idx < sizeof(outline->hopper_vertices) / sizeof(WarGrey::SCADA::double2); idx++) {
+			outline->hopper_vertices[idx] = vessel->hopper_vertices[idx];
+		}
+
+		for (size_t idx = 0; idx < sizeof(outline->bridge_vertices) / sizeof(WarGrey::SCADA::double2); idx++) {
+			outline->bridge_vertices[idx] = vessel->bridge_vertices[idx];
+		}
+	}
+
+	/**
+	 * The outline placed on the Gauss-Krüger plane,
+	 *   `heading` is in degrees, clockwise from the grid north, `origin` is where the vessel frame is rooted.
+	 * `okay` is false if either fix has no position or the measured baseline differs from the configured one by more than the tolerance.
+	 */
+	struct VesselPose {
+		double utc;
+		double heading;
+		double baseline;       // meters, measured
+		double altitude;       // of the antennas, averaged
+		WarGrey::SCADA::double2 origin;
+		WarGrey::SCADA::double3 gps[2];
+		WarGrey::DTPM::VesselOutline outline;
+		bool okay;
+	};
+
+	/**
+	 * Pairs fixes of antenna 0 and antenna 1 whose times are within `pair_window` seconds,
+	 *   fixes of both antennas could come in any interleaving (e.g. popped from two rings one after the other),
+	 *   unpaired ones wait in small per-antenna queues, and are dropped once a later fix of the mate has been seen.
+	 *   converts the pairs in one batch, and derives the heading from the baseline and the position from both antennas.
+	 *
+	 * Buffers are preallocated once, feeding fixes does not touch the heap.
+	 */
+	class VesselPoseEngine {
+	public:
+		virtual ~VesselPoseEngine() noexcept;
+		VesselPoseEngine(const WarGrey::DTPM::VesselOutline& outline, size_t capacity = 256,
+			double baseline_tolerance = 0.2, double pair_window = 0.05);
+
+	public:
+		void reshape(const WarGrey::DTPM::VesselOutline& outline);
+
+		/**
+		 * Fixes of other antennas are ignored, unpaired fixes are held until their mates come,
+		 *   `poses` should have room for `count` poses, returns the number of poses resolved.
+		 */
+		size_t feed(const WarGrey::DTPM::GPSFix* fixes, size_t count, const WarGrey::DTPM::GCSContext& gcs, WarGrey::DTPM::VesselPose* poses);
+		bool resolve(const WarGrey::DTPM::GPSFix& gps1, const WarGrey::DTPM::GPSFix& gps2, const WarGrey::DTPM::GCSContext& gcs, WarGrey::DTPM::VesselPose* pose);
+
+	private:
+		size_t flush(const WarGrey::DTPM::GCSContext& gcs, WarGrey::DTPM::VesselPose* poses);
+		void locate(WarGrey::DTPM::VesselPose* pose);
+
+	private:
+		WarGrey::DTPM::VesselOutline outline;
+		double configured_baseline;
+		double configured_bearing;
+		double baseline_tolerance;
+		double pair_window;
+
+	private:
+		bool pair(const WarGrey::DTPM::GPSFix& fix, const WarGrey::DTPM::GCSContext& gcs, WarGrey::DTPM::VesselPose* poses, size_t* resolved);
+
+	private: // per-antenna queues of unpaired fixes, ordered by time
+		WarGrey::DTPM::GPSFix pending[2][16];
+		size_t pending_head[2];
+		size_t pending_count[2];
+
+	private: // pairs being staged, antenna 0 at even indices and antenna 1 at odd ones
+		WarGrey::DTPM::GPSFix* pairs;
+		double* Bs;
+		double* Ls;
+		double* Hs;
+		double* xs;
+		double* ys;
+		double* zs;
+		size_t staged;
+		size_t capacity;
+	};
+}
@@ -0,0 +1,300 @@
+#include <cmath>
+
+#include "device/vessel/vessel_vertices.hpp"
+
+#if defined(__AVX2__) || defined(__AVX__)
+#include <immintrin.h>
+#define VV_SIMD_AVX
+#elif defined(_M_ARM64)
+#include <arm64_neon.h>
+#define VV_SIMD_NEON
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define VV_SIMD_NEON
+#endif
+
+using namespace WarGrey::SCADA;
+using namespace WarGrey::DTPM;
+
+static const double pi = 3.14159265358979323846;
+static const size_t vertex_count = static_cast<size_t>(VesselVertex::_);
+
+/*************************************************************************************************/
+namespace {
+	// `count` is a multiple of the SIMD width
+	static void rigid_transform(const double* bxs, const double* bys, double* xs, double* ys, size_t count,
+		double ox, double oy, double c, double s) {
+		size_t i = 0;
+
+#if defined(VV_SIMD_AVX)
+		__m256d vox = _mm256_set1_pd(ox);
+		__m256d voy = _mm256_set1_pd(oy);
+		__m256d vc = _mm256_set1_pd(c);
+		__m256d vs = _mm256_set1_pd(s);
+
+		for (; i + 4 <= count; i += 4) {
+			__m256d bx = _mm256_load_pd(bxs + i);
+			__m256d by = _mm256_load_pd(bys + i);
+
+			_mm256_store_pd(xs + i, _mm256_add_pd(vox, _mm256_sub_pd(_mm256_mul_pd(bx, vc), _mm256_mul_pd(by, vs))));
+			_mm256_store_pd(ys + i, _mm256_add_pd(voy, _mm256_add_pd(_mm256_mul_pd(bx, vs), _mm256_mul_pd(by, vc))));
+		}
+#elif defined(VV_SIMD_NEON)
+		float64x2_t vox = vdupq_n_f64(ox);
+		float64x2_t voy = vdupq_n_f64(oy);
+		float64x2_t vc = vdupq_n_f64(c);
+		float64x2_t vs = vdupq_n_f64(s);
+
+		for (; i + 2 <= count; i += 2) {
+			float64x2_t bx = vld1q_f64(bxs + i);
+			float64x2_t by = vld1q_f64(bys + i);
+
+			vst1q_f64(xs + i, vaddq_f64(vox, vsubq_f64(vmulq_f64(bx, vc), vmulq_f64(by, vs))));
+			vst1q_f64(ys + i, vaddq_f64(voy, vaddq_f64(vmulq_f64(bx, vs), vmulq_f64(by, vc))));
+		}
+#else
+		for (; i < count; i++) {
+			xs[i] = ox + (bxs[i] * c - bys[i] * s);
+			ys[i] = oy + (bxs[i] * s + bys[i] * c);
+		}
+#endif
+	}
+}
+
+/*************************************************************************************************/
+VesselVertices::VesselVertices(const VesselOutline& outline, double position_threshold, double heading_threshold)
+	: transformed(0), reused(0), heading(0.0), position_threshold(position_threshold), heading_threshold(heading_threshold), okay(false) {
+	this->reshape(outline);
+}
+
+void VesselVertices::reshape(const VesselOutline& outline) {
+	const double2* body = outline.body_vertices;
+	const double2* hopper = outline.hopper_vertices;
+	const double2* bridge = outline.bridge_vertices;
+	double2 vertices[] = {
+		outline.gps[0], outline.gps[1], outline.ps_suction, outline.sb_suction,
+		body[0], body[1], body[2], body[3], body[4], body[5], body[6],
+		hopper[0], hopper[1], hopper[2], hopper[3],
+		bridge[0], bridge[1], bridge[2], bridge[3], bridge[4], bridge[5], bridge[6], bridge[7], bridge[8], bridge[9],
+		outline.trunnion, outline.barge
+	};
+
+	static_assert(sizeof(vertices) / sizeof(double2) == vertex_count, "the outline does not match `VesselVertex`");
+
+	for (size_t i = 0; i < capacity; i++) {
+		this->body_xs[i] = ((i < vertex_count) ? vertices[i].x : 0.0);
+		this->body_ys[i] = ((i < vertex_count) ? vertices[i].y : 0.0);
+	}
+
+	this->invalidate();
+}
+
+void VesselVertices::invalidate() {
+	this->okay = false;
+}
+
+bool VesselVertices::transform(const double2& origin, double heading) {
+	bool moved = !this->okay;
+
+	if (!moved) {
+		double dh = fabs(fmod(heading - this->heading, 360.0));
+
+		moved = (fabs(origin.x - this->origin.x) > this->position_threshold)
+			|| (fabs(origin.y - this->origin.y) > this->position_threshold)
+			|| (fmin(dh, 360.0 - dh) > this->heading_threshold);
+	}
+
+	if (moved) {
+		double theta = heading * pi / 180.0;
+
+		rigid_transform(this->body_xs, this->body_ys, this->plane_xs, this->plane_ys, capacity, origin.x, origin.y, cos(theta), sin(theta));
+
+		this->origin = origin;
+		this->heading = heading;
+		this->okay = true;
+		this->transformed++;
+	} else {
+		this->reused++;
+	}
+
+	return moved;
+}
+
+bool VesselVertices::transform(const VesselPose& pose) {
+	return this->transform(pose.origin, pose.heading);
+}
+
+/*************************************************************************************************/
+double2 VesselVertices::vertex(VesselVertex id) {
+	size_t idx = static_cast<size_t>(id);
+
+	return double2(this->plane_xs[idx], this->plane_ys[idx]);
+}
+
+void VesselVertices::unpack(VesselOutline* outline) {
+	const double* xs = this->plane_xs;
+	const double* ys = this->plane_ys;
+	size_t body0 = static_cast<size_t>(VesselVertex::Body1);
+	size_t hopper0 = static_cast<size_t>(VesselVertex::Hopper1);
+	size_t bridge0 = static_cast<size_t>(VesselVertex::Bridge1);
+
+	outline->gps[0] = this->vertex(VesselVertex::GPS1);
+	outline->gps[1] = this->vertex(VesselVertex::GPS2);
+	outline->ps_suction = this->vertex(VesselVertex::PS_Suction);
+	outline->sb_suction = this->vertex(VesselVertex::SB_Suction);
+	outline->trunnion = this->vertex(VesselVertex::Trunnion);
+	outline->barge = this->vertex(VesselVertex::Barge);
+
+	for (size_t i = 0; i < sizeof(outline->body_vertices) / sizeof(double2); i++) {
+		outline->body_vertices[i] = double2(xs[body0 + i], ys[body0 + i]);
+	}
+
+	for (size_t i = 0; i < sizeof(outline->hopper_vertices) / sizeof(double2); i++) {
+		outline->hopper_vertices[i] = double2(xs[hopper0 + i], ys[hopper0 + i]);
+	}
+
+	for (size_t i = 0; i < sizeof(outline->bridge_vertices) / sizeof(double2); i++) {
+		outline->bridge_vertices[i] = double2(xs[bridge0 + i], ys[bridge0 + i]);
+	}
+}
+
+const double* VesselVertices::xs() {
+	return this->plane_xs;
+}
+
+const double* VesselVertices::ys() {
+	return this->plane_ys;
+}
+
+size_t VesselVertices::count() {
+	return vertex_count;
+}
+
+/*************************************************************************************************/
+#ifdef VESSEL_VERTICES_MAIN
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * A fleet replays their tracks, most of them are anchored or slow-sailing, a few are sailing.
+ */
+int main(int argc, char* argv[]) {
+	size_t fleet = ((argc > 1) ? size_t(strtoull(argv[1], nullptr, 10)) : 24U);
+	size_t steps = ((argc > 2) ? size_t(strtoull(argv[2], nullptr, 10)) : 20000U);
+	std::mt19937_64 prng(0);
+	std::normal_distribution<double> jitter(0.0, 0.0003);
+	std::vector<VesselVertices> vessels;
+	std::vector<double2> origins(fleet);
+	std::vector<double> headings(fleet);
+	std::vector<double> dxs(fleet * steps), dys(fleet * steps), dhs(fleet * steps);
+	VesselOutline outline = {};
+	VesselOutline plane;
+	volatile double sink = 0.0;
+	double seconds[3];
+
+	for (size_t i = 0; i < sizeof(outline.body_vertices) / sizeof(double2); i++) {
+		outline.body_vertices[i] = double2(double(i) * 20.0, ((i & 1) ? 10.0 : -10.0));
+	}
+
+	for (size_t i = 0; i < sizeof(outline.bridge_vertices) / sizeof(double2); i++) {
+		outline.bridge_vertices[i] = double2(100.0 + double(i), ((i & 1) ? 6.0 : -6.0));
+	}
+
+	outline.gps[0] = double2(80.0, -2.0);
+	outline.gps[1] = double2(25.0, 3.0);
+
+	for (size_t v = 0; v < fleet; v++) {
+		vessels.push_back(VesselVertices(outline));
+	}
+
+	for (size_t step = 0; step < steps; step++) { // the tracks are generated beforehand, the pseudo random generator is not cheap
+		for (size_t v = 0; v < fleet; v++) {
+			bool sailing = (v % 8 == 0);
+
+			dxs[step * fleet + v] = (sailing ? 0.5 : jitter(prng));
+			dys[step * fleet + v] = (sailing ? 0.2 : jitter(prng));
+			dhs[step * fleet + v] = (sailing ? 0.01 : jitter(prng));
+		}
+	}
+
+	for (size_t pass = 0; pass < 3; pass++) {
+		auto t0 = std::chrono::steady_clock::now();
+
+		for (size_t v = 0; v < fleet; v++) {
+			origins[v] = double2(3375000.0 + 500.0 * double(v), 596000.0);
+			headings[v] = double(v) * 15.0;
+			vessels[v].invalidate();
+			vessels[v].transformed = 0;
+			vessels[v].reused = 0;
+		}
+
+		for (size_t step = 0; step < steps; step++) {
+			for (size_t v = 0; v < fleet; v++) {
+				origins[v].x += dxs[step * fleet + v];
+				origins[v].y += dys[step * fleet + v];
+				headings[v] += dhs[step * fleet + v];
+
+				switch (pass) {
+				case 0: { // what the renderer does now, rotates every vertex of the outline on every update
+					double theta = headings[v] * pi / 180.0;
+					double c = cos(theta), s = sin(theta);
+
+					for (size_t i = 0; i < sizeof(outline.body_vertices) / sizeof(double2); i++) {
+						plane.body_vertices[i].x = origins[v].x + (outline.body_vertices[i].x * c - outline.body_vertices[i].y * s);
+						plane.body_vertices[i].y = origins[v].y + (outline.body_vertices[i].x * s + outline.body_vertices[i].y * c);
+					}
+
+					for (size_t i = 0; i < sizeof(outline.hopper_vertices) / sizeof(double2); i++) {
+						plane.hopper_vertices[i].x = origins[v].x + (outline.hopper_vertices[i].x * c - outline.hopper_vertices[i].y * s);
+						plane.hopper_vertices[i].y = origins[v].y + (outline.hopper_vertices[i].x * s + outline.hopper_vertices[i].y * c);
+					}
+
+					for (size_t i = 0; i < sizeof(outline.bridge_vertices) / sizeof(double2); i++) {
+						plane.bridge_vertices[i].x = origins[v].x + (outline.bridge_vertices[i].x * c - outline.bridge_vertices[i].y * s);
+						plane.bridge_vertices[i].y = origins[v].y + (outline.bridge_vertices[i].x * s + outline.bridge_vertices[i].y * c);
+					}
+
+					sink = sink + plane.body_vertices[0].x + plane.bridge_vertices[9].y;
+				}; break;
+				case 1: vessels[v].invalidate(); vessels[v].transform(origins[v], headings[v]); sink = sink + vessels[v].xs()[0]; break;
+				default: vessels[v].transform(origins[v], headings[v]); sink = sink + vessels[v].xs()[0]; break;
+				}
+			}
+		}
+
+		seconds[pass] = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	}
+
+	{ // the reused outlines are never further than the thresholds from the exact ones
+		uint64_t transformed = 0, reused = 0;
+		double worst = 0.0;
+
+		for (size_t v = 0; v < fleet; v++) {
+			VesselVertices exact(outline, 0.0, 0.0);
+
+			exact.transform(origins[v], headings[v]);
+
+			for (size_t i = 0; i < vessels[v].count(); i++) {
+				double2 p = vessels[v].vertex(VesselVertex(i));
+				double2 e = exact.vertex(VesselVertex(i));
+
+				worst = fmax(worst, hypot(p.x - e.x, p.y - e.y));
+			}
+
+			transformed += vessels[v].transformed;
+			reused += vessels[v].reused;
+		}
+
+		printf("%u vessels x %u updates\n", (unsigned int)fleet, (unsigned int)steps);
+		printf("%-24s %14.0f updates/s\n", "scalar outline", double(fleet * steps) / seconds[0]);
+		printf("%-24s %14.0f updates/s\n", "packed", double(fleet * steps) / seconds[1]);
+		printf("%-24s %14.0f updates/s, %.1f%% reused, worst drift %.3fmm\n", "packed + threshold", double(fleet * steps) / seconds[2],
+			double(reused) * 100.0 / double(transformed + reused), worst * 1000.0);
+	}
+
+	return 0;
+}
+#endif
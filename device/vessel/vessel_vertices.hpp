@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#include "device/vessel/vessel_pose.hpp"
+
+namespace WarGrey::DTPM {
+	// order matters, the same as the vessel editor
+	enum class VesselVertex {
+		GPS1, GPS2, PS_Suction, SB_Suction,
+		Body1, Body2, Body3, Body4, Body5, Body6, Body7,
+		Hopper1, Hopper2, Hopper3, Hopper4,
+		Bridge1, Bridge2, Bridge3, Bridge4, Bridge5, Bridge6, Bridge7, Bridge8, Bridge9, Bridge10,
+		Trunnion, Barge,
+
+		_
+	};
+
+	/**
+	 * The vessel outline packed into structure-of-arrays, padded to the SIMD width,
+	 *   transformed onto the plane by a vectorized rigid transformation.
+	 *
+	 * The transformed vertices are kept as they are if neither the origin moves more than `position_threshold` (meter)
+	 *   nor the heading turns more than `heading_threshold` (degree) since they were transformed,
+	 *   so that renderers of a fleet (or a replaying track) can skip most of updates,
+	 *   the reused vertices are off by at most `sqrt(2) * position_threshold + r * heading_threshold` where `r` is the distance of the farthest vertex (heading in radians).
+	 */
+	class VesselVertices {
+	public:
+		VesselVertices(const WarGrey::DTPM::VesselOutline& outline, double position_threshold = 0.001, double heading_threshold = 0.001);
+
+	public:
+		void reshape(const WarGrey::DTPM::VesselOutline& outline);
+
+		/**
+		 * returns `true` if the vertices are transformed, or `false` if the previous ones are reused.
+		 */
+		bool transform(const WarGrey::SCADA::double2& origin, double heading);
+		bool transform(const WarGrey::DTPM::VesselPose& pose);
+		void invalidate();
+
+	public:
+		WarGrey::SCADA::double2 vertex(WarGrey::DTPM::VesselVertex id);
+		void unpack(WarGrey::DTPM::VesselOutline* outline);
+		const double* xs();
+		const double* ys();
+		size_t count();
+
+	public:
+		uint64_t transformed;
+		uint64_t reused;
+
+	private:
+		static const size_t capacity = 28; // `VesselVertex::_` rounded up to the SIMD width
+
+	private:
+		alignas(32) double body_xs[capacity];
+		alignas(32) double body_ys[capacity];
+		alignas(32) double plane_xs[capacity];
+		alignas(32) double plane_ys[capacity];
+
+	private:
+		WarGrey::SCADA::double2 origin;
+		double heading;
+		double position_threshold;
+		double heading_threshold;
+		bool okay;
+	};
+}
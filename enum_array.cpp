@@ -0,0 +1,127 @@
+#include "enum_array.hpp"
+
+/*************************************************************************************************/
+#ifdef ENUM_ARRAY_MAIN
+#include <map>
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace WarGrey::DTPM;
+
+namespace {
+	// the same shape as the vessel editor
+	enum class TSD {
+		GPS1, GPS2, PS_Suction, SB_Suction,
+		Body1, Body2, Body3, Body4, Body5, Body6, Body7,
+		Hopper1, Hopper2, Hopper3, Hopper4,
+		Bridge1, Bridge2, Bridge3, Bridge4, Bridge5, Bridge6, Bridge7, Bridge8, Bridge9, Bridge10,
+		Trunnion, Barge,
+
+		_,
+
+		x, y, origin,
+		__
+	};
+
+	// stands for graphlets, only the location matters
+	struct Widget {
+		float x;
+		float y;
+		float width;
+		float height;
+	};
+
+	inline void move_to(Widget* g, Widget* target, float dx, float dy) {
+		g->x = target->x + target->width + dx;
+		g->y = target->y + (target->height - g->height) * 0.5F + dy;
+	}
+
+	/**
+	 * What `reflow_input_fields` and `refresh` do: looking up fields by ids in order, and walking all decorates.
+	 */
+	template<typename Labels, typename Fields, typename Decorates>
+	float editor_round(Labels& labels, Fields& xs, Fields& ys, Decorates& decorates, float yoff) {
+		float sum = 0.0F;
+
+		for (int i = 0; i < static_cast<int>(TSD::_); i++) {
+			TSD id = static_cast<TSD>(i);
+			float yrow = 24.0F * float(i) + yoff;
+
+			xs[id]->y = yrow;
+			move_to(labels[id], xs[id], -4.0F, 0.0F);
+			move_to(ys[id], xs[id], 8.0F, 0.0F);
+		}
+
+		for (auto it = decorates.begin(); it != decorates.end(); it++) {
+			move_to(it->second, xs[TSD::GPS1], float(static_cast<int>(it->first)), 0.0F);
+			sum += it->second->x + it->second->y;
+		}
+
+		for (auto it = labels.begin(); it != labels.end(); it++) {
+			sum += it->second->y;
+		}
+
+		return sum;
+	}
+
+	template<typename Labels, typename Fields, typename Decorates>
+	void editor_load(std::vector<Widget>& pool, Labels& labels, Fields& xs, Fields& ys, Decorates& decorates) {
+		size_t slot = 0;
+
+		for (int i = 0; i < static_cast<int>(TSD::_); i++) {
+			TSD id = static_cast<TSD>(i);
+
+			labels[id] = &pool[slot++];
+			xs[id] = &pool[slot++];
+			ys[id] = &pool[slot++];
+		}
+
+		for (TSD id : { TSD::x, TSD::y, TSD::PS_Suction, TSD::SB_Suction, TSD::GPS1, TSD::GPS2, TSD::Barge }) {
+			decorates[id] = &pool[slot++];
+		}
+	}
+}
+
+/**
+ * Reflows and refreshes the vessel editor `rounds` times with widgets kept in `std::map` and in `EnumArray`,
+ *   widgets live in the same pool for both, so that the difference is only of the containers.
+ */
+int main(int argc, char* argv[]) {
+	size_t rounds = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 1000000U);
+	std::vector<Widget> pool(static_cast<size_t>(TSD::__) * 4U, Widget{ 0.0F, 0.0F, 64.0F, 16.0F });
+	std::map<TSD, Widget*> mlabels, mxs, mys, mdecorates;
+	EnumArray<TSD, Widget*> alabels, axs, ays;
+	EnumArray<TSD, Widget*, TSD::__> adecorates;
+	double seconds[2];
+	float checksums[2] = { 0.0F, 0.0F };
+
+	editor_load(pool, mlabels, mxs, mys, mdecorates);
+	editor_load(pool, alabels, axs, ays, adecorates);
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < rounds; r++) {
+		checksums[0] += editor_round(mlabels, mxs, mys, mdecorates, float(r & 0xFFU));
+	}
+	auto t1 = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < rounds; r++) {
+		checksums[1] += editor_round(alabels, axs, ays, adecorates, float(r & 0xFFU));
+	}
+	auto t2 = std::chrono::steady_clock::now();
+
+	seconds[0] = std::chrono::duration<double>(t1 - t0).count();
+	seconds[1] = std::chrono::duration<double>(t2 - t1).count();
+
+	if (checksums[0] != checksums[1]) {
+		fprintf(stderr, "the map and the array disagree\n");
+		return 1;
+	}
+
+	printf("%zu rounds of reflow and refresh\n", rounds);
+	printf("  std::map:  %8.3f s, %8.1f ns/round\n", seconds[0], seconds[0] * 1e9 / double(rounds));
+	printf("  EnumArray: %8.3f s, %8.1f ns/round (%.2fx)\n", seconds[1], seconds[1] * 1e9 / double(rounds), seconds[0] / seconds[1]);
+
+	return 0;
+}
+#endif
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace WarGrey::DTPM {
+	/**
+	 * A flat replacement of `std::map<E, T>` for editors whose keys are dense enums,
+	 *   slots are indexed by the underlying values of `E` and sized from the sentinel `N` (`E::_` by default,
+	 *   pass `E::__` if ids after `_` are also stored, say, the test fields of the GPS editor).
+	 *
+	 * Like the map, `operator[]` makes the slot present, and the iteration only visits present slots,
+	 *   in the order of the enum, each entry has `first` (the id) and `second` (the value) as `std::map` does,
+	 *   so that loops written for the map work as they are.
+	 */
+	template<typename E, typename T, E N = E::_>
+	class EnumArray {
+	public:
+		typedef std::pair<E, T> value_type;
+
+		template<typename A, typename V>
+		class basic_iterator {
+		public:
+			basic_iterator(A* self, size_t idx) : self(self), idx(idx) { this->skip(); }
+
+		public:
+			V& operator*() const { return this->self->entries[this->idx]; }
+			V* operator->() const { return &this->self->entries[this->idx]; }
+			bool operator==(const basic_iterator& it) const { return this->idx == it.idx; }
+			bool operator!=(const basic_iterator& it) const { return this->idx != it.idx; }
+			basic_iterator& operator++() { this->idx++; this->skip(); return (*this); }
+			basic_iterator operator++(int) { basic_iterator it = (*this); ++(*this); return it; }
+
+		private:
+			void skip() {
+				while ((this->idx < A::capacity) && (!this->self->present[this->idx])) {
+					this->idx++;
+				}
+			}
+
+		private:
+			A* self;
+			size_t idx;
+		};
+
+		typedef basic_iterator<EnumArray, value_type> iterator;
+		typedef basic_iterator<const EnumArray, const value_type> const_iterator;
+
+	public:
+		static const size_t capacity = static_cast<size_t>(N);
+
+	public:
+		EnumArray() : entries(), present(), count(0) {
+			for (size_t idx = 0; idx < capacity; idx++) {
+				this->entries[idx].first = static_cast<E>(idx);
+			}
+		}
+
+	public:
+		T& operator[](E id) {
+			size_t idx = static_cast<size_t>(id);
+
+			if (!this->present[idx]) {
+				this->present[idx] = true;
+				this->count++;
+			}
+
+			return this->entries[idx].second;
+		}
+
+		bool contains(E id) const {
+			return this->present[static_cast<size_t>(id)];
+		}
+
+		size_t size() const {
+			return this->count;
+		}
+
+		bool empty() const {
+			return (this->count == 0);
+		}
+
+		void clear() {
+			for (size_t idx = 0; idx < capacity; idx++) {
+				this->entries[idx].second = T();
+				this->present[idx] = false;
+			}
+
+			this->count = 0;
+		}
+
+	public:
+		iterator begin() { return iterator(this, 0); }
+		iterator end() { return iterator(this, capacity); }
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, capacity); }
+
+	private:
+		value_type entries[capacity];
+		bool present[capacity];
+		size_t count;
+	};
+}
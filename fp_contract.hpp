@@ -0,0 +1,17 @@
+#pragma once
+
+/**
+ * Include it before any other header of a translation unit whose results must be bit-identical between the SIMD kernel and the scalar one,
+ *   the compiler would otherwise contract `a * b + c` into FMAs independently in either of them,
+ *   GCC does so by default whenever the target has FMA (e.g. `-march=haswell`).
+ *
+ * The GCC pragma only applies to functions defined after it, including the inline ones of the headers,
+ *   builds that cannot rely on it should pass `-ffp-contract=off` as well.
+ */
+#if defined(_MSC_VER)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
@@ -0,0 +1,118 @@
+#include <cstdio>
+
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace WarGrey::DTPM;
+
+/*************************************************************************************************/
+#ifdef _WIN32
+namespace {
+	std::wstring path_to_wide(const std::string& path) {
+		int size = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+		std::wstring wpath(((size > 0) ? size : 1), L'\0');
+
+		MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wpath[0], size);
+
+		return wpath;
+	}
+}
+
+void* WarGrey::DTPM::mapped_file_open(const std::string& path, size_t* extent) {
+	HANDLE file = CreateFile2(path_to_wide(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, OPEN_EXISTING, nullptr);
+	void* view = nullptr;
+
+	if (file != INVALID_HANDLE_VALUE) {
+		LARGE_INTEGER size;
+
+		if (GetFileSizeEx(file, &size) && (size.QuadPart > 0)) {
+			HANDLE mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+
+			if (mapping != nullptr) {
+				view = MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+				(*extent) = size_t(size.QuadPart);
+				CloseHandle(mapping);
+			}
+		}
+
+		CloseHandle(file);
+	}
+
+	return view;
+}
+
+void WarGrey::DTPM::mapped_file_close(void* view, size_t extent) {
+	(void)extent;
+
+	UnmapViewOfFile(view);
+}
+
+bool WarGrey::DTPM::mapped_file_replace(const std::string& temp, const std::string& path) {
+	return (MoveFileExW(path_to_wide(temp).c_str(), path_to_wide(path).c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE);
+}
+
+bool WarGrey::DTPM::mapped_file_sync_directory(const std::string& dir) {
+	(void)dir;
+
+	return true;
+}
+#else
+void* WarGrey::DTPM::mapped_file_open(const std::string& path, size_t* extent) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	void* view = nullptr;
+
+	if (fd >= 0) {
+		struct stat s;
+
+		if ((fstat(fd, &s) == 0) && (s.st_size > 0)) {
+			view = mmap(nullptr, size_t(s.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if (view == MAP_FAILED) {
+				view = nullptr;
+			} else {
+				(*extent) = size_t(s.st_size);
+			}
+		}
+
+		::close(fd);
+	}
+
+	return view;
+}
+
+void WarGrey::DTPM::mapped_file_close(void* view, size_t extent) {
+	munmap(view, extent);
+}
+
+bool WarGrey::DTPM::mapped_file_replace(const std::string& temp, const std::string& path) {
+	bool okay = (rename(temp.c_str(), path.c_str()) == 0);
+
+	if (okay) {
+		size_t slash = path.find_last_of('/');
+
+		okay = mapped_file_sync_directory((slash == std::string::npos) ? std::string(".") : path.substr(0, ((slash == 0) ? 1 : slash)));
+	}
+
+	return okay;
+}
+
+bool WarGrey::DTPM::mapped_file_sync_directory(const std::string& dir) {
+	int fd = ::open(dir.c_str(), O_RDONLY);
+	bool okay = (fd >= 0);
+
+	if (okay) {
+		okay = (fsync(fd) == 0);
+		::close(fd);
+	}
+
+	return okay;
+}
+#endif
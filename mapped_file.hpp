@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace WarGrey::DTPM {
+	/**
+	 * Maps the whole file read-only, returns `nullptr` if the file does not exist or is empty,
+	 *   the view stays valid after the file is closed, until it is passed to `mapped_file_close()` with the same `extent`.
+	 */
+	void* mapped_file_open(const std::string& path, size_t* extent);
+	void mapped_file_close(void* view, size_t extent);
+
+	/**
+	 * Replaces `path` with the already synced `temp` in one step, the target is never missing in between;
+	 *   on POSIX, the directory is synced as well, so that the new name survives a power loss.
+	 *
+	 * On Win32, it fails while any view of `path` is still mapped, by this process or another, close them first;
+	 *   on POSIX, it succeeds, and existing views keep the old content until they are closed.
+	 */
+	bool mapped_file_replace(const std::string& temp, const std::string& path);
+
+	/**
+	 * Makes creating, removing and renaming files in `dir` durable, POSIX requires syncing the directory itself;
+	 *   NTFS journals its metadata, and there is no such call on Win32, it is a no-op there.
+	 */
+	bool mapped_file_sync_directory(const std::string& dir);
+}
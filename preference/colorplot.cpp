@@ -1,5 +1,3 @@
-#include <map>
-
 #include "preference/colorplot.hpp"
 
 #include "graphlet/filesystem/configuration/colorplotlet.hpp"
@@ -9,6 +7,7 @@
 #include "graphlet/planetlet.hpp"
 
 #include "module.hpp"
+#include "enum_array.hpp"
 
 using namespace WarGrey::SCADA;
 using namespace WarGrey::DTPM;
@@ -225,8 +224,8 @@ private:
 
 private: // never delete these graphlet manually
 	ColorPlotlet* plot;
-	std::map<CP, Labellet*> labels;
-	std::map<CP, Credit<Dimensionlet, CP>*> ranges;
+	EnumArray<CP, Labellet*> labels;
+	EnumArray<CP, Credit<Dimensionlet, CP>*> ranges;
 	Credit<Dimensionlet, int>* depths[ColorPlotSize];
 	Credit<ColorPickerlet, int>* pickers[ColorPlotSize];
 	
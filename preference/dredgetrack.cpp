@@ -1,5 +1,3 @@
-#include <map>
-
 #include "preference/dredgetrack.hpp"
 
 #include "graphlet/filesystem/project/dredgetracklet.hpp"
@@ -12,6 +10,7 @@
 #include "datum/time.hpp"
 
 #include "module.hpp"
+#include "enum_array.hpp"
 
 using namespace WarGrey::SCADA;
 using namespace WarGrey::DTPM;
@@ -42,7 +41,9 @@ namespace {
 		_,
 
 		// misc
-		BeginTime, EndTime, History
+		BeginTime, EndTime, History,
+
+		__
 	};
 }
 
@@ -320,10 +321,10 @@ private:
 
 private: // never delete these graphlet manually
 	DredgeTracklet* track;
-	std::map<DT, Labellet*> labels;
-	std::map<DT, Credit<Dimensionlet, DT>*> metrics;
-	std::map<DT, Credit<DatePickerlet, DT>*> dates;
-	std::map<DredgeTrackType, Credit<Togglet, DredgeTrackType>*> toggles;
+	EnumArray<DT, Labellet*> labels;
+	EnumArray<DT, Credit<Dimensionlet, DT>*> metrics;
+	EnumArray<DT, Credit<DatePickerlet, DT>*, DT::__> dates;
+	EnumArray<DredgeTrackType, Credit<Togglet, DredgeTrackType>*> toggles;
 	Togglet* history_toggle;
 	
 private:
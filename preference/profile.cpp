@@ -1,5 +1,3 @@
-#include <map>
-
 #include "preference/profile.hpp"
 
 #include "graphlet/filesystem/project/profilet.hpp"
@@ -9,6 +7,8 @@
 #include "datum/flonum.hpp"
 
 #include "module.hpp"
+#include "enum_array.hpp"
+#include "sketch_script.hpp"
 
 using namespace WarGrey::SCADA;
 using namespace WarGrey::DTPM;
@@ -45,6 +45,31 @@ namespace {
 		lb, rt, tide
 	};
 
+	// sketches are in steps, x to the right and y to the bottom, evaluated at compile time
+	static constexpr SketchScript<TS, 16> designed_sketch = []() {
+		SketchScript<TS, 16> s(TS::lb);
+
+		s.move(+1.0F, +0.0F).jump(-0.5F, +0.0F, TS::MaxDepth).move(+0.0F, -4.0F, TS::MinDepth).jump(-0.5F, +0.0F).move(+1.0F, +0.0F, TS::rt);
+		s.jump(+3.0F, +0.0F).move(-1.0F, +2.0F).move(-1.5F, +0.0F).move(+0.0F, +2.0F).move(-2.0F, +0.0F).move(-2.5F, -4.0F);
+		s.jump(-0.5F, -2.0F, TS::tide).move(+8.0F, +0.0F, TS::Width).jump(+0.0F, +8.0F).move(-8.0F, +0.0F);
+
+		return s;
+	}();
+
+	static constexpr SketchScript<TS, 4> original_sketch = []() {
+		SketchScript<TS, 4> s;
+
+		s.drift(8.0F, 0.0F, 3.0F, 0.5F, 6.0F, -0.5F);
+		s.jump(+0.0F, +5.0F).move(-8.0F, +0.0F);
+
+		return s;
+	}();
+
+	static_assert(designed_sketch.okay() && original_sketch.okay(), "sketch overflow");
+	static_assert(designed_sketch.x(TS::MaxDepth) == designed_sketch.x(TS::MinDepth), "the depth arrow should be vertical");
+	static_assert(designed_sketch.x(TS::tide) + designed_sketch.x(TS::Width) == designed_sketch.x(TS::MaxDepth) * 2.0F,
+		"the water line should be centered at the depth arrow");
+
 	private class SketchIcon : public Planet {
 	public:
 		SketchIcon() : Planet("transverse_section") {}
@@ -58,11 +83,7 @@ namespace {
 			this->decorates[TS::MaxDepth] = this->insert_one(new ArrowHeadlet(8.0F, +90.0, axes_color));
 			
 			{ // load designed section sketch
-				Turtle<TS>* s = new Turtle<TS>(stepsize, false, TS::lb);
-
-				s->move_right()->jump_left(0.5F, TS::MaxDepth)->move_up(4.0F, TS::MinDepth)->jump_left(0.5F)->move_right(TS::rt);
-				s->jump_right(3.0F)->move_left_down(1.0F, 2.0F)->move_left(1.5F)->move_down(2.0F)->move_left(2.0F)->move_left_up(2.5F, 4.0F);
-				s->jump_left_up(0.5F, 2.0F, TS::tide)->move_right(8.0F, TS::Width)->jump_down(8.0F)->move_left(8.0F);
+				Turtle<TS>* s = sketch_replay(new Turtle<TS>(stepsize, false, designed_sketch.home_anchor()), designed_sketch);
 
 				this->designed_section = this->insert_one(new Tracklet(s, thickness, designed_color));
 				this->designed_section->push_subtrack(TS::lb, TS::rt, axes_color);
@@ -70,10 +91,7 @@ namespace {
 			}
 
 			{ // load original section sketch
-				Turtle<TS>* s = new Turtle<TS>(stepsize, false);
-
-				s->drift(8.0F, 0.0F, 3.0F, 0.5F, 6.0F, -0.5F);
-				s->jump_down(5.0F)->move_left(8.0F);
+				Turtle<TS>* s = sketch_replay(new Turtle<TS>(stepsize, false, original_sketch.home_anchor()), original_sketch);
 
 				this->original_section = this->insert_one(new Tracklet(s, thickness, original_color));
 			}
@@ -88,7 +106,7 @@ namespace {
 	private: // never delete these graphlet manually
 		Tracklet<TS>* designed_section;
 		Tracklet<TS>* original_section;
-		std::map<TS, Shapelet*> decorates;
+		EnumArray<TS, Shapelet*> decorates;
 	};
 }
 
@@ -247,8 +265,8 @@ private:
 
 private: // never delete these graphlet manually
 	Profilet* transverse_section;
-	std::map<TS, Labellet*> labels;
-	std::map<TS, Credit<Dimensionlet, TS>*> metrics;
+	EnumArray<TS, Labellet*> labels;
+	EnumArray<TS, Credit<Dimensionlet, TS>*> metrics;
 	Planetlet* sketch;
 	
 private:
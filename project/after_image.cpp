@@ -0,0 +1,205 @@
+#include <cmath>
+#include <algorithm>
+
+#include "project/after_image.hpp"
+
+using namespace WarGrey::DTPM;
+
+static const int64_t no_bucket = INT64_MIN;
+
+/*************************************************************************************************/
+namespace {
+	static inline size_t ring_size(int64_t period, int64_t span) {
+		return size_t((period + span - 1) / span) + 1U;
+	}
+}
+
+/*************************************************************************************************/
+AfterImageRing::AfterImageRing(double period_hours, int64_t bucket_span)
+	: span((bucket_span > 0) ? bucket_span : 600), period(0), newest(no_bucket), count(0) {
+	this->set_period(period_hours);
+}
+
+void AfterImageRing::append(int64_t timepoint, double x, double y, double depth) {
+	int64_t b = this->bucket_of(timepoint);
+
+	// points that would have expired before arriving are dropped
+	if ((this->newest == no_bucket) || (b > this->newest - int64_t(this->ring.size()))) {
+		Bucket* bucket = &this->ring[this->slot_of(b)];
+
+		if (bucket->id != b) { // recycling the bucket of a whole ring ago
+			this->count -= bucket->points.size();
+			bucket->points.clear();
+			bucket->id = b;
+		}
+
+		bucket->points.push_back({ timepoint, x, y, depth });
+		this->newest = std::max(this->newest, b);
+		this->count++;
+	}
+}
+
+void AfterImageRing::expire(int64_t now) {
+	int64_t oldest = this->bucket_of(now - this->period);
+
+	for (auto it = this->ring.begin(); it != this->ring.end(); it++) {
+		if ((it->id != no_bucket) && (it->id < oldest)) {
+			this->count -= it->points.size();
+			it->points.clear();
+			it->id = no_bucket;
+		}
+	}
+}
+
+void AfterImageRing::set_period(double period_hours) {
+	int64_t seconds = std::max(int64_t(std::ceil(period_hours * 3600.0)), int64_t(1));
+	size_t n = ring_size(seconds, this->span);
+
+	if (n != this->ring.size()) {
+		std::vector<Bucket> resized(n);
+
+		for (auto it = resized.begin(); it != resized.end(); it++) {
+			it->id = no_bucket;
+		}
+
+		this->period = seconds;
+
+		for (auto it = this->ring.begin(); it != this->ring.end(); it++) {
+			if (it->id != no_bucket) {
+				if (it->id > this->newest - int64_t(n)) {
+					resized[this->slot_of_in(it->id, n)] = std::move(*it);
+				} else {
+					this->count -= it->points.size();
+				}
+			}
+		}
+
+		this->ring.swap(resized);
+	} else {
+		this->period = seconds;
+	}
+}
+
+void AfterImageRing::clear() {
+	for (auto it = this->ring.begin(); it != this->ring.end(); it++) {
+		it->points.clear();
+		it->id = no_bucket;
+	}
+
+	this->newest = no_bucket;
+	this->count = 0;
+}
+
+/*************************************************************************************************/
+size_t AfterImageRing::size() {
+	return this->count;
+}
+
+size_t AfterImageRing::bucket_count() {
+	return this->ring.size();
+}
+
+size_t AfterImageRing::capacity() {
+	size_t n = 0;
+
+	for (auto it = this->ring.begin(); it != this->ring.end(); it++) {
+		n += it->points.capacity();
+	}
+
+	return n;
+}
+
+double AfterImageRing::period_hours() {
+	return double(this->period) / 3600.0;
+}
+
+int64_t AfterImageRing::bucket_of(int64_t timepoint) {
+	int64_t b = timepoint / this->span;
+
+	return (((timepoint % this->span) < 0) ? (b - 1) : b);
+}
+
+size_t AfterImageRing::slot_of(int64_t bucket) {
+	return this->slot_of_in(bucket, this->ring.size());
+}
+
+size_t AfterImageRing::slot_of_in(int64_t bucket, size_t n) {
+	int64_t slot = bucket % int64_t(n);
+
+	return size_t((slot < 0) ? (slot + int64_t(n)) : slot);
+}
+
+/*************************************************************************************************/
+#ifdef AFTER_IMAGE_MAIN
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * `days` (30 by default) of 1Hz track with the after-image of 24 hours, the period is changed to 6 hours on day 10,
+ *   and to 48 hours on day 20; the after-image is expired and redrawn every minute.
+ */
+int main(int argc, char* argv[]) {
+	size_t days = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 30U);
+	const int64_t t0 = 1600000000;
+	AfterImageRing ring(24.0);
+	double append_ns = 0.0;
+	double expire_ns = 0.0;
+	size_t expirations = 0;
+	double sink = 0.0;
+
+	for (int64_t d = 0; d < int64_t(days); d++) {
+		auto a0 = std::chrono::steady_clock::now();
+		double resize_us = 0.0;
+
+		if ((d == 10) || (d == 20)) {
+			auto r0 = std::chrono::steady_clock::now();
+			ring.set_period((d == 10) ? 6.0 : 48.0);
+			resize_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - r0).count();
+		}
+
+		for (int64_t s = 0; s < 86400; s++) {
+			int64_t t = t0 + d * 86400 + s;
+
+			ring.append(t, double(s % 2000), double(s / 2000), 14.0);
+
+			if ((s % 60) == 59) {
+				auto e0 = std::chrono::steady_clock::now();
+				ring.expire(t);
+				expire_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - e0).count();
+				expirations++;
+			}
+		}
+
+		append_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - a0).count();
+
+		{ // the oldest point on the screen should be exactly one period ago
+			int64_t now = t0 + (d + 1) * 86400 - 1;
+			int64_t first = now;
+			size_t n = 0;
+
+			ring.for_each(now, [&first, &n, &sink](const AfterImagePoint& p) { first = std::min(first, p.timepoint); sink += p.x; n++; });
+
+			if ((n > ring.size()) || (ring.size() - n > 600)) { // at most a bucket of expired points is held
+				fprintf(stderr, "day %lld: %zu points visible, %zu held\n", (long long)(d), n, ring.size());
+				return 1;
+			}
+
+			printf("day %2lld: %4.0fh, %7zu points held, capacity %7zu (%5.1f MB), oldest %6.2fh ago",
+				(long long)(d + 1), ring.period_hours(), ring.size(), ring.capacity(),
+				double(ring.capacity() * sizeof(AfterImagePoint)) / 1048576.0, double(now - first) / 3600.0);
+
+			if (resize_us > 0.0) {
+				printf(", resized in %.1f us", resize_us);
+			}
+
+			printf("\n");
+		}
+	}
+
+	printf("  append+expire: %.1f ns per point, expire: %.1f ns per call (%zu buckets), checksum %g\n",
+		append_ns / (double(days) * 86400.0), expire_ns / double(expirations), ring.bucket_count(), sink);
+
+	return 0;
+}
+#endif
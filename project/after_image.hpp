@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+namespace WarGrey::DTPM {
+	struct AfterImagePoint {
+		int64_t timepoint; // seconds, as `current_seconds()`
+		double x;
+		double y;
+		double depth;
+	};
+
+	/**
+	 * The live after-image of the track, points of the last `after_image_period` hours.
+	 *
+	 * Points are kept in a ring of buckets, each bucket holds `bucket_span` seconds,
+	 *   so that appending is amortized O(1), and expiring drops whole buckets rather than scanning points;
+	 * buckets are recycled with their capacities, hence memory stays flat however long the dredger runs.
+	 *
+	 * Changing the period moves buckets into a ring of the new size, points are not copied, and history is not re-read,
+	 *   points that have expired before the period grows are gone.
+	 */
+	class AfterImageRing {
+	public:
+		AfterImageRing(double period_hours = 24.0, int64_t bucket_span = 600);
+
+	public:
+		void append(int64_t timepoint, double x, double y, double depth);
+		void expire(int64_t now);
+		void set_period(double period_hours);
+		void clear();
+
+	public:
+		/**
+		 * applies `f(const AfterImagePoint&)` to points within the period before `now`, in time order of buckets.
+		 */
+		template<typename F>
+		void for_each(int64_t now, F f) {
+			int64_t oldest = now - this->period;
+			int64_t b0 = ((this->newest == INT64_MIN) ? 0 : std::max(this->bucket_of(oldest), this->newest - int64_t(this->ring.size()) + 1));
+
+			for (int64_t b = b0; b <= this->newest; b++) {
+				Bucket* bucket = &this->ring[this->slot_of(b)];
+
+				if (bucket->id == b) {
+					for (auto it = bucket->points.begin(); it != bucket->points.end(); it++) {
+						if ((it->timepoint >= oldest) && (it->timepoint <= now)) {
+							f(*it);
+						}
+					}
+				}
+			}
+		}
+
+	public:
+		size_t size();
+		size_t bucket_count();
+		size_t capacity(); // points that could be held without allocating
+		double period_hours();
+
+	private:
+		struct Bucket {
+			int64_t id;
+			std::vector<WarGrey::DTPM::AfterImagePoint> points;
+		};
+
+	private:
+		int64_t bucket_of(int64_t timepoint);
+		size_t slot_of(int64_t bucket);
+		size_t slot_of_in(int64_t bucket, size_t n);
+
+	private:
+		std::vector<Bucket> ring;
+		int64_t span;
+		int64_t period;
+		int64_t newest;
+		size_t count;
+	};
+}
@@ -0,0 +1,278 @@
+#include <cstring>
+#include <algorithm>
+
+#include "project/dredged_volume.hpp"
+#include "project/parallel.hpp"
+
+using namespace WarGrey::DTPM;
+
+static const size_t dredged_sections_per_thread = 256;
+
+/*************************************************************************************************/
+namespace {
+	/**
+	 * A piece of the design where the depth is linear, `d(y) = d0 + k * (y - a)` for `y` in [a, b].
+	 */
+	struct DesignPiece {
+		double a;
+		double b;
+		double d0;
+		double k;
+	};
+
+	static size_t design_pieces(const DesignedChannel& design, DesignPiece pieces[3]) {
+		double half = design.bottom_width * 0.5;
+		double run = design.depth * design.slope;
+		size_t n = 0;
+
+		if (design.depth > 0.0) {
+			if (run > 0.0) { // the left slope
+				pieces[n++] = { design.center - half - run, design.center - half, 0.0, 1.0 / design.slope };
+			}
+
+			if (half > 0.0) {
+				pieces[n++] = { design.center - half, design.center + half, design.depth, 0.0 };
+			}
+
+			if (run > 0.0) { // the right slope
+				pieces[n++] = { design.center + half, design.center + half + run, design.depth, -1.0 / design.slope };
+			}
+		}
+
+		return n;
+	}
+
+	// integral of max(g, 0) over a segment of length `L` where `g` is linear
+	static inline double positive_integral(double g0, double g1, double L) {
+		double area = 0.0;
+
+		if ((g0 >= 0.0) && (g1 >= 0.0)) {
+			area = (g0 + g1) * 0.5 * L;
+		} else if ((g0 > 0.0) || (g1 > 0.0)) {
+			double p = std::max(g0, g1);
+			double n = -std::min(g0, g1);
+
+			area = p * p / (p + n) * 0.5 * L;
+		}
+
+		return area;
+	}
+}
+
+/*************************************************************************************************/
+SectionQuantity WarGrey::DTPM::dredged_section_area(const DesignedChannel& design, const double* offsets, const double* depths, size_t count) {
+	SectionQuantity q = { 0.0, 0.0 };
+	DesignPiece pieces[3];
+	size_t n = design_pieces(design, pieces);
+
+	for (size_t j = 1; (n > 0) && (j < count); j++) {
+		double y0 = offsets[j - 1];
+		double y1 = offsets[j];
+
+		if ((y1 > y0) && (y1 > pieces[0].a) && (y0 < pieces[n - 1].b)) {
+			double ds = (depths[j] - depths[j - 1]) / (y1 - y0);
+
+			for (size_t p = 0; p < n; p++) {
+				double lo = std::max(y0, pieces[p].a);
+				double hi = std::min(y1, pieces[p].b);
+
+				if (hi > lo) {
+					double slo = depths[j - 1] + ds * (lo - y0);
+					double shi = depths[j - 1] + ds * (hi - y0);
+					double dlo = pieces[p].d0 + pieces[p].k * (lo - pieces[p].a);
+					double dhi = pieces[p].d0 + pieces[p].k * (hi - pieces[p].a);
+
+					q.cut += positive_integral(dlo - slo, dhi - shi, hi - lo);
+					q.overdredged += positive_integral(slo - dlo - design.overdepth, shi - dhi - design.overdepth, hi - lo);
+				}
+			}
+		}
+	}
+
+	return q;
+}
+
+/*************************************************************************************************/
+DredgedVolumeEngine::DredgedVolumeEngine(size_t parallelism)
+	: chainages(nullptr), starts(nullptr), offsets(nullptr), depths(nullptr), count(0)
+	, areas(nullptr), cumulative(nullptr), parallelism(parallelism) {}
+
+DredgedVolumeEngine::~DredgedVolumeEngine() {
+	this->clear();
+}
+
+void DredgedVolumeEngine::clear() {
+	delete[] this->chainages;
+	delete[] this->starts;
+	delete[] this->offsets;
+	delete[] this->depths;
+	delete[] this->areas;
+	delete[] this->cumulative;
+
+	this->chainages = nullptr;
+	this->starts = nullptr;
+	this->offsets = nullptr;
+	this->depths = nullptr;
+	this->areas = nullptr;
+	this->cumulative = nullptr;
+	this->count = 0;
+}
+
+bool DredgedVolumeEngine::load(const double* chainages, const size_t* starts, const double* offsets, const double* depths, size_t section_count) {
+	bool okay = true;
+
+	for (size_t i = 0; okay && (i < section_count); i++) {
+		okay = (starts[i] <= starts[i + 1]) && ((i == 0) || (chainages[i - 1] <= chainages[i]));
+	}
+
+	if (okay) {
+		size_t point_count = starts[section_count] - starts[0];
+
+		this->clear();
+		this->count = section_count;
+		this->chainages = new double[section_count];
+		this->starts = new size_t[section_count + 1];
+		this->offsets = new double[point_count];
+		this->depths = new double[point_count];
+		this->areas = new SectionQuantity[section_count];
+		this->cumulative = new double[section_count];
+
+		memcpy(this->chainages, chainages, section_count * sizeof(double));
+		memcpy(this->offsets, offsets + starts[0], point_count * sizeof(double));
+		memcpy(this->depths, depths + starts[0], point_count * sizeof(double));
+
+		for (size_t i = 0; i <= section_count; i++) {
+			this->starts[i] = starts[i] - starts[0];
+		}
+
+		for (size_t i = 0; i < section_count; i++) {
+			this->areas[i] = { 0.0, 0.0 };
+			this->cumulative[i] = 0.0;
+		}
+	}
+
+	return okay;
+}
+
+DredgedVolume DredgedVolumeEngine::evaluate(const DesignedChannel& design) {
+	DredgedVolume volume = { 0.0, 0.0, 0.0, this->count };
+	size_t degree = parallel_degree(this->count, this->parallelism, dredged_sections_per_thread);
+
+	parallel_ranges(this->count, degree, [this, &design](size_t, size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			size_t p0 = this->starts[i];
+
+			this->areas[i] = dredged_section_area(design, this->offsets + p0, this->depths + p0, this->starts[i + 1] - p0);
+		}
+	});
+
+	if (this->count > 0) {
+		this->cumulative[0] = 0.0;
+
+		for (size_t i = 1; i < this->count; i++) { // the average end area method
+			double distance = this->chainages[i] - this->chainages[i - 1];
+
+			volume.cut += (this->areas[i - 1].cut + this->areas[i].cut) * 0.5 * distance;
+			volume.overdredged += (this->areas[i - 1].overdredged + this->areas[i].overdredged) * 0.5 * distance;
+			this->cumulative[i] = volume.cut;
+		}
+
+		volume.length = this->chainages[this->count - 1] - this->chainages[0];
+	}
+
+	return volume;
+}
+
+size_t DredgedVolumeEngine::section_count() {
+	return this->count;
+}
+
+const SectionQuantity* DredgedVolumeEngine::quantities() {
+	return this->areas;
+}
+
+const double* DredgedVolumeEngine::cumulative_cuts() {
+	return this->cumulative;
+}
+
+/*************************************************************************************************/
+#ifdef DREDGED_VOLUME_MAIN
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * A channel of `sections` transverse sections every 5 meters, each surveyed at `points` points across 200 meters,
+ *   the design is edited (deepened by 1cm) `edits` times, as the operator drags the value.
+ */
+int main(int argc, char* argv[]) {
+	size_t sections = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 50000U);
+	size_t points = ((argc > 2) ? strtoul(argv[2], nullptr, 10) : 200U);
+	size_t edits = ((argc > 3) ? strtoul(argv[3], nullptr, 10) : 20U);
+	std::vector<double> chainages(sections), offsets(sections * points), depths(sections * points);
+	std::vector<size_t> starts(sections + 1);
+	std::mt19937_64 prng(0);
+	std::normal_distribution<double> noise(0.0, 0.15);
+	DesignedChannel design = { 14.0, 120.0, 5.0, 0.0, 0.3 };
+	DredgedVolumeEngine serial(1), parallel(0);
+	DredgedVolume v1 = {}, vn = {};
+	double seconds[2] = { 0.0, 0.0 };
+
+	{ // a flat bottom at 12m has a trapezoid to cut, (14 - 12) * (120 + 5 * (14 - 12))
+		double flat_offsets[] = { -200.0, 200.0 };
+		double flat_depths[] = { 12.0, 12.0 };
+		SectionQuantity q = dredged_section_area(design, flat_offsets, flat_depths, 2);
+
+		if (fabs(q.cut - 260.0) > 1e-9) {
+			fprintf(stderr, "wrong area of the flat bottom: %.12f\n", q.cut);
+			return 1;
+		}
+	}
+
+	for (size_t i = 0; i < sections; i++) {
+		double shoal = 9.5 + 2.0 * sin(double(i) * 0.002);
+
+		chainages[i] = double(i) * 5.0;
+		starts[i] = i * points;
+
+		for (size_t j = 0; j < points; j++) {
+			double y = -100.0 + 200.0 * double(j) / double(points - 1);
+
+			offsets[i * points + j] = y;
+			depths[i * points + j] = shoal + 4.0 - 0.0004 * y * y + noise(prng);
+		}
+	}
+
+	starts[sections] = sections * points;
+
+	serial.load(chainages.data(), starts.data(), offsets.data(), depths.data(), sections);
+	parallel.load(chainages.data(), starts.data(), offsets.data(), depths.data(), sections);
+
+	for (size_t e = 0; e < edits; e++) {
+		auto t0 = std::chrono::steady_clock::now();
+		v1 = serial.evaluate(design);
+		auto t1 = std::chrono::steady_clock::now();
+		vn = parallel.evaluate(design);
+		auto t2 = std::chrono::steady_clock::now();
+
+		if ((v1.cut != vn.cut) || (v1.overdredged != vn.overdredged)) {
+			fprintf(stderr, "volumes depend on the number of threads\n");
+			return 1;
+		}
+
+		seconds[0] += std::chrono::duration<double>(t1 - t0).count();
+		seconds[1] += std::chrono::duration<double>(t2 - t1).count();
+		design.depth += 0.01;
+	}
+
+	printf("%zu sections x %zu points, %.1f km, cut %.0f m^3, overdredged %.0f m^3\n",
+		sections, points, vn.length * 0.001, vn.cut, vn.overdredged);
+	printf("  1 thread:  %8.2f ms per evaluation\n", seconds[0] * 1000.0 / double(edits));
+	printf("  %u threads: %8.2f ms per evaluation\n", std::max(std::thread::hardware_concurrency(), 1U), seconds[1] * 1000.0 / double(edits));
+
+	return 0;
+}
+#endif
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+
+namespace WarGrey::DTPM {
+	/**
+	 * The designed channel in a transverse section, depths are positive downward, offsets are lateral to the center line,
+	 *   the bottom is `bottom_width` wide at `depth`, centered at `center`,
+	 *   the side slopes rise `1` meter every `slope` meters horizontally (`0` for vertical walls) until they reach the water line;
+	 *   `overdepth` is the tolerance below the design before the bottom counts as overdredged.
+	 */
+	struct DesignedChannel {
+		double depth;
+		double bottom_width;
+		double slope;
+		double center;
+		double overdepth;
+	};
+
+	/**
+	 * Areas (m^2) of a section, `cut` is what remains above the design, `overdredged` is what has gone below the tolerance.
+	 */
+	struct SectionQuantity {
+		double cut;
+		double overdredged;
+	};
+
+	struct DredgedVolume {
+		double cut;         // m^3
+		double overdredged; // m^3
+		double length;      // m, along the channel
+		size_t sections;
+	};
+
+	/**
+	 * Surveyed sections are held in compressed rows, points of section `i` are [`starts[i]`, `starts[i + 1]`),
+	 *   ordered by offsets, the surveyed bottom between points is taken as linear,
+	 *   chainages should be ascending along the channel.
+	 *
+	 * Areas between the design and the surveyed bottom are integrated exactly (the two are both piecewise linear),
+	 *   sections are split among `parallelism` threads (0 for as many as the hardware has),
+	 *   volumes are summed by the average end area method, so results do not depend on the number of threads.
+	 *
+	 * Surveys are loaded once, designs could be evaluated repeatedly while the operator edits them.
+	 */
+	class DredgedVolumeEngine {
+	public:
+		virtual ~DredgedVolumeEngine() noexcept;
+		DredgedVolumeEngine(size_t parallelism = 0);
+
+	public:
+		bool load(const double* chainages, const size_t* starts, const double* offsets, const double* depths, size_t section_count);
+		WarGrey::DTPM::DredgedVolume evaluate(const WarGrey::DTPM::DesignedChannel& design);
+
+	public:
+		size_t section_count();
+		const WarGrey::DTPM::SectionQuantity* quantities(); // of the last evaluation
+		const double* cumulative_cuts();                     // m^3, from the first section to each one
+
+	private:
+		void clear();
+
+	private:
+		double* chainages;
+		size_t* starts;
+		double* offsets;
+		double* depths;
+		size_t count;
+
+	private:
+		WarGrey::DTPM::SectionQuantity* areas;
+		double* cumulative;
+		size_t parallelism;
+	};
+
+	/**
+	 * The area of one section, `count` points ordered by offsets.
+	 */
+	WarGrey::DTPM::SectionQuantity dredged_section_area(const WarGrey::DTPM::DesignedChannel& design,
+		const double* offsets, const double* depths, size_t count);
+}
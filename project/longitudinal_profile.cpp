@@ -0,0 +1,439 @@
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "project/longitudinal_profile.hpp"
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace WarGrey::DTPM;
+
+static const char longitudinal_profile_magic[8] = { 'D', 'T', 'P', 'M', 'L', 'P', 'F', '\0' };
+static const uint32_t longitudinal_profile_version = 1U;
+static const size_t no_chunk = static_cast<size_t>(-1);
+
+/*************************************************************************************************/
+namespace {
+	// std::fmin() and std::fmax() ignore NaN, which stands for no sounding
+	static inline void envelope_merge(float* mn, float* mx, float vmin, float vmax) {
+		(*mn) = std::fmin(*mn, vmin);
+		(*mx) = std::fmax(*mx, vmax);
+	}
+
+	static inline int file_seek(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+		return _fseeki64(file, int64_t(offset), SEEK_SET);
+#else
+		return fseeko(file, off_t(offset), SEEK_SET);
+#endif
+	}
+
+	static inline bool file_sync(FILE* file) {
+		bool okay = (fflush(file) == 0);
+
+#ifdef _WIN32
+		return okay && (_commit(_fileno(file)) == 0);
+#else
+		return okay && (fsync(fileno(file)) == 0);
+#endif
+	}
+}
+
+/*************************************************************************************************/
+bool WarGrey::DTPM::longitudinal_profile_save(const std::string& path, double origin, double spacing, const float* depths, size_t count) {
+	std::string tmp = path + ".tmp";
+	FILE* dest = fopen(tmp.c_str(), "wb");
+	bool okay = false;
+
+	if (dest != nullptr) {
+		LongitudinalProfileHeader header;
+
+		memset(&header, 0, sizeof(LongitudinalProfileHeader));
+		memcpy(header.magic, longitudinal_profile_magic, sizeof(header.magic));
+		header.version = longitudinal_profile_version;
+		header.origin = origin;
+		header.spacing = spacing;
+		header.count = count;
+
+		okay = (fwrite(&header, sizeof(LongitudinalProfileHeader), 1, dest) == 1)
+			&& (fwrite(depths, sizeof(float), count, dest) == count) && file_sync(dest);
+		okay = (fclose(dest) == 0) && okay;
+
+		if (okay) {
+			okay = mapped_file_replace(tmp, path);
+		} else {
+			remove(tmp.c_str());
+		}
+	}
+
+	return okay;
+}
+
+/*************************************************************************************************/
+LongitudinalProfile::LongitudinalProfile(size_t chunk_samples, size_t cached_chunks)
+	: src(nullptr), origin(0.0), step(1.0), count(0), tick(0), reads(0) {
+	this->chunk_samples = std::max(chunk_samples, base_bucket);
+	this->cached_chunks = std::max<size_t>(cached_chunks, 2U);
+	this->chunks = new float[this->chunk_samples * this->cached_chunks];
+	this->chunk_ids = new size_t[this->cached_chunks];
+	this->chunk_ticks = new uint64_t[this->cached_chunks];
+
+	for (size_t idx = 0; idx < this->cached_chunks; idx++) {
+		this->chunk_ids[idx] = no_chunk;
+		this->chunk_ticks[idx] = 0U;
+	}
+}
+
+LongitudinalProfile::~LongitudinalProfile() {
+	this->close();
+
+	delete[] this->chunks;
+	delete[] this->chunk_ids;
+	delete[] this->chunk_ticks;
+}
+
+bool LongitudinalProfile::open(const std::string& path) {
+	LongitudinalProfileHeader header;
+	bool okay = false;
+
+	this->close();
+	this->src = fopen(path.c_str(), "rb");
+
+	if (this->src != nullptr) {
+		okay = (fread(&header, sizeof(LongitudinalProfileHeader), 1, this->src) == 1)
+			&& (memcmp(header.magic, longitudinal_profile_magic, sizeof(header.magic)) == 0)
+			&& (header.version == longitudinal_profile_version)
+			&& (header.spacing > 0.0);
+	}
+
+	if (okay) {
+		size_t buckets = (size_t(header.count) + base_bucket - 1) / base_bucket;
+
+		this->origin = header.origin;
+		this->step = header.spacing;
+		this->count = size_t(header.count);
+		this->level_mins.push_back(std::vector<float>(buckets, NAN));
+		this->level_maxs.push_back(std::vector<float>(buckets, NAN));
+
+		// the only full pass, chunk by chunk, samples are not kept
+		for (size_t chunk = 0; okay && (chunk * this->chunk_samples < this->count); chunk++) {
+			const float* samples = this->pull_chunk(chunk);
+			size_t first = chunk * this->chunk_samples;
+			size_t n = std::min(this->chunk_samples, this->count - first);
+
+			if (samples == nullptr) {
+				okay = false;
+			} else {
+				float* mins = this->level_mins[0].data();
+				float* maxs = this->level_maxs[0].data();
+
+				for (size_t idx = 0; idx < n; idx++) {
+					size_t b = (first + idx) / base_bucket;
+
+					envelope_merge(mins + b, maxs + b, samples[idx], samples[idx]);
+				}
+			}
+		}
+
+		while (okay && (this->level_mins.back().size() > 1)) {
+			const std::vector<float>& fmins = this->level_mins.back();
+			const std::vector<float>& fmaxs = this->level_maxs.back();
+			size_t n = (fmins.size() + 1) / 2;
+			std::vector<float> mins(n, NAN);
+			std::vector<float> maxs(n, NAN);
+
+			for (size_t idx = 0; idx < fmins.size(); idx++) {
+				envelope_merge(&mins[idx / 2], &maxs[idx / 2], fmins[idx], fmaxs[idx]);
+			}
+
+			this->level_mins.push_back(std::move(mins));
+			this->level_maxs.push_back(std::move(maxs));
+		}
+	}
+
+	if (!okay) {
+		this->close();
+	}
+
+	return okay;
+}
+
+void LongitudinalProfile::close() {
+	if (this->src != nullptr) {
+		fclose(this->src);
+		this->src = nullptr;
+	}
+
+	for (size_t idx = 0; idx < this->cached_chunks; idx++) {
+		this->chunk_ids[idx] = no_chunk;
+	}
+
+	this->level_mins.clear();
+	this->level_maxs.clear();
+	this->count = 0;
+	this->reads = 0;
+}
+
+/*************************************************************************************************/
+size_t LongitudinalProfile::render(double chainage0, double chainage1, size_t columns, float* mins, float* maxs) {
+	size_t okay_columns = 0;
+
+	for (size_t c = 0; c < columns; c++) {
+		mins[c] = NAN;
+		maxs[c] = NAN;
+	}
+
+	if ((columns > 0) && (chainage1 > chainage0) && (this->count > 0)) {
+		double s0 = (chainage0 - this->origin) / this->step;
+		double samples_per_column = (chainage1 - chainage0) / this->step / double(columns);
+
+		if (samples_per_column < double(base_bucket)) {
+			this->render_samples(s0, samples_per_column, columns, mins, maxs);
+		} else {
+			size_t level = 0;
+
+			while ((level + 1 < this->level_mins.size()) && (double(base_bucket << (level + 1)) <= samples_per_column)) {
+				level++;
+			}
+
+			this->render_buckets(level, s0, samples_per_column, columns, mins, maxs);
+		}
+
+		for (size_t c = 0; c < columns; c++) {
+			if (!std::isnan(mins[c])) {
+				okay_columns++;
+			}
+		}
+	}
+
+	return okay_columns;
+}
+
+void LongitudinalProfile::render_buckets(size_t level, double s0, double samples_per_column, size_t columns, float* mins, float* maxs) {
+	const std::vector<float>& lmins = this->level_mins[level];
+	const std::vector<float>& lmaxs = this->level_maxs[level];
+	double bucket = double(base_bucket << level);
+	double total = double(lmins.size());
+
+	/**
+	 * column boundaries are snapped to the nearest bucket boundaries,
+	 *   a bucket is no wider than a column, so envelopes shift by less than a column.
+	 */
+	for (size_t c = 0; c < columns; c++) {
+		double end = s0 + samples_per_column * double(c + 1);
+
+		// columns before the origin stay NaN
+		if (end > 0.0) {
+			double b0 = std::max(std::round((s0 + samples_per_column * double(c)) / bucket), 0.0);
+			double b1 = std::min(std::max(std::round(end / bucket), b0 + 1.0), total);
+
+			for (size_t b = size_t(b0); double(b) < b1; b++) {
+				envelope_merge(mins + c, maxs + c, lmins[b], lmaxs[b]);
+			}
+		}
+	}
+}
+
+void LongitudinalProfile::render_samples(double s0, double samples_per_column, size_t columns, float* mins, float* maxs) {
+	double total = double(this->count);
+	size_t chunk = no_chunk;
+	const float* samples = nullptr;
+
+	for (size_t c = 0; c < columns; c++) {
+		double end = s0 + samples_per_column * double(c + 1);
+		double i0 = std::max(std::floor(s0 + samples_per_column * double(c)), 0.0);
+		double i1 = ((end > 0.0) ? std::min(std::max(std::floor(end), i0 + 1.0), total) : 0.0); // columns before the origin stay NaN
+
+		for (size_t i = size_t(i0); double(i) < i1; i++) {
+			if (i / this->chunk_samples != chunk) {
+				chunk = i / this->chunk_samples;
+				samples = this->pull_chunk(chunk);
+			}
+
+			if (samples != nullptr) {
+				float v = samples[i - chunk * this->chunk_samples];
+
+				envelope_merge(mins + c, maxs + c, v, v);
+			}
+		}
+	}
+}
+
+const float* LongitudinalProfile::pull_chunk(size_t chunk) {
+	size_t victim = 0;
+	float* samples = nullptr;
+
+	for (size_t idx = 0; idx < this->cached_chunks; idx++) {
+		if (this->chunk_ids[idx] == chunk) {
+			this->chunk_ticks[idx] = ++this->tick;
+			samples = this->chunks + idx * this->chunk_samples;
+			break;
+		} else if (this->chunk_ticks[idx] < this->chunk_ticks[victim]) {
+			victim = idx;
+		}
+	}
+
+	if ((samples == nullptr) && (this->src != nullptr)) {
+		size_t first = chunk * this->chunk_samples;
+		size_t n = std::min(this->chunk_samples, this->count - first);
+		uint64_t offset = uint64_t(sizeof(LongitudinalProfileHeader)) + uint64_t(first) * sizeof(float);
+
+		samples = this->chunks + victim * this->chunk_samples;
+
+		if ((file_seek(this->src, offset) == 0) && (fread(samples, sizeof(float), n, this->src) == n)) {
+			this->chunk_ids[victim] = chunk;
+			this->chunk_ticks[victim] = ++this->tick;
+			this->reads++;
+		} else {
+			this->chunk_ids[victim] = no_chunk;
+			samples = nullptr;
+		}
+	}
+
+	return samples;
+}
+
+/*************************************************************************************************/
+double LongitudinalProfile::first_chainage() {
+	return this->origin;
+}
+
+double LongitudinalProfile::last_chainage() {
+	return this->origin + this->step * double((this->count > 0) ? (this->count - 1) : 0);
+}
+
+double LongitudinalProfile::spacing() {
+	return this->step;
+}
+
+size_t LongitudinalProfile::sample_count() {
+	return this->count;
+}
+
+size_t LongitudinalProfile::chunk_reads() {
+	return this->reads;
+}
+
+/*************************************************************************************************/
+#ifdef LONGITUDINAL_PROFILE_MAIN
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+/**
+ * `km` kilometres of channel sounded every decimetre, rendered into 1920 columns at zoom levels
+ *   from the whole channel down to 100 meters, compared with scanning the samples in memory.
+ */
+int main(int argc, char* argv[]) {
+	double km = ((argc > 1) ? strtod(argv[1], nullptr) : 200.0);
+	std::string path = ((argc > 2) ? argv[2] : "/tmp/longitudinal.lpf");
+	const size_t columns = 1920;
+	size_t count = size_t(km * 10000.0);
+	float* depths = new float[count];
+	float mins[columns], maxs[columns];
+	std::mt19937_64 prng(0);
+	std::normal_distribution<float> noise(0.0F, 0.1F);
+	LongitudinalProfile profile;
+
+	for (size_t idx = 0; idx < count; idx++) {
+		double x = double(idx) * 0.1;
+
+		depths[idx] = float(14.0 + 1.5 * sin(x * 0.0005) + 0.5 * sin(x * 0.013)) + noise(prng);
+
+		if ((idx / 5000) % 97 == 13) { // a gap of no soundings
+			depths[idx] = NAN;
+		}
+	}
+
+	longitudinal_profile_save(path, 0.0, 0.1, depths, count);
+
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		bool okay = profile.open(path);
+		auto t1 = std::chrono::steady_clock::now();
+
+		if (!okay) {
+			fprintf(stderr, "failed to open %s\n", path.c_str());
+			return 1;
+		}
+
+		printf("%zu samples (%.0f km), opened in %.1f ms, %zu chunks read\n", count, km,
+			std::chrono::duration<double, std::milli>(t1 - t0).count(), profile.chunk_reads());
+	}
+
+	{ // windows straddling the origin, at the sample level and at a bucket level, draw nothing before it
+		double halves[] = { 100.0, km * 500.0 };
+
+		for (size_t h = 0; h < sizeof(halves) / sizeof(double); h++) {
+			size_t filled = profile.render(-halves[h], halves[h], columns, mins, maxs);
+			size_t before = 0;
+
+			for (size_t c = 0; c + 1 < columns / 2; c++) {
+				if (!std::isnan(mins[c])) {
+					before++;
+				}
+			}
+
+			if ((before > 0) || (filled == 0) || (filled > columns / 2 + 1)) {
+				fprintf(stderr, "+/-%.0f m: %zu columns drawn before the origin, %zu in total\n", halves[h], before, filled);
+				return 1;
+			}
+		}
+	}
+
+	for (double span = km * 1000.0; span >= 100.0; span *= 0.1) {
+		double c0 = km * 500.0 - span * 0.5;
+		size_t reads = profile.chunk_reads();
+		float emin = NAN, emax = NAN;
+		size_t filled = 0;
+		const size_t rounds = 20;
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t r = 0; r < rounds; r++) {
+			filled = profile.render(c0, c0 + span, columns, mins, maxs);
+		}
+		auto t1 = std::chrono::steady_clock::now();
+
+		// the brute force, with everything in memory
+		auto t2 = std::chrono::steady_clock::now();
+		for (size_t r = 0; r < rounds; r++) {
+			size_t i0 = size_t(c0 * 10.0);
+			size_t i1 = std::min(count, size_t((c0 + span) * 10.0));
+
+			emin = NAN;
+			emax = NAN;
+
+			for (size_t idx = i0; idx < i1; idx++) {
+				emin = std::fmin(emin, depths[idx]);
+				emax = std::fmax(emax, depths[idx]);
+			}
+		}
+		auto t3 = std::chrono::steady_clock::now();
+
+		{ // the envelope of all columns should agree with the brute force
+			float rmin = NAN, rmax = NAN;
+
+			for (size_t c = 0; c < columns; c++) {
+				rmin = std::fmin(rmin, mins[c]);
+				rmax = std::fmax(rmax, maxs[c]);
+			}
+
+			printf("  %9.0f m: %4zu columns, %8.1f us/render (%zu chunk reads), scan %9.1f us, envelope [%.2f, %.2f] vs [%.2f, %.2f]\n",
+				span, filled, std::chrono::duration<double, std::micro>(t1 - t0).count() / double(rounds),
+				profile.chunk_reads() - reads, std::chrono::duration<double, std::micro>(t3 - t2).count() / double(rounds),
+				rmin, rmax, emin, emax);
+		}
+	}
+
+	profile.close();
+	remove(path.c_str());
+	delete[] depths;
+
+	return 0;
+}
+#endif
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+namespace WarGrey::DTPM {
+	/**
+	 * The data file of a longitudinal profile is a 40-byte header followed by `count` little-endian floats,
+	 *   depths sampled along the centre line every `spacing` meters from `origin`, NaN for no sounding.
+	 */
+	struct LongitudinalProfileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t reserved;
+		double origin;
+		double spacing;
+		uint64_t count;
+	};
+
+	bool longitudinal_profile_save(const std::string& path, double origin, double spacing, const float* depths, size_t count);
+
+	/**
+	 * Streams the longitudinal profile along kilometres of channel.
+	 *
+	 * Opening the file makes one pass over it to build a min/max pyramid,
+	 *   each bucket of level `k` covers `base_bucket << k` samples, the samples themselves are not kept.
+	 * Zoomed out, a column is answered by at most a few buckets of the level just finer than it;
+	 * zoomed in, samples are pulled chunk by chunk from the file, through a small LRU cache.
+	 * Either way, rendering takes time proportional to `columns` rather than the number of samples.
+	 */
+	class LongitudinalProfile {
+	public:
+		static const size_t base_bucket = 64;
+
+	public:
+		virtual ~LongitudinalProfile() noexcept;
+		LongitudinalProfile(size_t chunk_samples = 16384, size_t cached_chunks = 8);
+
+	public:
+		bool open(const std::string& path);
+		void close();
+
+	public:
+		/**
+		 * fills `mins` and `maxs` with the depth envelope of each column in [`chainage0`, `chainage1`),
+		 *   NaN if the column has no sounding, returns the number of columns that have data.
+		 */
+		size_t render(double chainage0, double chainage1, size_t columns, float* mins, float* maxs);
+
+	public:
+		double first_chainage();
+		double last_chainage();
+		double spacing();
+		size_t sample_count();
+		size_t chunk_reads(); // chunks read from the file since opened
+
+	private:
+		void render_buckets(size_t level, double s0, double samples_per_column, size_t columns, float* mins, float* maxs);
+		void render_samples(double s0, double samples_per_column, size_t columns, float* mins, float* maxs);
+		const float* pull_chunk(size_t chunk);
+
+	private:
+		FILE* src;
+		double origin;
+		double step;
+		size_t count;
+		std::vector<std::vector<float>> level_mins;
+		std::vector<std::vector<float>> level_maxs;
+
+	private:
+		float* chunks;
+		size_t* chunk_ids;
+		uint64_t* chunk_ticks;
+		size_t chunk_samples;
+		size_t cached_chunks;
+		uint64_t tick;
+		size_t reads;
+	};
+}
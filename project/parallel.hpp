@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+namespace WarGrey::DTPM {
+	/**
+	 * The number of threads worth spawning for `count` items, at least `grain` items per thread,
+	 *   `parallelism` 0 means as many as the hardware has.
+	 */
+	inline size_t parallel_degree(size_t count, size_t parallelism, size_t grain) {
+		if (parallelism == 0) {
+			parallelism = std::max<size_t>(std::thread::hardware_concurrency(), 1U);
+		}
+
+		return std::max<size_t>(std::min(parallelism, count / std::max<size_t>(grain, 1U)), 1U);
+	}
+
+	/**
+	 * Runs `task(thread_index, start, end)` on disjoint ranges of [0, count),
+	 *   the calling thread takes the first range.
+	 */
+	template<typename F>
+	void parallel_ranges(size_t count, size_t parallelism, F task) {
+		size_t n = std::max<size_t>(parallelism, 1U);
+		size_t step = (count + n - 1) / n;
+		std::vector<std::thread> workers;
+
+		for (size_t i = 1; i < n; i++) {
+			size_t start = std::min(count, step * i);
+			size_t end = std::min(count, start + step);
+
+			workers.push_back(std::thread(task, i, start, end));
+		}
+
+		task(0U, 0U, std::min(count, step));
+
+		for (auto it = workers.begin(); it != workers.end(); it++) {
+			it->join();
+		}
+	}
+
+	/**
+	 * Runs `task(thread_index, item)` for every item in [0, count), threads claim items one by one from a shared cursor,
+	 *   so that a thread done with cheap items takes over the rest rather than waiting for the others.
+	 */
+	template<typename F>
+	void parallel_items(size_t count, size_t parallelism, F task) {
+		std::atomic<size_t> cursor(0U);
+
+		parallel_ranges(std::max<size_t>(parallelism, 1U), parallelism, [&cursor, count, &task](size_t tid, size_t, size_t) {
+			for (size_t item = cursor.fetch_add(1U); item < count; item = cursor.fetch_add(1U)) {
+				task(tid, item);
+			}
+		});
+	}
+}
@@ -0,0 +1,291 @@
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "project/polyline_simplify.hpp"
+#include "project/parallel.hpp"
+
+using namespace WarGrey::DTPM;
+
+/*************************************************************************************************/
+namespace {
+	// squared distance from (px, py) to the segment, rather than the line, since tracks turn back
+	static inline double segment_distance2(double px, double py, double ax, double ay, double bx, double by) {
+		double dx = bx - ax;
+		double dy = by - ay;
+		double length2 = dx * dx + dy * dy;
+		double t = ((length2 > 0.0) ? ((px - ax) * dx + (py - ay) * dy) / length2 : 0.0);
+
+		t = std::min(std::max(t, 0.0), 1.0);
+		dx = ax + t * dx - px;
+		dy = ay + t * dy - py;
+
+		return dx * dx + dy * dy;
+	}
+}
+
+/*************************************************************************************************/
+size_t WarGrey::DTPM::polyline_simplify(const double* xs, const double* ys, size_t first, size_t last, double tolerance
+	, uint8_t* keeps, std::vector<size_t>& stack) {
+	double tolerance2 = tolerance * tolerance;
+	size_t n = ((last > first) ? 2 : 1);
+
+	stack.clear();
+
+	if (last > first + 1) {
+		stack.push_back(first);
+		stack.push_back(last);
+	}
+
+	while (!stack.empty()) {
+		size_t b = stack.back(); stack.pop_back();
+		size_t a = stack.back(); stack.pop_back();
+		double farthest = -1.0;
+		size_t split = a;
+
+		for (size_t idx = a + 1; idx < b; idx++) {
+			double d2 = segment_distance2(xs[idx], ys[idx], xs[a], ys[a], xs[b], ys[b]);
+
+			if (d2 > farthest) {
+				farthest = d2;
+				split = idx;
+			}
+		}
+
+		if (farthest > tolerance2) {
+			keeps[split] = 1;
+			n++;
+
+			if (split > a + 1) {
+				stack.push_back(a);
+				stack.push_back(split);
+			}
+
+			if (b > split + 1) {
+				stack.push_back(split);
+				stack.push_back(b);
+			}
+		}
+	}
+
+	return n;
+}
+
+/*************************************************************************************************/
+PolylineSimplifier::PolylineSimplifier(size_t parallelism, size_t piece_points)
+	: xs(nullptr), ys(nullptr), starts(nullptr), count(0), point_count(0)
+	, keeps(nullptr), kept(nullptr), kept_starts(nullptr), kept_count(0), cached_tolerance(NAN), recomputed(0)
+	, parallelism(parallelism), piece_points(std::max<size_t>(piece_points, 2U)) {}
+
+PolylineSimplifier::~PolylineSimplifier() {
+	this->clear();
+}
+
+void PolylineSimplifier::clear() {
+	delete[] this->xs;
+	delete[] this->ys;
+	delete[] this->starts;
+	delete[] this->keeps;
+	delete[] this->kept;
+	delete[] this->kept_starts;
+
+	this->xs = nullptr;
+	this->ys = nullptr;
+	this->starts = nullptr;
+	this->keeps = nullptr;
+	this->kept = nullptr;
+	this->kept_starts = nullptr;
+	this->piece_firsts.clear();
+	this->piece_lasts.clear();
+	this->count = 0;
+	this->point_count = 0;
+	this->kept_count = 0;
+	this->cached_tolerance = NAN;
+}
+
+bool PolylineSimplifier::load(const double* xs, const double* ys, const size_t* starts, size_t polyline_count) {
+	bool okay = true;
+
+	for (size_t i = 0; okay && (i < polyline_count); i++) {
+		okay = (starts[i] <= starts[i + 1]);
+	}
+
+	okay = okay && (starts[polyline_count] - starts[0] <= size_t(UINT32_MAX));
+
+	if (okay) {
+		size_t n = starts[polyline_count] - starts[0];
+
+		this->clear();
+		this->count = polyline_count;
+		this->point_count = n;
+		this->xs = new double[n];
+		this->ys = new double[n];
+		this->starts = new size_t[polyline_count + 1];
+		this->keeps = new uint8_t[n];
+		this->kept = new uint32_t[n];
+		this->kept_starts = new size_t[polyline_count + 1];
+
+		memcpy(this->xs, xs + starts[0], n * sizeof(double));
+		memcpy(this->ys, ys + starts[0], n * sizeof(double));
+
+		for (size_t i = 0; i <= polyline_count; i++) {
+			this->starts[i] = starts[i] - starts[0];
+			this->kept_starts[i] = 0;
+		}
+
+		// pieces share their ends, and never cross polylines
+		for (size_t i = 0; i < polyline_count; i++) {
+			if (this->starts[i + 1] > this->starts[i]) {
+				size_t last = this->starts[i + 1] - 1;
+
+				for (size_t first = this->starts[i]; first < last; first += this->piece_points - 1) {
+					this->piece_firsts.push_back(first);
+					this->piece_lasts.push_back(std::min(first + this->piece_points - 1, last));
+				}
+			}
+		}
+	}
+
+	return okay;
+}
+
+size_t PolylineSimplifier::simplify(double scale, double pixel_tolerance) {
+	double tolerance = ((scale > 0.0) ? std::max(pixel_tolerance, 0.0) / scale : 0.0);
+
+	if (tolerance != this->cached_tolerance) {
+		size_t piece_count = this->piece_firsts.size();
+		size_t degree = parallel_degree(piece_count, this->parallelism, 1U);
+		std::vector<std::vector<size_t>> stacks(degree);
+
+		memset(this->keeps, 0, this->point_count * sizeof(uint8_t));
+
+		for (size_t i = 0; i < this->count; i++) {
+			if (this->starts[i + 1] > this->starts[i]) {
+				this->keeps[this->starts[i]] = 1;
+			}
+		}
+
+		for (size_t p = 0; p < piece_count; p++) {
+			this->keeps[this->piece_lasts[p]] = 1;
+		}
+
+		parallel_items(piece_count, degree, [this, tolerance, &stacks](size_t tid, size_t p) {
+			polyline_simplify(this->xs, this->ys, this->piece_firsts[p], this->piece_lasts[p],
+				tolerance, this->keeps, stacks[tid]);
+		});
+
+		this->kept_count = 0;
+
+		for (size_t i = 0; i < this->count; i++) {
+			this->kept_starts[i] = this->kept_count;
+
+			for (size_t idx = this->starts[i]; idx < this->starts[i + 1]; idx++) {
+				if (this->keeps[idx] != 0) {
+					this->kept[this->kept_count++] = uint32_t(idx);
+				}
+			}
+		}
+
+		this->kept_starts[this->count] = this->kept_count;
+		this->cached_tolerance = tolerance;
+		this->recomputed++;
+	}
+
+	return this->kept_count;
+}
+
+/*************************************************************************************************/
+size_t PolylineSimplifier::polyline_count() {
+	return this->count;
+}
+
+const uint32_t* PolylineSimplifier::indices() {
+	return this->kept;
+}
+
+const size_t* PolylineSimplifier::simplified_starts() {
+	return this->kept_starts;
+}
+
+size_t PolylineSimplifier::simplifications() {
+	return this->recomputed;
+}
+
+/*************************************************************************************************/
+#ifdef POLYLINE_SIMPLIFY_MAIN
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * A dredge track of `points` GPS fixes (one per second, lanes of 2 km back and forth, with 0.3m noise),
+ *   cut into segments of 3600 fixes (hours) as `DredgeTracklet` draws them,
+ *   simplified for views of 0.01 to 10 pixels per meter with 0.5 pixel of tolerance.
+ */
+int main(int argc, char* argv[]) {
+	size_t points = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 1000000U);
+	size_t threads = ((argc > 2) ? strtoul(argv[2], nullptr, 10) : 0U);
+	const size_t segment_points = 3600;
+	const double pixel_tolerance = 0.5;
+	size_t segment_count = (points + segment_points - 1) / segment_points;
+	std::vector<double> xs(points), ys(points);
+	std::vector<size_t> starts(segment_count + 1);
+	std::mt19937_64 prng(0);
+	std::normal_distribution<double> noise(0.0, 0.3);
+	PolylineSimplifier simplifier(threads);
+
+	for (size_t idx = 0; idx < points; idx++) {
+		size_t lane = idx / 400; // 400s for 2km at 5m/s
+		double along = double(idx % 400) * 5.0;
+
+		xs[idx] = (((lane % 2) == 0) ? along : 2000.0 - along) + noise(prng);
+		ys[idx] = double(lane % 50) * 20.0 + 3.0 * sin(double(idx) * 0.01) + noise(prng);
+	}
+
+	for (size_t i = 0; i <= segment_count; i++) {
+		starts[i] = std::min(i * segment_points, points);
+	}
+
+	simplifier.load(xs.data(), ys.data(), starts.data(), segment_count);
+	printf("%zu points in %zu segments, %.1f pixels of tolerance\n", points, segment_count, pixel_tolerance);
+
+	for (double scale = 0.01; scale < 11.0; scale *= 10.0) {
+		auto t0 = std::chrono::steady_clock::now();
+		size_t kept = simplifier.simplify(scale, pixel_tolerance);
+		auto t1 = std::chrono::steady_clock::now();
+		size_t again = simplifier.simplify(scale, pixel_tolerance); // panning, the cache should be hit
+		auto t2 = std::chrono::steady_clock::now();
+		double tolerance = pixel_tolerance / scale;
+		double worst = 0.0;
+
+		// every dropped point should be within the tolerance of its replacing segment
+		for (size_t i = 0; i < segment_count; i++) {
+			const uint32_t* kidx = simplifier.indices();
+
+			for (size_t k = simplifier.simplified_starts()[i] + 1; k < simplifier.simplified_starts()[i + 1]; k++) {
+				size_t a = kidx[k - 1];
+				size_t b = kidx[k];
+
+				for (size_t idx = a + 1; idx < b; idx++) {
+					worst = std::max(worst, sqrt(segment_distance2(xs[idx], ys[idx], xs[a], ys[a], xs[b], ys[b])));
+				}
+			}
+		}
+
+		if ((worst > tolerance) || (again != kept)) {
+			fprintf(stderr, "the error bound is broken: %f > %f\n", worst, tolerance);
+			return 1;
+		}
+
+		printf("  %5.2f px/m: %8zu -> %7zu points (%5.2f%%), %7.2f ms, cached %.3f us, worst error %.3f of %.3f m\n",
+			scale, points, kept, double(kept) * 100.0 / double(points),
+			std::chrono::duration<double, std::milli>(t1 - t0).count(),
+			std::chrono::duration<double, std::micro>(t2 - t1).count(), worst, tolerance);
+	}
+
+	printf("  recomputed %zu times\n", simplifier.simplifications());
+
+	return 0;
+}
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace WarGrey::DTPM {
+	/**
+	 * Douglas-Peucker on [`first`, `last`] of one polyline, marks the points kept strictly between the two ends in `keeps`,
+	 *   the ends are always kept, and are left to the caller to mark; returns the number of kept points, including the ends.
+	 * No dropped point is farther than `tolerance` from the segment that replaces it.
+	 *
+	 * It is iterative, so that million-point tracks do not overflow the stack; `stack` is the scratch, reused among calls.
+	 */
+	size_t polyline_simplify(const double* xs, const double* ys, size_t first, size_t last, double tolerance,
+		uint8_t* keeps, std::vector<size_t>& stack);
+
+	/**
+	 * Simplifies sections or track segments before they are sent to graphlets,
+	 *   polylines are held in compressed rows as `DredgedVolumeEngine` does, points of polyline `i` are [`starts[i]`, `starts[i + 1]`).
+	 *
+	 * The error bound is given in pixels, and is converted into meters by the `scale` (pixels per meter) of the view,
+	 *   results are cached until the scale or the tolerance changes, panning does not invalidate them.
+	 *
+	 * Long polylines are cut into pieces of `piece_points` points (their ends are kept),
+	 *   pieces are claimed by `parallelism` threads (0 for as many as the hardware has) one by one,
+	 *   so that a long track does not keep one thread busy while the others are idle.
+	 */
+	class PolylineSimplifier {
+	public:
+		virtual ~PolylineSimplifier() noexcept;
+		PolylineSimplifier(size_t parallelism = 0, size_t piece_points = 4096);
+
+	public:
+		bool load(const double* xs, const double* ys, const size_t* starts, size_t polyline_count);
+		size_t simplify(double scale, double pixel_tolerance); // returns the number of points kept
+
+	public:
+		size_t polyline_count();
+		const uint32_t* indices();        // of the kept points, polyline by polyline
+		const size_t* simplified_starts(); // kept points of polyline `i` are [`simplified_starts()[i]`, `simplified_starts()[i + 1]`)
+		size_t simplifications();          // times the cache is recomputed
+
+	private:
+		void clear();
+
+	private:
+		double* xs;
+		double* ys;
+		size_t* starts;
+		size_t count;
+		size_t point_count;
+
+	private:
+		std::vector<size_t> piece_firsts;
+		std::vector<size_t> piece_lasts;
+		uint8_t* keeps;
+		uint32_t* kept;
+		size_t* kept_starts;
+		size_t kept_count;
+		double cached_tolerance;
+		size_t recomputed;
+
+	private:
+		size_t parallelism;
+		size_t piece_points;
+	};
+}
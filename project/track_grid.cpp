@@ -0,0 +1,428 @@
+#include <cmath>
+#include <algorithm>
+
+#include "project/track_grid.hpp"
+
+using namespace WarGrey::DTPM;
+
+static const double default_cell_size = 100.0;
+
+/*************************************************************************************************/
+namespace {
+	static inline uint64_t cell_key(int32_t cx, int32_t cy) {
+		return (uint64_t(uint32_t(cx)) << 32U) | uint64_t(uint32_t(cy));
+	}
+
+	static inline double segment_distance2(double px, double py, double ax, double ay, double bx, double by) {
+		double dx = bx - ax;
+		double dy = by - ay;
+		double length2 = dx * dx + dy * dy;
+		double t = ((length2 > 0.0) ? ((px - ax) * dx + (py - ay) * dy) / length2 : 0.0);
+
+		t = std::min(std::max(t, 0.0), 1.0);
+		dx = ax + t * dx - px;
+		dy = ay + t * dy - py;
+
+		return dx * dx + dy * dy;
+	}
+
+	// Liang-Barsky, whether the segment touches the box
+	static bool segment_hits_box(double ax, double ay, double bx, double by, double xmin, double ymin, double xmax, double ymax) {
+		double p[4] = { ax - bx, bx - ax, ay - by, by - ay };
+		double q[4] = { ax - xmin, xmax - ax, ay - ymin, ymax - ay };
+		double t0 = 0.0;
+		double t1 = 1.0;
+		bool hit = true;
+
+		for (size_t idx = 0; hit && (idx < 4); idx++) {
+			if (p[idx] == 0.0) {
+				hit = (q[idx] >= 0.0);
+			} else {
+				double t = q[idx] / p[idx];
+
+				if (p[idx] < 0.0) {
+					t0 = std::max(t0, t);
+				} else {
+					t1 = std::min(t1, t);
+				}
+
+				hit = (t0 <= t1);
+			}
+		}
+
+		return hit;
+	}
+}
+
+/*************************************************************************************************/
+TrackGridIndex::TrackGridIndex(double cell_size)
+	: size((cell_size > 0.0) ? cell_size : default_cell_size), broken(false), stamp(0U) {}
+
+bool TrackGridIndex::append(int64_t timepoint, double x, double y) {
+	size_t n = this->xs.size();
+	bool okay = std::isfinite(x) && std::isfinite(y);
+
+	if (okay) {
+		if (n > 0) {
+			this->stamps.push_back(0U);
+
+			if (!this->broken) {
+				this->traverse(uint32_t(n - 1), this->xs[n - 1], this->ys[n - 1], x, y);
+			}
+		}
+
+		this->timepoints.push_back(timepoint);
+		this->xs.push_back(x);
+		this->ys.push_back(y);
+		this->broken = false;
+	}
+
+	return okay;
+}
+
+void TrackGridIndex::break_track() {
+	this->broken = true;
+}
+
+void TrackGridIndex::clear() {
+	this->timepoints.clear();
+	this->xs.clear();
+	this->ys.clear();
+	this->cells.clear();
+	this->stamps.clear();
+	this->stamp = 0U;
+	this->broken = false;
+}
+
+/*************************************************************************************************/
+size_t TrackGridIndex::cull(double xmin, double ymin, double xmax, double ymax, std::vector<uint32_t>& segments) {
+	size_t n = 0;
+
+	if ((xmin <= xmax) && (ymin <= ymax)) {
+		int32_t cx0 = this->cell_of(xmin);
+		int32_t cx1 = this->cell_of(xmax);
+		int32_t cy0 = this->cell_of(ymin);
+		int32_t cy1 = this->cell_of(ymax);
+
+		this->stamp++;
+		this->overlap(cx0, cy0, cx1, cy1);
+
+		for (auto cit = this->visiting.begin(); cit != this->visiting.end(); cit++) {
+			for (auto it = (*cit)->begin(); it != (*cit)->end(); it++) {
+				uint32_t s = (*it);
+
+				if (this->stamps[s] != this->stamp) {
+					this->stamps[s] = this->stamp;
+
+					if (segment_hits_box(this->xs[s], this->ys[s], this->xs[s + 1], this->ys[s + 1], xmin, ymin, xmax, ymax)) {
+						segments.push_back(s);
+						n++;
+					}
+				}
+			}
+		}
+	}
+
+	return n;
+}
+
+size_t TrackGridIndex::passes(double x, double y, std::vector<TrackPass>& passes) {
+	std::vector<uint32_t>* found = this->cell(this->cell_of(x), this->cell_of(y));
+	size_t n = 0;
+
+	// segments are registered in time order, so that runs of consecutive ids are passes
+	if ((found != nullptr) && (!found->empty())) {
+		TrackPass pass = { found->front(), found->front(), 0, 0 };
+
+		for (auto it = found->begin() + 1; it != found->end(); it++) {
+			if ((*it) == pass.last_segment + 1U) {
+				pass.last_segment = (*it);
+			} else {
+				pass.begin_timepoint = this->timepoints[pass.first_segment];
+				pass.end_timepoint = this->timepoints[pass.last_segment + 1];
+				passes.push_back(pass);
+				pass.first_segment = (*it);
+				pass.last_segment = (*it);
+				n++;
+			}
+		}
+
+		pass.begin_timepoint = this->timepoints[pass.first_segment];
+		pass.end_timepoint = this->timepoints[pass.last_segment + 1];
+		passes.push_back(pass);
+		n++;
+	}
+
+	return n;
+}
+
+uint32_t TrackGridIndex::pick(double x, double y, double radius) {
+	int32_t cx0 = this->cell_of(x - radius);
+	int32_t cx1 = this->cell_of(x + radius);
+	int32_t cy0 = this->cell_of(y - radius);
+	int32_t cy1 = this->cell_of(y + radius);
+	double nearest = radius * radius;
+	uint32_t picked = npos;
+
+	this->overlap(cx0, cy0, cx1, cy1);
+
+	for (auto cit = this->visiting.begin(); cit != this->visiting.end(); cit++) {
+		for (auto it = (*cit)->begin(); it != (*cit)->end(); it++) {
+			uint32_t s = (*it);
+			double d2 = segment_distance2(x, y, this->xs[s], this->ys[s], this->xs[s + 1], this->ys[s + 1]);
+
+			if ((d2 < nearest) || ((d2 == nearest) && (s < picked))) {
+				nearest = d2;
+				picked = s;
+			}
+		}
+	}
+
+	return picked;
+}
+
+/*************************************************************************************************/
+size_t TrackGridIndex::point_count() {
+	return this->xs.size();
+}
+
+size_t TrackGridIndex::cell_count() {
+	return this->cells.size();
+}
+
+double TrackGridIndex::cell_size() {
+	return this->size;
+}
+
+int64_t TrackGridIndex::timepoint(uint32_t point) {
+	return this->timepoints[point];
+}
+
+int32_t TrackGridIndex::cell_of(double v) {
+	double c = std::floor(v / this->size);
+
+	// queries are not checked as points are, NaN goes to the lowest cell
+	if (!(c >= double(INT32_MIN))) {
+		c = double(INT32_MIN);
+	} else if (c > double(INT32_MAX)) {
+		c = double(INT32_MAX);
+	}
+
+	return int32_t(c);
+}
+
+std::vector<uint32_t>* TrackGridIndex::cell(int32_t cx, int32_t cy) {
+	auto it = this->cells.find(cell_key(cx, cy));
+
+	return ((it == this->cells.end()) ? nullptr : &it->second);
+}
+
+void TrackGridIndex::overlap(int32_t cx0, int32_t cy0, int32_t cx1, int32_t cy1) {
+	int64_t width = int64_t(cx1) - int64_t(cx0) + 1;
+	int64_t height = int64_t(cy1) - int64_t(cy0) + 1;
+
+	this->visiting.clear();
+
+	/** NOTE
+	 * A box of more cells than there are occupied ones, say, a zoomed-out viewport, tests the occupied cells against the box instead,
+	 *   so that the cost follows the data rather than the area of the box.
+	 */
+	if ((width > 0) && (height > 0)) {
+		if ((double(width) * double(height)) > double(this->cells.size())) {
+			for (auto it = this->cells.begin(); it != this->cells.end(); it++) {
+				int32_t cx = int32_t(uint32_t(it->first >> 32U));
+				int32_t cy = int32_t(uint32_t(it->first));
+
+				if ((cx >= cx0) && (cx <= cx1) && (cy >= cy0) && (cy <= cy1)) {
+					this->visiting.push_back(&it->second);
+				}
+			}
+		} else {
+			for (int64_t cx = cx0; cx <= int64_t(cx1); cx++) {
+				for (int64_t cy = cy0; cy <= int64_t(cy1); cy++) {
+					std::vector<uint32_t>* found = this->cell(int32_t(cx), int32_t(cy));
+
+					if (found != nullptr) {
+						this->visiting.push_back(found);
+					}
+				}
+			}
+		}
+	}
+}
+
+void TrackGridIndex::traverse(uint32_t segment, double ax, double ay, double bx, double by) {
+	int32_t cx = this->cell_of(ax);
+	int32_t cy = this->cell_of(ay);
+	int32_t sx = ((bx > ax) ? 1 : -1);
+	int32_t sy = ((by > ay) ? 1 : -1);
+	int64_t nx = std::abs(int64_t(this->cell_of(bx)) - int64_t(cx));
+	int64_t ny = std::abs(int64_t(this->cell_of(by)) - int64_t(cy));
+	double dx = std::fabs(bx - ax);
+	double dy = std::fabs(by - ay);
+
+	// parameters along the segment where it crosses the next vertical and horizontal border, and the steps between borders
+	double tx = ((nx > 0) ? (((sx > 0) ? (double(cx) + 1.0) * this->size - ax : ax - double(cx) * this->size) / dx) : INFINITY);
+	double ty = ((ny > 0) ? (((sy > 0) ? (double(cy) + 1.0) * this->size - ay : ay - double(cy) * this->size) / dy) : INFINITY);
+	double tdx = ((nx > 0) ? this->size / dx : INFINITY);
+	double tdy = ((ny > 0) ? this->size / dy : INFINITY);
+
+	this->cells[cell_key(cx, cy)].push_back(segment);
+
+	/** NOTE
+	 * The walk takes exactly `nx` steps along x and `ny` along y, so it ends in the cell of the end point whatever the rounding is,
+	 *   at a corner crossed exactly, both cells beside the corner are registered, the segment touches them both.
+	 */
+	while ((nx > 0) || (ny > 0)) {
+		if ((ny == 0) || ((nx > 0) && (tx < ty))) {
+			cx += sx;
+			tx += tdx;
+			nx--;
+		} else if ((nx == 0) || (ty < tx)) {
+			cy += sy;
+			ty += tdy;
+			ny--;
+		} else {
+			this->cells[cell_key(cx + sx, cy)].push_back(segment);
+			cx += sx;
+			cy += sy;
+			tx += tdx;
+			ty += tdy;
+			nx--;
+			ny--;
+		}
+
+		this->cells[cell_key(cx, cy)].push_back(segment);
+	}
+}
+
+/*************************************************************************************************/
+#ifdef TRACK_GRID_MAIN
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+	/**
+	 * A day of 1Hz track dredging lanes of 2km back and forth, each day moves 2km down the channel,
+	 *   the GPS is lost for a minute every 6 hours.
+	 */
+	void make_history(TrackGridIndex* grid, size_t days) {
+		std::mt19937_64 prng(0);
+		std::normal_distribution<double> noise(0.0, 0.3);
+
+		for (int64_t t = 0; t < int64_t(days) * 86400; t++) {
+			int64_t day = t / 86400;
+			int64_t lane = (t % 86400) / 400;
+			double along = double(t % 400) * 5.0;
+			double x = double(day) * 2000.0 + (((lane % 2) == 0) ? along : 2000.0 - along);
+			double y = double(lane % 20) * 10.0;
+
+			if ((t % 21600) < 60) {
+				grid->break_track();
+			} else {
+				grid->append(t, x + noise(prng), y + noise(prng));
+			}
+		}
+	}
+}
+
+/**
+ * The same queries on the last day of a history that holds a day, a week and a season (`days`, 90 by default),
+ *   with `partition_distance` of 100m, costs should stay flat;
+ *   before that, culling a random walk is checked against testing every segment.
+ */
+int main(int argc, char* argv[]) {
+	size_t season = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 90U);
+	size_t histories[] = { 1, 7, season };
+	const size_t rounds = 1000;
+
+	{ // a random walk in every direction, culling must find what checking every segment finds, and NaN is rejected
+		TrackGridIndex grid(100.0);
+		std::mt19937_64 prng(2);
+		std::uniform_real_distribution<double> step(-180.0, 180.0);
+		std::vector<uint32_t> segments;
+		std::vector<double> xs(1, 0.0), ys(1, 0.0);
+		size_t expected = 0;
+
+		grid.append(0, 0.0, 0.0);
+
+		for (int64_t t = 1; t < 20000; t++) {
+			xs.push_back(xs.back() + step(prng));
+			ys.push_back(ys.back() + step(prng));
+			grid.append(t, xs.back(), ys.back());
+		}
+
+		for (size_t s = 0; s + 1 < xs.size(); s++) {
+			if (segment_hits_box(xs[s], ys[s], xs[s + 1], ys[s + 1], -500.0, -300.0, 700.0, 900.0)) {
+				expected++;
+			}
+		}
+
+		if ((grid.cull(-500.0, -300.0, 700.0, 900.0, segments) != expected) || grid.append(20000, NAN, 0.0) || grid.append(20001, 0.0, INFINITY)) {
+			fprintf(stderr, "culled %zu segments of %zu, or a point that is not finite is accepted\n", segments.size(), expected);
+			return 1;
+		}
+
+		// boxes of far more cells than occupied, up to the whole plane, cost what is occupied
+		double extents[] = { 2.0e5, 1.0e300, INFINITY };
+
+		for (size_t e = 0; e < sizeof(extents) / sizeof(double); e++) {
+			double extent = extents[e];
+			auto c0 = std::chrono::steady_clock::now();
+			size_t n = 0;
+
+			segments.clear();
+			n = grid.cull(-extent, -extent, extent, extent, segments);
+
+			if ((n != xs.size() - 1U) || (grid.pick(xs[7], ys[7], extent) == TrackGridIndex::npos)) {
+				fprintf(stderr, "culled %zu segments of %zu within +/-%g\n", n, xs.size() - 1U, extent);
+				return 1;
+			}
+
+			printf("culled all within +/-%g m in %.2f ms\n", extent,
+				std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - c0).count());
+		}
+	}
+
+	for (size_t h = 0; h < sizeof(histories) / sizeof(size_t); h++) {
+		TrackGridIndex grid(100.0);
+		double x0 = double(histories[h] - 1) * 2000.0;
+		std::vector<uint32_t> segments;
+		std::vector<TrackPass> passes;
+		std::mt19937_64 prng(1);
+		std::uniform_real_distribution<double> xpick(x0, x0 + 2000.0);
+		std::uniform_real_distribution<double> ypick(0.0, 190.0);
+		size_t culled = 0, passed = 0, picked = 0;
+
+		make_history(&grid, histories[h]);
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t r = 0; r < rounds; r++) {
+			segments.clear();
+			culled = grid.cull(x0 + 500.0, -50.0, x0 + 1500.0, 250.0, segments);
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		for (size_t r = 0; r < rounds; r++) {
+			passes.clear();
+			passed = grid.passes(x0 + 1000.0, 50.0, passes);
+		}
+		auto t2 = std::chrono::steady_clock::now();
+		for (size_t r = 0; r < rounds; r++) {
+			if (grid.pick(xpick(prng), ypick(prng), 5.0) != TrackGridIndex::npos) {
+				picked++;
+			}
+		}
+		auto t3 = std::chrono::steady_clock::now();
+
+		printf("%3zu days (%8zu points, %6zu cells): cull %6zu segments in %7.1f us, %3zu passes in %5.2f us, pick %5.2f us (%zu hits)\n",
+			histories[h], grid.point_count(), grid.cell_count(),
+			culled, std::chrono::duration<double, std::micro>(t1 - t0).count() / double(rounds),
+			passed, std::chrono::duration<double, std::micro>(t2 - t1).count() / double(rounds),
+			std::chrono::duration<double, std::micro>(t3 - t2).count() / double(rounds), picked);
+	}
+
+	return 0;
+}
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+namespace WarGrey::DTPM {
+	/**
+	 * A run of consecutive segments staying in one cell, namely the dredger passes the cell once.
+	 */
+	struct TrackPass {
+		uint32_t first_segment;
+		uint32_t last_segment;
+		int64_t begin_timepoint;
+		int64_t end_timepoint;
+	};
+
+	/**
+	 * The uniform grid behind `DredgeTrack::partition_distance`, cells are `cell_size` meters square,
+	 *   segment `i` joins point `i` and point `i + 1`, unless the track is broken there (e.g. the GPS is lost),
+	 *   and is registered in the cells it traverses (walked as a DDA), rather than every cell its bounding box covers.
+	 *
+	 * Queries visit only the occupied cells they overlap, so that they cost what is in the window rather than what is in the history,
+	 *   nor the area of the window.
+	 */
+	class TrackGridIndex {
+	public:
+		static const uint32_t npos = UINT32_MAX;
+
+	public:
+		TrackGridIndex(double cell_size);
+
+	public:
+		bool append(int64_t timepoint, double x, double y); // points that are not finite are rejected
+		void break_track(); // the next point starts a new segment chain
+		void clear();
+
+	public:
+		/**
+		 * appends segments that intersect the box to `segments`, each once, in no specific order.
+		 */
+		size_t cull(double xmin, double ymin, double xmax, double ymax, std::vector<uint32_t>& segments);
+
+		/**
+		 * appends passes through the cell that contains (x, y) to `passes`, in time order.
+		 */
+		size_t passes(double x, double y, std::vector<WarGrey::DTPM::TrackPass>& passes);
+
+		/**
+		 * returns the segment nearest to (x, y) within `radius`, or `npos`.
+		 */
+		uint32_t pick(double x, double y, double radius);
+
+	public:
+		size_t point_count();
+		size_t cell_count();
+		double cell_size();
+		int64_t timepoint(uint32_t point);
+
+	private:
+		int32_t cell_of(double v);
+		std::vector<uint32_t>* cell(int32_t cx, int32_t cy);
+		void overlap(int32_t cx0, int32_t cy0, int32_t cx1, int32_t cy1); // collects occupied cells within the range into `visiting`
+		void traverse(uint32_t segment, double ax, double ay, double bx, double by);
+
+	private:
+		std::vector<int64_t> timepoints;
+		std::vector<double> xs;
+		std::vector<double> ys;
+		std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+		double size;
+		bool broken;
+
+	private:
+		std::vector<uint32_t> stamps; // of segments, to report each segment once per query
+		std::vector<std::vector<uint32_t>*> visiting;
+		uint32_t stamp;
+	};
+}
@@ -0,0 +1,232 @@
+#include <cmath>
+
+#include "project/track_ingest.hpp"
+
+using namespace WarGrey::DTPM;
+
+/*************************************************************************************************/
+TrackDecimator::TrackDecimator(double subinterval, int64_t max_period, double depth_tolerance)
+	: subinterval(std::fmax(subinterval, 0.0)), max_period(max_period), depth_tolerance(std::fmax(depth_tolerance, 0.0))
+	, fresh(true), last_timepoint(0), last_x(0.0), last_y(0.0), last_depth(0.0), in(0), out(0) {}
+
+bool TrackDecimator::admit(int64_t timepoint, double x, double y, double depth) {
+	bool okay = this->fresh;
+
+	this->in++;
+
+	if (!okay) {
+		double dx = x - this->last_x;
+		double dy = y - this->last_y;
+
+		okay = ((dx * dx + dy * dy) >= (this->subinterval * this->subinterval))
+			|| ((this->max_period > 0) && (timepoint - this->last_timepoint >= this->max_period))
+			|| ((this->depth_tolerance > 0.0) && (std::fabs(depth - this->last_depth) >= this->depth_tolerance));
+	}
+
+	if (okay) {
+		this->fresh = false;
+		this->last_timepoint = timepoint;
+		this->last_x = x;
+		this->last_y = y;
+		this->last_depth = depth;
+		this->out++;
+	}
+
+	return okay;
+}
+
+void TrackDecimator::set_subinterval(double subinterval) {
+	this->subinterval = std::fmax(subinterval, 0.0);
+}
+
+void TrackDecimator::reset() {
+	this->fresh = true;
+}
+
+size_t TrackDecimator::received() {
+	return this->in;
+}
+
+size_t TrackDecimator::admitted() {
+	return this->out;
+}
+
+/*************************************************************************************************/
+TrackIngest::TrackIngest(size_t stream_count, double subinterval, int64_t max_period, double depth_tolerance)
+	: decimated(stream_count), audit(stream_count)
+	, decimators(stream_count, TrackDecimator(subinterval, max_period, depth_tolerance)) {}
+
+TrackIngest::~TrackIngest() {
+	this->close();
+}
+
+bool TrackIngest::open(const std::string& root, const std::string& audit_root) {
+	bool okay = this->decimated.open(root) && this->audit.open(audit_root);
+
+	if (okay) {
+		for (auto it = this->decimators.begin(); it != this->decimators.end(); it++) {
+			it->reset();
+		}
+	} else {
+		this->close();
+	}
+
+	return okay;
+}
+
+bool TrackIngest::flush() {
+	bool okay = this->decimated.flush();
+
+	return this->audit.flush() && okay;
+}
+
+void TrackIngest::close() {
+	this->decimated.close();
+	this->audit.close();
+}
+
+bool TrackIngest::ingest(size_t stream, int64_t timepoint, double x, double y, double depth) {
+	bool okay = (stream < this->decimators.size()) && this->audit.append(stream, timepoint, x, y, depth);
+
+	if (okay && this->decimators[stream].admit(timepoint, x, y, depth)) {
+		okay = this->decimated.append(stream, timepoint, x, y, depth);
+	}
+
+	return okay;
+}
+
+void TrackIngest::break_track(size_t stream) {
+	if (stream < this->decimators.size()) {
+		this->decimators[stream].reset();
+	}
+}
+
+void TrackIngest::set_subinterval(double subinterval) {
+	for (auto it = this->decimators.begin(); it != this->decimators.end(); it++) {
+		it->set_subinterval(subinterval);
+	}
+}
+
+/*************************************************************************************************/
+DredgeTrackStore* TrackIngest::store() {
+	return &this->decimated;
+}
+
+DredgeTrackStore* TrackIngest::audit_store() {
+	return &this->audit;
+}
+
+TrackDecimator* TrackIngest::decimator(size_t stream) {
+	return ((stream < this->decimators.size()) ? &this->decimators[stream] : nullptr);
+}
+
+/*************************************************************************************************/
+#ifdef TRACK_INGEST_MAIN
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+
+namespace {
+	size_t file_size(const std::string& path) {
+		struct stat info;
+
+		return ((stat(path.c_str(), &info) == 0) ? size_t(info.st_size) : 0U);
+	}
+
+	/**
+	 * stands for a redraw, queries the day and projects every point onto the screen as `DredgeTracklet` does.
+	 */
+	double redraw(DredgeTrackStore* store, size_t stream_count, int64_t begin, int64_t end, size_t* points, double* checksum) {
+		auto t0 = std::chrono::steady_clock::now();
+
+		(*points) = 0;
+
+		for (size_t s = 0; s < stream_count; s++) {
+			TrackColumns columns;
+			size_t n = store->query(s, begin, end, &columns);
+
+			for (size_t idx = 0; idx < n; idx++) {
+				(*checksum) += (columns.xs[idx] * 0.5 + 100.0) + (columns.ys[idx] * 0.5 + 100.0) * 1e-6;
+			}
+
+			(*points) += n;
+		}
+
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+	}
+}
+
+/**
+ * A day of 1Hz samples of both drag heads, the dredger sails at 1.5m/s while dredging and stands still for 2 hours,
+ *   decimated with `subinterval` meters (5 by default).
+ */
+int main(int argc, char* argv[]) {
+	double subinterval = ((argc > 1) ? strtod(argv[1], nullptr) : 5.0);
+	std::string root = ((argc > 2) ? argv[2] : "/tmp");
+	const size_t stream_count = 2;
+	const int64_t t0 = 1600000000;
+	const int64_t seconds = 86400;
+	std::string audit_root = root + "/audit";
+	std::mt19937_64 prng(0);
+	std::normal_distribution<double> noise(0.0, 0.02);
+	size_t raw_points = 0, kept_points = 0;
+	double raw_ms = 0.0, kept_ms = 0.0;
+	double sink = 0.0;
+
+	mkdir(audit_root.c_str(), 0755);
+
+	{
+		TrackIngest ingest(stream_count, subinterval);
+
+		if (!ingest.open(root, audit_root)) {
+			fprintf(stderr, "failed to open stores in %s\n", root.c_str());
+			return 1;
+		}
+
+		for (int64_t t = 0; t < seconds; t++) {
+			bool standing = ((t / 3600) % 12) == 5;
+			double along = (standing ? 0.0 : double(t % 1333) * 1.5);
+
+			for (size_t s = 0; s < stream_count; s++) {
+				double depth = (standing ? 2.0 : 14.0 + 0.3 * sin(double(t) * 0.01)) + noise(prng);
+
+				ingest.ingest(s, t0 + t, along, ((s == 0) ? -8.0 : 8.0) + double((t / 1333) % 20) * 10.0, depth);
+			}
+		}
+
+		ingest.flush();
+		printf("%zu samples of %zu streams, %.1f m subinterval: %zu kept (%.1f%%)\n",
+			ingest.decimator(0)->received() * stream_count, stream_count, subinterval,
+			(ingest.decimator(0)->admitted() + ingest.decimator(1)->admitted()),
+			double(ingest.decimator(0)->admitted() + ingest.decimator(1)->admitted()) * 100.0 / double(ingest.decimator(0)->received() * stream_count));
+
+		for (size_t r = 0; r < 10; r++) {
+			raw_ms += redraw(ingest.audit_store(), stream_count, t0, t0 + seconds, &raw_points, &sink) * 0.1;
+			kept_ms += redraw(ingest.store(), stream_count, t0, t0 + seconds, &kept_points, &sink) * 0.1;
+		}
+	}
+
+	{
+		size_t raw_bytes = 0, kept_bytes = 0;
+
+		for (size_t s = 0; s < stream_count; s++) {
+			std::string name = "/track" + std::to_string(s) + ".dtk";
+
+			raw_bytes += file_size(audit_root + name);
+			kept_bytes += file_size(root + name);
+			remove((audit_root + name).c_str());
+			remove((root + name).c_str());
+		}
+
+		remove(audit_root.c_str());
+
+		printf("  storage: %8zu -> %8zu bytes (the audit store keeps the former)\n", raw_bytes, kept_bytes);
+		printf("  memory:  %8zu -> %8zu bytes of a redrawn day\n", raw_points * 32U, kept_points * 32U);
+		printf("  redraw:  %8.2f -> %8.2f ms (checksum %g)\n", raw_ms, kept_ms, sink);
+	}
+
+	return 0;
+}
+#endif
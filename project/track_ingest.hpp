@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "project/track_store.hpp"
+
+namespace WarGrey::DTPM {
+	/**
+	 * Decides which samples of one stream are worth keeping,
+	 *   a sample is kept once it is `subinterval` meters away from the last kept one (`DredgeTrack::subinterval`),
+	 *   or once the drag head has moved `depth_tolerance` meters vertically (0 to ignore depths),
+	 *   or once `max_period` has passed since the last kept one, so that a dredger standing still is still recorded.
+	 */
+	class TrackDecimator {
+	public:
+		TrackDecimator(double subinterval = 0.0, int64_t max_period = 60, double depth_tolerance = 0.1);
+
+	public:
+		bool admit(int64_t timepoint, double x, double y, double depth);
+		void set_subinterval(double subinterval); // measured from the last kept sample, which stays as it is
+		void reset();
+
+	public:
+		size_t received();
+		size_t admitted();
+
+	private:
+		double subinterval;
+		int64_t max_period;
+		double depth_tolerance;
+
+	private:
+		bool fresh;
+		int64_t last_timepoint;
+		double last_x;
+		double last_y;
+		double last_depth;
+		size_t in;
+		size_t out;
+	};
+
+	/**
+	 * Ingests drag-head/GPS samples, every sample goes into the audit store as it is received,
+	 *   only samples admitted by the `TrackDecimator` of the stream go into the store that is drawn.
+	 */
+	class TrackIngest {
+	public:
+		virtual ~TrackIngest() noexcept;
+		TrackIngest(size_t stream_count, double subinterval, int64_t max_period = 60, double depth_tolerance = 0.1);
+
+	public:
+		bool open(const std::string& root, const std::string& audit_root);
+		bool flush();
+		void close();
+
+	public:
+		bool ingest(size_t stream, int64_t timepoint, double x, double y, double depth);
+		void break_track(size_t stream); // the next sample is kept whatever it is
+		void set_subinterval(double subinterval); // of all streams, once `DredgeTrack::subinterval` is applied
+
+	public:
+		WarGrey::DTPM::DredgeTrackStore* store();
+		WarGrey::DTPM::DredgeTrackStore* audit_store();
+		WarGrey::DTPM::TrackDecimator* decimator(size_t stream);
+
+	private:
+		WarGrey::DTPM::DredgeTrackStore decimated;
+		WarGrey::DTPM::DredgeTrackStore audit;
+		std::vector<WarGrey::DTPM::TrackDecimator> decimators;
+	};
+}
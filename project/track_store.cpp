@@ -0,0 +1,489 @@
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <filesystem>
+
+#include "project/track_store.hpp"
+#include "project/track_wal.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace WarGrey::DTPM;
+
+static const uint32_t track_chunk_magic = 0x43525444U; // "DTRC"
+static const uint32_t track_chunk_legacy_magic = 0x4B525444U; // "DTRK", chunks without version and checksum
+static const uint32_t track_chunk_version = 1U;
+
+/*************************************************************************************************/
+namespace {
+	static inline int file_seek(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+		return _fseeki64(file, int64_t(offset), SEEK_SET);
+#else
+		return fseeko(file, off_t(offset), SEEK_SET);
+#endif
+	}
+
+	static inline bool file_sync(FILE* file) {
+		bool okay = (fflush(file) == 0);
+
+#ifdef _WIN32
+		return okay && (_commit(_fileno(file)) == 0);
+#else
+		return okay && (fsync(fileno(file)) == 0);
+#endif
+	}
+
+	static inline int64_t partition_of(int64_t timepoint, int64_t span) {
+		int64_t p = timepoint / span;
+
+		return (((timepoint % span) < 0) ? (p - 1) : p);
+	}
+
+	static inline size_t chunk_body_size(size_t count) {
+		return count * (sizeof(int64_t) + sizeof(double) * 3);
+	}
+
+	static inline uint32_t chunk_header_crc(uint32_t count, int64_t min_timepoint, int64_t max_timepoint) {
+		TrackChunkHeader header;
+
+		memset(&header, 0, sizeof(TrackChunkHeader));
+		header.magic = track_chunk_magic;
+		header.version = track_chunk_version;
+		header.count = count;
+		header.min_timepoint = min_timepoint;
+		header.max_timepoint = max_timepoint;
+
+		return track_wal_crc(&header, offsetof(TrackChunkHeader, crc));
+	}
+
+	static void columns_append(TrackColumns* dest, const int64_t* ts, const double* xs, const double* ys, const double* ds
+		, size_t count, int64_t begin, int64_t end, size_t* appended) {
+		if ((count > 0) && (*std::min_element(ts, ts + count) >= begin) && (*std::max_element(ts, ts + count) <= end)) {
+			// the whole chunk is inside the window, columns are copied as they are
+			dest->timepoints.insert(dest->timepoints.end(), ts, ts + count);
+			dest->xs.insert(dest->xs.end(), xs, xs + count);
+			dest->ys.insert(dest->ys.end(), ys, ys + count);
+			dest->depths.insert(dest->depths.end(), ds, ds + count);
+			(*appended) += count;
+		} else {
+			for (size_t idx = 0; idx < count; idx++) {
+				if ((ts[idx] >= begin) && (ts[idx] <= end)) {
+					dest->timepoints.push_back(ts[idx]);
+					dest->xs.push_back(xs[idx]);
+					dest->ys.push_back(ys[idx]);
+					dest->depths.push_back(ds[idx]);
+					(*appended)++;
+				}
+			}
+		}
+	}
+}
+
+/*************************************************************************************************/
+DredgeTrackStore::DredgeTrackStore(size_t stream_count, size_t chunk_capacity, int64_t partition_span)
+	: streams(stream_count), chunk_capacity(std::max<size_t>(chunk_capacity, 1U))
+	, partition_span((partition_span > 0) ? partition_span : 1), reads(0), drops(0) {
+	for (auto it = this->streams.begin(); it != this->streams.end(); it++) {
+		it->file = nullptr;
+		it->tail = 0U;
+	}
+}
+
+DredgeTrackStore::~DredgeTrackStore() {
+	this->close();
+}
+
+bool DredgeTrackStore::open(const std::string& root) {
+	bool okay = true;
+
+	this->close();
+
+	for (size_t idx = 0; okay && (idx < this->streams.size()); idx++) {
+		Stream* s = &this->streams[idx];
+		std::string path = root + "/track" + std::to_string(idx) + ".dtk";
+		TrackChunkHeader header;
+		std::error_code ec;
+
+		s->file = fopen(path.c_str(), "r+b");
+
+		if (s->file == nullptr) {
+			s->file = fopen(path.c_str(), "w+b");
+		}
+
+		okay = (s->file != nullptr);
+
+		// only headers are read, bodies are skipped over
+		while (okay && (file_seek(s->file, s->tail) == 0) && (fread(&header, sizeof(TrackChunkHeader), 1, s->file) == 1)) {
+			uint64_t next = s->tail + sizeof(TrackChunkHeader) + chunk_body_size(header.count);
+			bool complete = (header.magic == track_chunk_magic) && (header.version == track_chunk_version) && (header.count > 0U)
+				&& (file_seek(s->file, next - 1U) == 0) && (fgetc(s->file) != EOF);
+
+			if (!complete) {
+				// files of other versions are neither read nor truncated
+				okay = (s->tail > 0U) || ((header.magic != track_chunk_legacy_magic)
+					&& ((header.magic != track_chunk_magic) || (header.version == track_chunk_version)));
+				break;
+			}
+
+			s->index.push_back({ header.min_timepoint, header.max_timepoint, s->tail, header.count, header.crc });
+			s->tail = next;
+		}
+
+		// the body of a torn chunk may exist but hold whatever the disk had there, appending goes on over it
+		if (okay && (!s->index.empty()) && (this->read_chunk(idx, s->index.back()) == nullptr)) {
+			s->tail = s->index.back().offset;
+			s->index.pop_back();
+		}
+
+		if (okay) {
+			uintmax_t size = std::filesystem::file_size(path, ec);
+
+			// otherwise, the torn bytes would stay behind shorter chunks sealed over them
+			if ((!ec) && (size > s->tail)) {
+				std::filesystem::resize_file(path, s->tail, ec);
+				okay = (!ec) && file_sync(s->file);
+			}
+		}
+	}
+
+	if (!okay) {
+		this->close();
+	}
+
+	this->reads = 0;
+
+	return okay;
+}
+
+bool DredgeTrackStore::flush() {
+	bool okay = true;
+
+	for (size_t idx = 0; idx < this->streams.size(); idx++) {
+		okay = this->seal(idx) && okay;
+
+		if (this->streams[idx].file != nullptr) {
+			okay = file_sync(this->streams[idx].file) && okay;
+		}
+	}
+
+	return okay;
+}
+
+void DredgeTrackStore::close() {
+	this->flush();
+
+	for (auto it = this->streams.begin(); it != this->streams.end(); it++) {
+		if (it->file != nullptr) {
+			fclose(it->file);
+			it->file = nullptr;
+		}
+
+		it->tail = 0U;
+		it->index.clear();
+		it->unsealed = TrackColumns();
+	}
+
+	this->reads = 0;
+	this->drops = 0;
+}
+
+/*************************************************************************************************/
+bool DredgeTrackStore::append(size_t stream, int64_t timepoint, double x, double y, double depth) {
+	bool okay = (stream < this->streams.size()) && (this->streams[stream].file != nullptr);
+
+	if (okay) {
+		TrackColumns* unsealed = &this->streams[stream].unsealed;
+
+		if (!unsealed->timepoints.empty()) {
+			int64_t partition = partition_of(unsealed->timepoints.front(), this->partition_span);
+
+			if ((unsealed->timepoints.size() >= this->chunk_capacity) || (partition_of(timepoint, this->partition_span) != partition)) {
+				okay = this->seal(stream);
+			}
+		}
+
+		if (okay) {
+			unsealed->timepoints.push_back(timepoint);
+			unsealed->xs.push_back(x);
+			unsealed->ys.push_back(y);
+			unsealed->depths.push_back(depth);
+		}
+	}
+
+	return okay;
+}
+
+size_t DredgeTrackStore::query(size_t stream, int64_t begin, int64_t end, TrackColumns* result) {
+	size_t appended = 0;
+
+	if ((stream < this->streams.size()) && (begin <= end)) {
+		Stream* s = &this->streams[stream];
+
+		for (auto it = s->index.begin(); it != s->index.end(); ) {
+			size_t drops = this->drops;
+
+			if ((it->max_timepoint >= begin) && (it->min_timepoint <= end)) {
+				const uint8_t* body = this->read_chunk(stream, (*it));
+
+				if (body != nullptr) {
+					const int64_t* ts = reinterpret_cast<const int64_t*>(body);
+					const double* xs = reinterpret_cast<const double*>(ts + it->count);
+
+					columns_append(result, ts, xs, xs + it->count, xs + it->count * 2, it->count, begin, end, &appended);
+				}
+			}
+
+			if (this->drops > drops) {
+				it = s->index.erase(it);
+			} else {
+				it++;
+			}
+		}
+
+		columns_append(result, s->unsealed.timepoints.data(), s->unsealed.xs.data(), s->unsealed.ys.data(), s->unsealed.depths.data(),
+			s->unsealed.timepoints.size(), begin, end, &appended);
+	}
+
+	return appended;
+}
+
+/*************************************************************************************************/
+size_t DredgeTrackStore::chunk_count(size_t stream) {
+	return ((stream < this->streams.size()) ? this->streams[stream].index.size() : 0U);
+}
+
+size_t DredgeTrackStore::chunks_read() {
+	return this->reads;
+}
+
+size_t DredgeTrackStore::chunks_dropped() {
+	return this->drops;
+}
+
+/*************************************************************************************************/
+bool DredgeTrackStore::seal(size_t stream) {
+	Stream* s = &this->streams[stream];
+	size_t count = s->unsealed.timepoints.size();
+	bool okay = true;
+
+	if ((count > 0) && (s->file != nullptr)) {
+		TrackChunkHeader header;
+
+		header.magic = track_chunk_magic;
+		header.version = track_chunk_version;
+		header.count = uint32_t(count);
+		header.min_timepoint = *std::min_element(s->unsealed.timepoints.begin(), s->unsealed.timepoints.end());
+		header.max_timepoint = *std::max_element(s->unsealed.timepoints.begin(), s->unsealed.timepoints.end());
+		header.crc = chunk_header_crc(header.count, header.min_timepoint, header.max_timepoint);
+		header.crc = track_wal_crc(s->unsealed.timepoints.data(), sizeof(int64_t) * count, header.crc);
+		header.crc = track_wal_crc(s->unsealed.xs.data(), sizeof(double) * count, header.crc);
+		header.crc = track_wal_crc(s->unsealed.ys.data(), sizeof(double) * count, header.crc);
+		header.crc = track_wal_crc(s->unsealed.depths.data(), sizeof(double) * count, header.crc);
+
+		okay = (file_seek(s->file, s->tail) == 0)
+			&& (fwrite(&header, sizeof(TrackChunkHeader), 1, s->file) == 1)
+			&& (fwrite(s->unsealed.timepoints.data(), sizeof(int64_t), count, s->file) == count)
+			&& (fwrite(s->unsealed.xs.data(), sizeof(double), count, s->file) == count)
+			&& (fwrite(s->unsealed.ys.data(), sizeof(double), count, s->file) == count)
+			&& (fwrite(s->unsealed.depths.data(), sizeof(double), count, s->file) == count);
+
+		if (okay) {
+			s->index.push_back({ header.min_timepoint, header.max_timepoint, s->tail, header.count, header.crc });
+			s->tail += sizeof(TrackChunkHeader) + chunk_body_size(count);
+			s->unsealed.timepoints.clear();
+			s->unsealed.xs.clear();
+			s->unsealed.ys.clear();
+			s->unsealed.depths.clear();
+		}
+	}
+
+	return okay;
+}
+
+const uint8_t* DredgeTrackStore::read_chunk(size_t stream, const TrackChunkIndex& chunk) {
+	FILE* file = this->streams[stream].file;
+	size_t size = chunk_body_size(chunk.count);
+	const uint8_t* body = nullptr;
+
+	if (this->buffer.size() < size) {
+		this->buffer.resize(size);
+	}
+
+	if ((file_seek(file, chunk.offset + sizeof(TrackChunkHeader)) == 0) && (fread(this->buffer.data(), 1, size, file) == size)) {
+		uint32_t crc = chunk_header_crc(chunk.count, chunk.min_timepoint, chunk.max_timepoint);
+
+		this->reads++;
+
+		if (track_wal_crc(this->buffer.data(), size, crc) == chunk.crc) {
+			body = this->buffer.data();
+		} else {
+			this->drops++;
+		}
+	}
+
+	return body;
+}
+
+/*************************************************************************************************/
+#ifdef TRACK_STORE_MAIN
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+/**
+ * `days` of 1Hz history of the two drag heads, written, reopened,
+ *   then queried with windows of an hour, a day and a week (no longer than half the history) at the middle of the history;
+ *   at last, checks that corrupted chunks are dropped, torn bytes are truncated, and files of other versions are rejected.
+ */
+int main(int argc, char* argv[]) {
+	size_t days = std::max<size_t>(((argc > 1) ? strtoul(argv[1], nullptr, 10) : 21U), 1U);
+	std::string root = ((argc > 2) ? argv[2] : "/tmp");
+	const size_t stream_count = 2; // PSDrag, SBDrag
+	const int64_t t0 = 1600000000;
+	int64_t seconds = int64_t(days) * 86400;
+
+	{
+		DredgeTrackStore store(stream_count);
+		auto w0 = std::chrono::steady_clock::now();
+
+		store.open(root);
+
+		for (int64_t t = 0; t < seconds; t++) {
+			for (size_t s = 0; s < stream_count; s++) {
+				double side = ((s == 0) ? -8.0 : 8.0);
+
+				store.append(s, t0 + t, double(t % 2000), side + 500.0 * double((t / 2000) % 10), 14.0 + sin(double(t) * 0.001));
+			}
+		}
+
+		store.close();
+		printf("%zu days x %zu streams, written in %.1f ms\n", days, stream_count,
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - w0).count());
+	}
+
+	{
+		DredgeTrackStore store(stream_count);
+		auto o0 = std::chrono::steady_clock::now();
+		bool okay = store.open(root);
+		auto o1 = std::chrono::steady_clock::now();
+		int64_t windows[] = { 3600, 86400, 7 * 86400 };
+
+		if (!okay) {
+			fprintf(stderr, "failed to reopen the store\n");
+			return 1;
+		}
+
+		printf("  reopened in %.2f ms, %zu chunks per stream\n", std::chrono::duration<double, std::milli>(o1 - o0).count(), store.chunk_count(0));
+
+		for (size_t w = 0; w < sizeof(windows) / sizeof(int64_t); w++) {
+			int64_t window = std::min(windows[w], seconds / 2);
+			int64_t begin = t0 + (seconds - window) / 2 + 1800;
+			int64_t end = begin + window - 1;
+			size_t reads = store.chunks_read();
+			TrackColumns columns;
+			size_t n = 0;
+
+			auto q0 = std::chrono::steady_clock::now();
+			for (size_t s = 0; s < stream_count; s++) {
+				n += store.query(s, begin, end, &columns);
+			}
+			auto q1 = std::chrono::steady_clock::now();
+
+			if ((n != size_t(window) * stream_count) || (columns.timepoints.front() != begin)) {
+				fprintf(stderr, "wrong window: %zu points\n", n);
+				return 1;
+			}
+
+			printf("  %7lld s window: %8zu points, %4zu chunks read, %8.2f ms\n", (long long)(window), n,
+				store.chunks_read() - reads, std::chrono::duration<double, std::milli>(q1 - q0).count());
+		}
+	}
+
+	{ // flips a byte in the body of a chunk in the middle of stream 0, which should be dropped rather than returned
+		DredgeTrackStore store(stream_count);
+		FILE* file = nullptr;
+		size_t chunks = 0;
+		bool okay = store.open(root);
+
+		if (okay) {
+			chunks = store.chunk_count(0);
+			store.close();
+			file = fopen((root + "/track0.dtk").c_str(), "r+b");
+			okay = (file != nullptr);
+		}
+
+		if (okay) {
+			int c = 0;
+
+			okay = (fseek(file, 0, SEEK_SET) == 0);
+
+			for (size_t idx = 0; okay && (idx < chunks / 2); idx++) {
+				TrackChunkHeader header;
+
+				okay = (fread(&header, sizeof(TrackChunkHeader), 1, file) == 1)
+					&& (fseek(file, long(chunk_body_size(header.count)), SEEK_CUR) == 0);
+			}
+
+			okay = okay && (fseek(file, long(sizeof(TrackChunkHeader)) + 17L, SEEK_CUR) == 0) && ((c = fgetc(file)) != EOF)
+				&& (fseek(file, -1L, SEEK_CUR) == 0) && (fputc(c ^ 0x5A, file) != EOF);
+			fclose(file);
+		}
+
+		if (okay) {
+			TrackColumns columns;
+			size_t n = 0;
+
+			okay = store.open(root) && (store.chunk_count(0) == chunks);
+			n = store.query(0, t0, t0 + seconds - 1, &columns);
+			okay = okay && (store.chunks_dropped() == 1U) && (store.chunk_count(0) == chunks - 1U)
+				&& (n < size_t(seconds)) && (n == store.query(0, t0, t0 + seconds - 1, &columns))
+				&& (store.chunks_dropped() == 1U);
+		}
+
+		printf("  corrupted chunk: %s\n", (okay ? "dropped" : "NOT dropped"));
+
+		if (!okay) {
+			return 1;
+		}
+	}
+
+	{ // a torn header at the tail of stream 1 is truncated, then a chunk of another version makes opening fail and is left untouched
+		std::string path = root + "/track1.dtk";
+		DredgeTrackStore store(stream_count);
+		uintmax_t size = std::filesystem::file_size(path);
+		FILE* file = fopen(path.c_str(), "ab");
+		size_t chunks = 0;
+		bool okay = (file != nullptr) && (fwrite(&track_chunk_magic, sizeof(uint32_t), 1, file) == 1) && (fclose(file) == 0);
+
+		okay = okay && store.open(root) && (std::filesystem::file_size(path) == size);
+		chunks = store.chunk_count(1);
+		store.close();
+
+		if (okay) {
+			uint32_t version = track_chunk_version + 1U;
+
+			file = fopen(path.c_str(), "r+b");
+			okay = (file != nullptr) && (fseek(file, long(offsetof(TrackChunkHeader, version)), SEEK_SET) == 0)
+				&& (fwrite(&version, sizeof(uint32_t), 1, file) == 1) && (fclose(file) == 0);
+			okay = okay && (!store.open(root)) && (std::filesystem::file_size(path) == size);
+		}
+
+		printf("  torn tail and other versions: %s (%zu chunks kept)\n", (okay ? "okay" : "NOT okay"), chunks);
+
+		if (!okay) {
+			return 1;
+		}
+	}
+
+	for (size_t s = 0; s < stream_count; s++) {
+		remove((root + "/track" + std::to_string(s) + ".dtk").c_str());
+	}
+
+	return 0;
+}
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+namespace WarGrey::DTPM {
+	/**
+	 * A chunk on disk is this header followed by its columns, `count` timepoints, then `count` xs, ys and depths,
+	 *   `crc` is the CRC-32C (`track_wal_crc()`) of the fields before it and then the columns.
+	 */
+	struct TrackChunkHeader {
+		uint32_t magic;
+		uint32_t version;
+		int64_t min_timepoint;
+		int64_t max_timepoint;
+		uint32_t count;
+		uint32_t crc;
+	};
+
+	struct TrackChunkIndex {
+		int64_t min_timepoint;
+		int64_t max_timepoint;
+		uint64_t offset;
+		uint32_t count;
+		uint32_t crc;
+	};
+
+	struct TrackColumns {
+		std::vector<int64_t> timepoints;
+		std::vector<double> xs;
+		std::vector<double> ys;
+		std::vector<double> depths;
+	};
+
+	/**
+	 * Dredge track history, one stream per `DredgeTrackType` (`stream_count` is `_I(DredgeTrackType::_)`),
+	 *   each stream is an append-only file of columnar chunks in `root`.
+	 *
+	 * A chunk is sealed once it holds `chunk_capacity` points, or once a point falls into the next partition,
+	 *   partitions are `partition_span` long, in the same unit as `begin_timepoint` and `end_timepoint` of `DredgeTrack`.
+	 * The sparse index keeps the min/max timepoints of each chunk in memory, rebuilt from chunk headers on opening,
+	 *   so that a [begin, end] window reads only chunks that overlap it.
+	 *
+	 * Chunks that fail their CRC are dropped, the last one of each stream is checked on opening, since a torn chunk could only be there,
+	 *   and the file is truncated right after the last valid chunk; others are checked whenever they are read,
+	 *   rather than reading the whole history on opening.
+	 * Files of other versions, including those of checksum-less chunks, make `open()` fail, they are left as they are.
+	 */
+	class DredgeTrackStore {
+	public:
+		virtual ~DredgeTrackStore() noexcept;
+		DredgeTrackStore(size_t stream_count, size_t chunk_capacity = 3600, int64_t partition_span = 3600);
+
+	public:
+		bool open(const std::string& root);
+		bool flush(); // seals all unsealed chunks, and syncs files
+		void close();
+
+	public:
+		bool append(size_t stream, int64_t timepoint, double x, double y, double depth);
+
+		/**
+		 * appends points of `stream` in [`begin`, `end`] to `result`, in the order they were appended,
+		 *   returns the number of points appended, unsealed points are included.
+		 */
+		size_t query(size_t stream, int64_t begin, int64_t end, WarGrey::DTPM::TrackColumns* result);
+
+	public:
+		size_t chunk_count(size_t stream);
+		size_t chunks_read(); // chunks read from files since opened
+		size_t chunks_dropped(); // chunks failing the CRC since opened
+
+	private:
+		bool seal(size_t stream);
+		const uint8_t* read_chunk(size_t stream, const WarGrey::DTPM::TrackChunkIndex& chunk);
+
+	private:
+		struct Stream {
+			FILE* file;
+			uint64_t tail;
+			std::vector<WarGrey::DTPM::TrackChunkIndex> index;
+			WarGrey::DTPM::TrackColumns unsealed;
+		};
+
+	private:
+		std::vector<Stream> streams;
+		size_t chunk_capacity;
+		int64_t partition_span;
+		size_t reads;
+		size_t drops;
+
+	private:
+		std::vector<uint8_t> buffer;
+	};
+}
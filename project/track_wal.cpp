@@ -0,0 +1,547 @@
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#include "project/track_wal.hpp"
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace WarGrey::DTPM;
+
+static const uint32_t track_wal_magic = 0x4C415744U; // "DWAL"
+static const uint32_t track_wal_version = 1U;
+
+/*************************************************************************************************/
+namespace {
+	// tables of slicing-by-8, validating the tail segment is most of the recovery
+	static const uint32_t (*crc32c_tables())[256] {
+		static uint32_t tables[8][256];
+		static bool ready = false;
+
+		if (!ready) {
+			for (uint32_t idx = 0; idx < 256; idx++) {
+				uint32_t c = idx;
+
+				for (int bit = 0; bit < 8; bit++) {
+					c = ((c & 1U) ? ((c >> 1) ^ 0x82F63B78U) : (c >> 1));
+				}
+
+				tables[0][idx] = c;
+			}
+
+			for (uint32_t idx = 0; idx < 256; idx++) {
+				for (size_t t = 1; t < 8; t++) {
+					tables[t][idx] = (tables[t - 1][idx] >> 8) ^ tables[0][tables[t - 1][idx] & 0xFFU];
+				}
+			}
+
+			ready = true;
+		}
+
+		return tables;
+	}
+
+	static inline bool file_sync(FILE* file) {
+		bool okay = (fflush(file) == 0);
+
+#ifdef _WIN32
+		return okay && (_commit(_fileno(file)) == 0);
+#else
+		return okay && (fsync(fileno(file)) == 0);
+#endif
+	}
+
+	static inline bool record_valid(const TrackWALRecord& record, uint64_t lsn) {
+		return (record.lsn == lsn) && (record.crc == track_wal_crc(&record.stream, sizeof(TrackWALRecord) - sizeof(uint32_t)));
+	}
+}
+
+uint32_t WarGrey::DTPM::track_wal_crc(const void* src, size_t size, uint32_t prefix_crc) {
+	static const uint32_t (*t)[256] = crc32c_tables();
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(src);
+	uint32_t crc = prefix_crc ^ 0xFFFFFFFFU;
+	size_t idx = 0;
+
+	for (; idx + 8 <= size; idx += 8) {
+		uint32_t lo = crc ^ (uint32_t(bytes[idx]) | (uint32_t(bytes[idx + 1]) << 8) | (uint32_t(bytes[idx + 2]) << 16) | (uint32_t(bytes[idx + 3]) << 24));
+		uint32_t hi = (uint32_t(bytes[idx + 4]) | (uint32_t(bytes[idx + 5]) << 8) | (uint32_t(bytes[idx + 6]) << 16) | (uint32_t(bytes[idx + 7]) << 24));
+
+		crc = t[7][lo & 0xFFU] ^ t[6][(lo >> 8) & 0xFFU] ^ t[5][(lo >> 16) & 0xFFU] ^ t[4][lo >> 24]
+			^ t[3][hi & 0xFFU] ^ t[2][(hi >> 8) & 0xFFU] ^ t[1][(hi >> 16) & 0xFFU] ^ t[0][hi >> 24];
+	}
+
+	for (; idx < size; idx++) {
+		crc = t[0][(crc ^ bytes[idx]) & 0xFFU] ^ (crc >> 8);
+	}
+
+	return crc ^ 0xFFFFFFFFU;
+}
+
+/*************************************************************************************************/
+TrackWAL::TrackWAL(size_t segment_bytes, size_t group_bytes, uint32_t group_period_ms)
+	: tail(nullptr), tail_bytes(0), lsn(0), durable(0), buffered(0), group_period(group_period_ms)
+	, view(nullptr), extent(0), recovered(0), torn(0), sync_count(0) {
+	this->segment_bytes = std::max(segment_bytes, sizeof(TrackWALSegmentHeader) + sizeof(TrackWALRecord));
+	this->group_bytes = std::max(group_bytes, sizeof(TrackWALRecord));
+	this->group_bytes -= this->group_bytes % sizeof(TrackWALRecord);
+	this->buffer = new uint8_t[this->group_bytes];
+}
+
+TrackWAL::~TrackWAL() {
+	this->close();
+
+	delete[] this->buffer;
+}
+
+bool TrackWAL::open(const std::string& root) {
+	std::error_code ec;
+	bool foreign = false;
+	bool okay = true;
+
+	this->close();
+	this->root = root;
+
+	for (auto it = std::filesystem::directory_iterator(root, ec); (!ec) && (it != std::filesystem::directory_iterator()); it.increment(ec)) {
+		std::string name = it->path().filename().string();
+
+		if ((name.size() > 8) && (name.compare(0, 4, "wal-") == 0) && (name.compare(name.size() - 4, 4, ".log") == 0)) {
+			FILE* src = fopen(it->path().string().c_str(), "rb");
+			TrackWALSegmentHeader header;
+
+			if (src != nullptr) {
+				if ((fread(&header, sizeof(TrackWALSegmentHeader), 1, src) == 1) && (header.magic == track_wal_magic)) {
+					this->segments.push_back({ strtoull(name.c_str() + 4, nullptr, 10), header.first_lsn });
+					foreign = (foreign || (header.version != track_wal_version));
+				} else {
+					this->segments.push_back({ strtoull(name.c_str() + 4, nullptr, 10), UINT64_MAX });
+				}
+
+				fclose(src);
+			}
+		}
+	}
+
+	std::sort(this->segments.begin(), this->segments.end(),
+		[](const Segment& lhs, const Segment& rhs) { return lhs.sequence < rhs.sequence; });
+
+	// records of other versions are neither replayed nor overwritten, the log is left as it is
+	okay = !foreign;
+
+	if (okay) {
+		bool removed = false;
+
+		// a segment torn before its header is flushed holds nothing
+		while ((!this->segments.empty()) && (this->segments.back().first_lsn == UINT64_MAX)) {
+			std::filesystem::remove(this->segment_path(this->segments.back().sequence), ec);
+			this->segments.pop_back();
+			removed = true;
+		}
+
+		if (removed) {
+			okay = mapped_file_sync_directory(this->root);
+		}
+	}
+
+	if (okay) {
+		if (this->segments.empty()) {
+			okay = this->roll();
+		} else {
+			const Segment& last = this->segments.back();
+			std::string path = this->segment_path(last.sequence);
+			uint64_t next = last.first_lsn;
+			size_t valid_bytes = sizeof(TrackWALSegmentHeader);
+
+			okay = this->recover(last, &next, &valid_bytes);
+
+			if (okay) {
+				uintmax_t size = std::filesystem::file_size(path, ec);
+
+				if ((!ec) && (size > valid_bytes)) {
+					this->torn = size_t(size - valid_bytes);
+					std::filesystem::resize_file(path, valid_bytes, ec);
+				}
+
+				this->tail = fopen(path.c_str(), "r+b");
+				okay = (!ec) && (this->tail != nullptr) && (fseek(this->tail, long(valid_bytes), SEEK_SET) == 0);
+
+				if (okay && (this->torn > 0)) { // otherwise, the torn bytes would come back after another power loss
+					okay = file_sync(this->tail) && mapped_file_sync_directory(this->root);
+				}
+
+				this->tail_bytes = valid_bytes;
+				this->lsn = next;
+				this->durable = next;
+			}
+		}
+	}
+
+	if (!okay) {
+		this->close();
+	}
+
+	this->last_commit = std::chrono::steady_clock::now();
+
+	return okay;
+}
+
+bool TrackWAL::commit() {
+	bool okay = (this->tail != nullptr);
+
+	if (okay && (this->buffered > 0)) {
+		okay = (fwrite(this->buffer, 1, this->buffered, this->tail) == this->buffered) && file_sync(this->tail);
+
+		if (okay) {
+			this->tail_bytes += this->buffered;
+			this->durable = this->lsn;
+			this->buffered = 0;
+			this->sync_count++;
+		}
+	}
+
+	this->last_commit = std::chrono::steady_clock::now();
+
+	return okay;
+}
+
+void TrackWAL::close() {
+	if (this->tail != nullptr) {
+		this->commit();
+		fclose(this->tail);
+		this->tail = nullptr;
+	}
+
+	this->unmap_segment();
+	this->segments.clear();
+	this->tail_bytes = 0;
+	this->buffered = 0;
+	this->lsn = 0;
+	this->durable = 0;
+	this->recovered = 0;
+	this->torn = 0;
+	this->sync_count = 0;
+}
+
+/*************************************************************************************************/
+bool TrackWAL::append(uint32_t stream, int64_t timepoint, double x, double y, double depth) {
+	bool okay = (this->tail != nullptr);
+
+	if (okay && (this->tail_bytes + this->buffered + sizeof(TrackWALRecord) > this->segment_bytes)) {
+		okay = this->commit() && this->roll();
+	}
+
+	if (okay) {
+		TrackWALRecord record;
+
+		record.stream = stream;
+		record.lsn = this->lsn;
+		record.timepoint = timepoint;
+		record.x = x;
+		record.y = y;
+		record.depth = depth;
+		record.crc = track_wal_crc(&record.stream, sizeof(TrackWALRecord) - sizeof(uint32_t));
+
+		memcpy(this->buffer + this->buffered, &record, sizeof(TrackWALRecord));
+		this->buffered += sizeof(TrackWALRecord);
+		this->lsn++;
+
+		if ((this->buffered >= this->group_bytes) || (std::chrono::steady_clock::now() - this->last_commit >= this->group_period)) {
+			okay = this->commit();
+		}
+	}
+
+	return okay;
+}
+
+bool TrackWAL::tick() {
+	bool okay = true;
+
+	if ((this->buffered > 0) && (std::chrono::steady_clock::now() - this->last_commit >= this->group_period)) {
+		okay = this->commit();
+	}
+
+	return okay;
+}
+
+size_t TrackWAL::checkpoint(uint64_t lsn) {
+	std::error_code ec;
+	size_t n = 0;
+
+	// the last segment is never removed, it is where appending goes
+	while ((this->segments.size() > 1) && (this->segments[1].first_lsn <= lsn)) {
+		std::filesystem::remove(this->segment_path(this->segments.front().sequence), ec);
+		this->segments.erase(this->segments.begin());
+		n++;
+	}
+
+	if (n > 0) { // otherwise, removed segments might come back, and be replayed again after a power loss
+		mapped_file_sync_directory(this->root);
+	}
+
+	return n;
+}
+
+/*************************************************************************************************/
+uint64_t TrackWAL::next_lsn() {
+	return this->lsn;
+}
+
+uint64_t TrackWAL::durable_lsn() {
+	return this->durable;
+}
+
+size_t TrackWAL::segment_count() {
+	return this->segments.size();
+}
+
+size_t TrackWAL::recovered_records() {
+	return this->recovered;
+}
+
+size_t TrackWAL::torn_bytes() {
+	return this->torn;
+}
+
+size_t TrackWAL::syncs() {
+	return this->sync_count;
+}
+
+/*************************************************************************************************/
+std::string TrackWAL::segment_path(uint64_t sequence) {
+	return this->root + "/wal-" + std::to_string(sequence) + ".log";
+}
+
+bool TrackWAL::recover(const Segment& last, uint64_t* next, size_t* valid_bytes) {
+	size_t extent = 0;
+	void* view = mapped_file_open(this->segment_path(last.sequence), &extent);
+	bool okay = (view != nullptr);
+
+	if (okay) {
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(view);
+		size_t offset = sizeof(TrackWALSegmentHeader);
+		TrackWALRecord record;
+
+		while (offset + sizeof(TrackWALRecord) <= extent) {
+			memcpy(&record, base + offset, sizeof(TrackWALRecord));
+
+			if (!record_valid(record, (*next))) {
+				break;
+			}
+
+			offset += sizeof(TrackWALRecord);
+			(*next)++;
+		}
+
+		(*valid_bytes) = offset;
+		this->recovered = size_t((*next) - last.first_lsn);
+		mapped_file_close(view, extent);
+	}
+
+	return okay;
+}
+
+bool TrackWAL::roll() {
+	uint64_t sequence = (this->segments.empty() ? 0U : (this->segments.back().sequence + 1U));
+	std::string path = this->segment_path(sequence);
+	bool okay = true;
+
+	if (this->tail != nullptr) {
+		fclose(this->tail);
+	}
+
+	this->tail = fopen(path.c_str(), "w+b");
+
+	if (this->tail != nullptr) {
+		TrackWALSegmentHeader header;
+
+		header.magic = track_wal_magic;
+		header.version = track_wal_version;
+		header.first_lsn = this->lsn;
+
+		okay = (fwrite(&header, sizeof(TrackWALSegmentHeader), 1, this->tail) == 1) && file_sync(this->tail)
+			&& mapped_file_sync_directory(this->root); // otherwise, the segment might be lost along with its records
+
+		if (okay) {
+			this->segments.push_back({ sequence, this->lsn });
+			this->tail_bytes = sizeof(TrackWALSegmentHeader);
+		}
+	} else {
+		okay = false;
+	}
+
+	return okay;
+}
+
+const TrackWALRecord* TrackWAL::map_segment(size_t idx, size_t* count) {
+	const TrackWALRecord* records = nullptr;
+
+	this->unmap_segment();
+	this->view = mapped_file_open(this->segment_path(this->segments[idx].sequence), &this->extent);
+	(*count) = 0;
+
+	if ((this->view != nullptr) && (this->extent >= sizeof(TrackWALSegmentHeader))) {
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(this->view);
+		size_t bytes = this->extent - sizeof(TrackWALSegmentHeader);
+
+		// the tail segment may hold records being written, only what has been committed is visible
+		if (idx + 1 == this->segments.size()) {
+			bytes = std::min(bytes, this->tail_bytes - sizeof(TrackWALSegmentHeader));
+		}
+
+		records = reinterpret_cast<const TrackWALRecord*>(base + sizeof(TrackWALSegmentHeader));
+		(*count) = bytes / sizeof(TrackWALRecord);
+	}
+
+	return records;
+}
+
+void TrackWAL::unmap_segment() {
+	if (this->view != nullptr) {
+		mapped_file_close(this->view, this->extent);
+		this->view = nullptr;
+		this->extent = 0;
+	}
+}
+
+/*************************************************************************************************/
+#ifdef TRACK_WAL_MAIN
+#include <thread>
+#include <cstdlib>
+
+/**
+ * Appends `mb` megabytes (1GB by default, in whole segments) of samples of two drag heads as fast as possible with group commit,
+ *   compared with fsyncing every sample, then tears the tail as a power loss does, and recovers the log;
+ *   at last, checks `tick()` and the rejection of segments of other versions.
+ */
+int main(int argc, char* argv[]) {
+	size_t mb = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 1024U);
+	std::string root = ((argc > 2) ? argv[2] : "/tmp/track_wal");
+	size_t per_segment = (64U * 1024U * 1024U - sizeof(TrackWALSegmentHeader)) / sizeof(TrackWALRecord);
+	size_t count = std::max(mb * 1024U * 1024U / sizeof(TrackWALRecord) / per_segment, size_t(1U)) * per_segment; // the worst, a full tail
+	std::error_code ec;
+
+	std::filesystem::remove_all(root, ec);
+	std::filesystem::create_directories(root, ec);
+
+	{ // fsync per sample, the baseline
+		TrackWAL wal;
+		const size_t n = 1000;
+
+		wal.open(root);
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t idx = 0; idx < n; idx++) {
+			wal.append(uint32_t(idx % 2), int64_t(idx / 2), 0.0, 0.0, 14.0);
+			wal.commit();
+		}
+		auto t1 = std::chrono::steady_clock::now();
+
+		printf("fsync per sample: %8.0f records/s (%zu fsyncs)\n", double(n) / std::chrono::duration<double>(t1 - t0).count(), wal.syncs());
+		wal.close();
+		std::filesystem::remove_all(root, ec);
+		std::filesystem::create_directories(root, ec);
+	}
+
+	{
+		TrackWAL wal;
+
+		wal.open(root);
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t idx = 0; idx < count; idx++) {
+			wal.append(uint32_t(idx % 2), int64_t(idx / 2), double(idx % 2000), double(idx % 7), 14.0);
+		}
+		wal.commit();
+		auto t1 = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(t1 - t0).count();
+
+		printf("group commit:     %8.0f records/s, %.1f MB/s, %zu records in %zu segments (%zu fsyncs)\n",
+			double(count) / seconds, double(count * sizeof(TrackWALRecord)) / 1048576.0 / seconds,
+			count, wal.segment_count(), wal.syncs());
+
+		wal.close();
+	}
+
+	{ // the power is lost while a group is being written, half a record and a record of bad bytes
+		std::vector<std::filesystem::path> paths;
+		TrackWALRecord garbage;
+		FILE* last = nullptr;
+
+		for (auto it = std::filesystem::directory_iterator(root); it != std::filesystem::directory_iterator(); it++) {
+			paths.push_back(it->path());
+		}
+
+		std::sort(paths.begin(), paths.end(), [](const std::filesystem::path& lhs, const std::filesystem::path& rhs) {
+			return strtoull(lhs.filename().string().c_str() + 4, nullptr, 10) < strtoull(rhs.filename().string().c_str() + 4, nullptr, 10);
+		});
+
+		memset(&garbage, 0xA5, sizeof(TrackWALRecord));
+		last = fopen(paths.back().string().c_str(), "ab");
+		fwrite(&garbage, sizeof(TrackWALRecord), 1, last);
+		fwrite(&garbage, sizeof(TrackWALRecord) / 2, 1, last);
+		fclose(last);
+	}
+
+	{
+		TrackWAL wal;
+		size_t replayed = 0;
+		double sink = 0.0;
+
+		auto t0 = std::chrono::steady_clock::now();
+		bool okay = wal.open(root);
+		auto t1 = std::chrono::steady_clock::now();
+
+		if ((!okay) || (wal.next_lsn() != count) || (wal.torn_bytes() != sizeof(TrackWALRecord) * 3 / 2)) {
+			fprintf(stderr, "recovery failed: next lsn %llu of %zu, %zu bytes torn\n", (unsigned long long)(wal.next_lsn()), count, wal.torn_bytes());
+			return 1;
+		}
+
+		printf("recovery:         %8.2f ms, %zu records validated in the tail segment, %zu bytes torn\n",
+			std::chrono::duration<double, std::milli>(t1 - t0).count(), wal.recovered_records(), wal.torn_bytes());
+
+		auto r0 = std::chrono::steady_clock::now();
+		replayed = wal.replay(count - 3600, [&sink](const TrackWALRecord& r) { sink += r.x; });
+		auto r1 = std::chrono::steady_clock::now();
+
+		printf("replay last hour: %8.2f ms, %zu records (checksum %g)\n",
+			std::chrono::duration<double, std::milli>(r1 - r0).count(), replayed, sink);
+
+		wal.append(0, 0, 0.0, 0.0, 0.0);
+		wal.close();
+	}
+
+	{ // a quiet stream is committed by the timer, and segments of other versions are rejected
+		TrackWAL wal;
+		uint32_t version = track_wal_version + 1U;
+		FILE* first = nullptr;
+		bool okay = false;
+
+		std::filesystem::remove_all(root, ec);
+		std::filesystem::create_directories(root, ec);
+
+		wal.open(root);
+		wal.append(0, 0, 0.0, 0.0, 14.0);
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+		okay = wal.tick() && (wal.durable_lsn() == 1U);
+		wal.close();
+
+		first = fopen((root + "/wal-0.log").c_str(), "r+b");
+		fseek(first, long(offsetof(TrackWALSegmentHeader, version)), SEEK_SET);
+		fwrite(&version, sizeof(uint32_t), 1, first);
+		fclose(first);
+
+		if ((!okay) || wal.open(root) || (std::filesystem::file_size(root + "/wal-0.log", ec) != sizeof(TrackWALSegmentHeader) + sizeof(TrackWALRecord))) {
+			fprintf(stderr, "the quiet group is not committed, or the segment of version %u is accepted or touched\n", version);
+			return 1;
+		}
+	}
+
+	std::filesystem::remove_all(root, ec);
+
+	return 0;
+}
+#endif
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+namespace WarGrey::DTPM {
+	struct TrackWALSegmentHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t first_lsn;
+	};
+
+	/**
+	 * `crc` is the CRC-32C of the rest of the record, `lsn`s are consecutive across segments.
+	 */
+	struct TrackWALRecord {
+		uint32_t crc;
+		uint32_t stream;
+		uint64_t lsn;
+		int64_t timepoint;
+		double x;
+		double y;
+		double depth;
+	};
+
+	/**
+	 * CRC-32C, pass the CRC of the preceding bytes as `prefix_crc` to go on over discontiguous pieces.
+	 */
+	uint32_t track_wal_crc(const void* src, size_t size, uint32_t prefix_crc = 0U);
+
+	/**
+	 * The write-ahead log of live track recording, append-only segments of `segment_bytes` in `root`,
+	 *   named `wal-<sequence>.log`, each is a header followed by fixed-size records.
+	 *
+	 * Appended records are buffered and written with one fsync as a group,
+	 *   once `group_bytes` have been buffered, or `group_period` has passed since the last commit,
+	 *   so that a power loss costs at most a group, rather than costing an fsync per sample.
+	 *
+	 * Segments of other versions make `open()` fail, they are left for the version that wrote them.
+	 *
+	 * Only the last segment could have been torn, segments before it are sealed after their last fsync;
+	 * on opening, the last segment is mapped and validated record by record (the CRC and the LSN),
+	 *   the log is truncated right after the last valid record, and appending goes on from there.
+	 */
+	class TrackWAL {
+	public:
+		virtual ~TrackWAL() noexcept;
+		TrackWAL(size_t segment_bytes = 64U * 1024U * 1024U, size_t group_bytes = 256U * 1024U, uint32_t group_period_ms = 200U);
+
+	public:
+		bool open(const std::string& root);
+		bool commit(); // writes and fsyncs the group in buffer
+		void close();
+
+	public:
+		bool append(uint32_t stream, int64_t timepoint, double x, double y, double depth);
+
+		/**
+		 * commits the group once `group_period` has passed, `append()` only checks the deadline when a sample arrives,
+		 *   so the owner should call it from its timer (say, `update()` of the planet), or a quiet stream holds its last group.
+		 */
+		bool tick();
+
+		/**
+		 * removes sealed segments whose records are all before `lsn`, once they are in the track store.
+		 */
+		size_t checkpoint(uint64_t lsn);
+
+		/**
+		 * applies `f(const TrackWALRecord&)` to committed records from `lsn` on, in order.
+		 */
+		template<typename F>
+		size_t replay(uint64_t lsn, F f) {
+			size_t n = 0;
+
+			for (size_t idx = 0; idx < this->segments.size(); idx++) {
+				if ((idx + 1 == this->segments.size()) || (this->segments[idx + 1].first_lsn > lsn)) {
+					size_t count = 0;
+					const TrackWALRecord* records = this->map_segment(idx, &count);
+
+					// LSNs are consecutive in a segment
+					size_t r = ((lsn > this->segments[idx].first_lsn) ? size_t(lsn - this->segments[idx].first_lsn) : 0U);
+
+					for (; r < count; r++) {
+						f(records[r]);
+						n++;
+					}
+
+					this->unmap_segment();
+				}
+			}
+
+			return n;
+		}
+
+	public:
+		uint64_t next_lsn();
+		uint64_t durable_lsn(); // records before it have been fsynced
+		size_t segment_count();
+		size_t recovered_records(); // valid records in the last segment, found on opening
+		size_t torn_bytes();        // truncated on opening
+		size_t syncs();
+
+	private:
+		struct Segment {
+			uint64_t sequence;
+			uint64_t first_lsn;
+		};
+
+	private:
+		std::string segment_path(uint64_t sequence);
+		bool recover(const Segment& last, uint64_t* next, size_t* valid_bytes);
+		bool roll();
+		const WarGrey::DTPM::TrackWALRecord* map_segment(size_t idx, size_t* count);
+		void unmap_segment();
+
+	private:
+		std::string root;
+		std::vector<Segment> segments;
+		FILE* tail;
+		size_t tail_bytes;
+		uint64_t lsn;
+		uint64_t durable;
+
+	private:
+		uint8_t* buffer;
+		size_t buffered;
+		size_t segment_bytes;
+		size_t group_bytes;
+		std::chrono::milliseconds group_period;
+		std::chrono::steady_clock::time_point last_commit;
+
+	private:
+		void* view;
+		size_t extent;
+		size_t recovered;
+		size_t torn;
+		size_t sync_count;
+	};
+}
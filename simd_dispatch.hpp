@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * AVX2 kernels are built into every x64 build of MSVC, whatever `/arch` is, MSVC accepts intrinsics of any instruction set,
+ *   and run only if `simd_avx2_supported()` says so, the shipped build targets the baseline x64 and cannot assume AVX2;
+ *   GCC and Clang need the whole translation unit to target AVX2 (`-mavx2`, `-march=haswell`), or there is no AVX2 kernel.
+ *
+ * AVX2 comes with Intel Haswell (2013) and AMD Excavator (2015) and later.
+ */
+#if defined(__AVX2__) || (defined(_MSC_VER) && defined(_M_X64) && !defined(_M_ARM64EC))
+#include <immintrin.h>
+#define SIMD_AVX2
+#endif
+
+#if defined(_MSC_VER) && !defined(__AVX2__) && defined(SIMD_AVX2)
+#include <intrin.h>
+#endif
+
+namespace WarGrey::DTPM {
+	inline bool simd_avx2_supported() {
+#if defined(__AVX2__)
+		return true;
+#elif defined(SIMD_AVX2)
+		static const bool supported = []() {
+			int info[4];
+			bool okay = false;
+
+			__cpuid(info, 0);
+
+			if (info[0] >= 7) {
+				__cpuid(info, 1);
+
+				// OSXSAVE and AVX, and the OS saves YMM registers on context switches
+				if (((info[2] & (1 << 27)) != 0) && ((info[2] & (1 << 28)) != 0) && ((_xgetbv(0) & 0x6U) == 0x6U)) {
+					__cpuidex(info, 7, 0);
+					okay = ((info[1] & (1 << 5)) != 0);
+				}
+			}
+
+			return okay;
+		}();
+
+		return supported;
+#else
+		return false;
+#endif
+	}
+}
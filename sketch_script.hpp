@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+
+namespace WarGrey::DTPM {
+	enum class SketchStep { Move, Jump, MoveTo, JumpBack, Drift };
+
+	/**
+	 * `args` are steps, x to the right and y to the bottom as the screen,
+	 *   `Move` and `Jump` take (dx, dy), `Drift` takes all of them as `Turtle::drift()` does, the others take none;
+	 *   `x` and `y` are where the turtle stands after the stroke, relative to the home.
+	 */
+	template<typename E>
+	struct SketchStroke {
+		WarGrey::DTPM::SketchStep step = WarGrey::DTPM::SketchStep::Move;
+		float args[6] = {};
+		E anchor = E::_;
+		float x = 0.0F;
+		float y = 0.0F;
+	};
+
+	/**
+	 * A turtle script evaluated at compile time into a static table of strokes with positions and anchors resolved,
+	 *   sketches are written once in a `constexpr` initializer and replayed into the `Turtle` by `sketch_replay()`,
+	 *   so that the geometry could be checked by `static_assert` before the planet is ever loaded.
+	 *
+	 * `N` is the capacity, overflowing strokes are dropped and make `okay()` false.
+	 */
+	template<typename E, size_t N>
+	class SketchScript {
+	public:
+		constexpr SketchScript(E home = E::_) : strokes(), count(0), home(home), overflow(false), cx(0.0F), cy(0.0F) {}
+
+	public:
+		constexpr SketchScript& move(float dx, float dy, E a = E::_) {
+			return this->push(WarGrey::DTPM::SketchStep::Move, dx, dy, a, this->cx + dx, this->cy + dy);
+		}
+
+		constexpr SketchScript& jump(float dx, float dy, E a = E::_) {
+			return this->push(WarGrey::DTPM::SketchStep::Jump, dx, dy, a, this->cx + dx, this->cy + dy);
+		}
+
+		constexpr SketchScript& move_to(E a) {
+			return this->push(WarGrey::DTPM::SketchStep::MoveTo, 0.0F, 0.0F, a, this->x(a), this->y(a));
+		}
+
+		constexpr SketchScript& jump_back(E a) {
+			return this->push(WarGrey::DTPM::SketchStep::JumpBack, 0.0F, 0.0F, a, this->x(a), this->y(a));
+		}
+
+		constexpr SketchScript& drift(float dx, float dy, float c1x, float c1y, float c2x, float c2y) {
+			this->push(WarGrey::DTPM::SketchStep::Drift, dx, dy, E::_, this->cx + dx, this->cy + dy);
+
+			if (!this->overflow) {
+				auto& s = this->strokes[this->count - 1];
+
+				s.args[2] = c1x;
+				s.args[3] = c1y;
+				s.args[4] = c2x;
+				s.args[5] = c2y;
+			}
+
+			return (*this);
+		}
+
+	public:
+		constexpr float x(E a) const { return this->locate(a, true); }
+		constexpr float y(E a) const { return this->locate(a, false); }
+		constexpr E home_anchor() const { return this->home; }
+		constexpr size_t size() const { return this->count; }
+		constexpr bool okay() const { return !this->overflow; }
+		constexpr const WarGrey::DTPM::SketchStroke<E>& operator[](size_t idx) const { return this->strokes[idx]; }
+
+	private:
+		constexpr SketchScript& push(WarGrey::DTPM::SketchStep step, float dx, float dy, E a, float px, float py) {
+			if (this->count < N) {
+				auto& s = this->strokes[this->count++];
+
+				s.step = step;
+				s.args[0] = dx;
+				s.args[1] = dy;
+				s.anchor = a;
+				s.x = px;
+				s.y = py;
+			} else {
+				this->overflow = true;
+			}
+
+			this->cx = px;
+			this->cy = py;
+
+			return (*this);
+		}
+
+		constexpr float locate(E a, bool horizontal) const {
+			float pos = 0.0F; // the home, or an unknown anchor
+
+			for (size_t idx = this->count; idx > 0; idx--) {
+				if (this->strokes[idx - 1].anchor == a) {
+					pos = (horizontal ? this->strokes[idx - 1].x : this->strokes[idx - 1].y);
+					break;
+				}
+			}
+
+			return pos;
+		}
+
+	private:
+		WarGrey::DTPM::SketchStroke<E> strokes[N];
+		size_t count;
+		E home;
+		bool overflow;
+		float cx;
+		float cy;
+	};
+
+	/**
+	 * Feeds the strokes to whatever has the interface of `Turtle<E>`, the turtle should be homed at `script.home_anchor()`.
+	 */
+	template<typename T, typename E, size_t N>
+	T* sketch_replay(T* turtle, const WarGrey::DTPM::SketchScript<E, N>& script) {
+		for (size_t idx = 0; idx < script.size(); idx++) {
+			const WarGrey::DTPM::SketchStroke<E>& s = script[idx];
+			float dx = s.args[0];
+			float dy = s.args[1];
+
+			switch (s.step) {
+			case WarGrey::DTPM::SketchStep::MoveTo: turtle->move_to(s.anchor); break;
+			case WarGrey::DTPM::SketchStep::JumpBack: turtle->jump_back(s.anchor); break;
+			case WarGrey::DTPM::SketchStep::Drift: turtle->drift(dx, dy, s.args[2], s.args[3], s.args[4], s.args[5]); break;
+			case WarGrey::DTPM::SketchStep::Move: {
+				if (dx == 0.0F) {
+					if (dy > 0.0F) { turtle->move_down(dy, s.anchor); } else { turtle->move_up(-dy, s.anchor); }
+				} else if (dy == 0.0F) {
+					if (dx > 0.0F) { turtle->move_right(dx, s.anchor); } else { turtle->move_left(-dx, s.anchor); }
+				} else if (dx > 0.0F) {
+					if (dy > 0.0F) { turtle->move_right_down(dx, dy, s.anchor); } else { turtle->move_right_up(dx, -dy, s.anchor); }
+				} else {
+					if (dy > 0.0F) { turtle->move_left_down(-dx, dy, s.anchor); } else { turtle->move_left_up(-dx, -dy, s.anchor); }
+				}
+			}; break;
+			case WarGrey::DTPM::SketchStep::Jump: {
+				if (dx == 0.0F) {
+					if (dy > 0.0F) { turtle->jump_down(dy, s.anchor); } else { turtle->jump_up(-dy, s.anchor); }
+				} else if (dy == 0.0F) {
+					if (dx > 0.0F) { turtle->jump_right(dx, s.anchor); } else { turtle->jump_left(-dx, s.anchor); }
+				} else if (dx > 0.0F) {
+					if (dy > 0.0F) { turtle->jump_right_down(dx, dy, s.anchor); } else { turtle->jump_right_up(dx, -dy, s.anchor); }
+				} else {
+					if (dy > 0.0F) { turtle->jump_left_down(-dx, dy, s.anchor); } else { turtle->jump_left_up(-dx, -dy, s.anchor); }
+				}
+			}; break;
+			}
+		}
+
+		return turtle;
+	}
+}